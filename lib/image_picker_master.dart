@@ -6,13 +6,19 @@ import 'image_picker_master_platform_interface.dart';
 // Conditional imports for web platform
 import 'image_picker_master_web_stub.dart'
     if (dart.library.html) 'image_picker_master_web.dart';
+import 'src/tools/file_detail.dart';
 import 'src/tools/file_picker_options.dart';
 import 'src/tools/file_type.dart';
+import 'src/tools/jpeg_encode_options.dart';
 import 'src/tools/picked_file.dart';
+import 'src/tools/probed_image.dart';
 
+export 'src/tools/file_detail.dart';
 export 'src/tools/file_picker_options.dart';
 export 'src/tools/file_type.dart';
+export 'src/tools/jpeg_encode_options.dart';
 export 'src/tools/picked_file.dart';
+export 'src/tools/probed_image.dart';
 
 /// A powerful and versatile file picker plugin for Flutter that supports
 /// multiple file types including images, videos, audio files, and documents
@@ -58,6 +64,24 @@ class ImagePickerMaster {
   /// [withData] includes file bytes in the result when set to true.
   /// [allowCompression] enables image compression for image files.
   /// [compressionQuality] sets the compression quality (0-100) when compression is enabled.
+  /// [compressionFormat] encodes compressed copies as `'jpeg'` (default),
+  /// `'webp_lossy'` or `'webp_lossless'`. WebP keeps transparency. Honoured
+  /// on Linux when built with libwebp; elsewhere copies stay JPEG.
+  /// [jpegOptions] makes JPEG copies progressive, fits their Huffman tables
+  /// or fixes their chroma subsampling (see [JpegEncodeOptions]).
+  /// [maxBytes] caps each picked image's size in bytes. Images over it are
+  /// compressed (even without [allowCompression]) at the highest quality,
+  /// down to 40, that fits, and scaled down only if that is not enough.
+  /// An image that does not fit even at 64 px is returned as picked, with
+  /// its own size. The search runs natively on in-memory encodes. Honoured
+  /// on Linux.
+  /// [maxWidth], [maxHeight] and [maxPixels] bound each picked image's
+  /// upright dimensions. Larger images are decoded at a reduced size,
+  /// resampled to fit with their aspect ratio kept, and compressed (even
+  /// without [allowCompression]). Honoured on Linux.
+  /// [lazyMetadata] returns only paths and names, without touching the files;
+  /// fetch the rest with [getFileDetails]. Compression and [withData] are
+  /// skipped in this mode. Honoured on Linux; other platforms ignore it.
   ///
   /// Returns a list of [PickedFile] objects or null if no files were selected.
   ///
@@ -77,6 +101,13 @@ class ImagePickerMaster {
     bool withData = false,
     bool allowCompression = false,
     int? compressionQuality,
+    String compressionFormat = 'jpeg',
+    JpegEncodeOptions? jpegOptions,
+    int? maxBytes,
+    int? maxWidth,
+    int? maxHeight,
+    int? maxPixels,
+    bool lazyMetadata = false,
   }) async {
     final options = FilePickerOptions(
       type: type,
@@ -85,11 +116,66 @@ class ImagePickerMaster {
       withData: withData,
       allowCompression: allowCompression,
       compressionQuality: compressionQuality,
+      compressionFormat: compressionFormat,
+      jpegOptions: jpegOptions,
+      maxBytes: maxBytes,
+      maxWidth: maxWidth,
+      maxHeight: maxHeight,
+      maxPixels: maxPixels,
+      lazyMetadata: lazyMetadata,
     );
 
     return ImagePickerMasterPlatform.instance.pickFiles(options);
   }
 
+  /// Picks files like [pickFiles], but delivers each [PickedFile] as soon as
+  /// its processing (compression, reading bytes) has finished.
+  ///
+  /// With large selections the first file arrives after roughly one file's
+  /// worth of work instead of after the whole batch. Files are emitted in
+  /// completion order, not selection order, and the stream closes once every
+  /// file has been delivered. Cancelling the dialog yields an empty stream.
+  ///
+  /// Streams natively on Linux; other platforms emit the [pickFiles] result.
+  ///
+  /// Example:
+  /// ```dart
+  /// ImagePickerMaster.instance
+  ///     .pickFilesStream(type: FileType.image, allowMultiple: true)
+  ///     .listen((file) => print('Ready: ${file.name}'));
+  /// ```
+  Stream<PickedFile> pickFilesStream({
+    FileType type = FileType.all,
+    bool allowMultiple = false,
+    List<String>? allowedExtensions,
+    bool withData = false,
+    bool allowCompression = false,
+    int? compressionQuality,
+    String compressionFormat = 'jpeg',
+    JpegEncodeOptions? jpegOptions,
+    int? maxBytes,
+    int? maxWidth,
+    int? maxHeight,
+    int? maxPixels,
+  }) {
+    final options = FilePickerOptions(
+      type: type,
+      allowMultiple: allowMultiple,
+      allowedExtensions: allowedExtensions,
+      withData: withData,
+      allowCompression: allowCompression,
+      compressionQuality: compressionQuality,
+      compressionFormat: compressionFormat,
+      jpegOptions: jpegOptions,
+      maxBytes: maxBytes,
+      maxWidth: maxWidth,
+      maxHeight: maxHeight,
+      maxPixels: maxPixels,
+    );
+
+    return ImagePickerMasterPlatform.instance.pickFilesStream(options);
+  }
+
   /// Picks a single image file from the device storage.
   ///
   /// [allowCompression] enables image compression (default: true).
@@ -333,6 +419,81 @@ class ImagePickerMaster {
     );
   }
 
+  /// Computes [fields] for each of [paths] in one batched native call.
+  ///
+  /// Pair it with `pickFiles(lazyMetadata: true)` to show a selection at
+  /// once and fill in sizes, MIME types or image dimensions afterwards, only
+  /// for the files and details the app needs. Returns one [PickedFile] per
+  /// path, in order; details that cannot be determined are left null (size
+  /// 0). Currently implemented on Linux.
+  ///
+  /// Example:
+  /// ```dart
+  /// final files = await ImagePickerMaster.instance.pickFiles(
+  ///   allowMultiple: true,
+  ///   lazyMetadata: true,
+  /// );
+  /// final details = await ImagePickerMaster.instance.getFileDetails(
+  ///   [for (final f in files!) f.path],
+  ///   fields: {FileDetail.size, FileDetail.dimensions},
+  /// );
+  /// ```
+  Future<List<PickedFile>> getFileDetails(
+    List<String> paths, {
+    Set<FileDetail> fields = const {FileDetail.size, FileDetail.mimeType},
+  }) {
+    return ImagePickerMasterPlatform.instance.getFileDetails(
+      paths,
+      fields: fields,
+    );
+  }
+
+  /// Reads the width, height, format and alpha of each image in [paths]
+  /// from its header, without decoding it.
+  ///
+  /// A probe reads a few KB per file, so it takes microseconds even for a
+  /// 50 MP photo and suits filling in a gallery grid. Returns one entry per
+  /// path, in order, with `null` for files that are not readable images.
+  /// Dimensions are as stored, before any EXIF orientation. Currently
+  /// implemented on Linux.
+  ///
+  /// Example:
+  /// ```dart
+  /// final probes = await ImagePickerMaster.instance.probeImages(paths);
+  /// for (final image in probes.nonNulls) {
+  ///   print('${image.path}: ${image.width}x${image.height} ${image.format}');
+  /// }
+  /// ```
+  Future<List<ProbedImage?>> probeImages(List<String> paths) {
+    return ImagePickerMasterPlatform.instance.probeImages(paths);
+  }
+
+  /// Reads the file at [path] as a stream of chunks of at most [chunkSize]
+  /// bytes (default 4 MiB).
+  ///
+  /// Use this instead of `withData` for files too large to hold as one
+  /// `Uint8List`, such as long videos. Reads run ahead of the listener by
+  /// only a few chunks, so memory stays bounded regardless of file size, and
+  /// pausing the subscription pauses the reads. Cancelling it closes the
+  /// file. Currently implemented on Linux.
+  ///
+  /// Example:
+  /// ```dart
+  /// final file = await ImagePickerMaster.instance.pickVideo();
+  /// if (file != null) {
+  ///   await for (final chunk
+  ///       in ImagePickerMaster.instance.readFileStream(file.path)) {
+  ///     upload.add(chunk);
+  ///   }
+  /// }
+  /// ```
+  Stream<Uint8List> readFileStream(String path, {int chunkSize = 4 << 20}) {
+    return ImagePickerMasterPlatform.instance.readFileStream(
+      path,
+      chunkSize: chunkSize,
+    );
+  }
+
   /// Captures a photo using the device camera.
   ///
   /// Opens the camera interface and allows the user to take a photo.
@@ -341,6 +502,9 @@ class ImagePickerMaster {
   /// [allowCompression] enables image compression (default: true).
   /// [compressionQuality] sets the compression quality from 0-100 (default: 80).
   /// [withData] includes file bytes in the result when set to true.
+  /// [maxBytes] caps the photo's size in bytes, and [maxWidth], [maxHeight]
+  /// and [maxPixels] its dimensions, as in [pickFiles] (honoured on Linux).
+  /// [jpegOptions] sets the photo's JPEG encoding, as in [pickFiles].
   ///
   /// Returns a [PickedFile] object or null if no photo was captured.
   ///
@@ -361,11 +525,21 @@ class ImagePickerMaster {
     bool allowCompression = true,
     int compressionQuality = 80,
     bool withData = false,
+    int? maxBytes,
+    int? maxWidth,
+    int? maxHeight,
+    int? maxPixels,
+    JpegEncodeOptions? jpegOptions,
   }) async {
     return ImagePickerMasterPlatform.instance.capturePhoto(
       allowCompression: allowCompression,
       compressionQuality: compressionQuality,
       withData: withData,
+      maxBytes: maxBytes,
+      maxWidth: maxWidth,
+      maxHeight: maxHeight,
+      maxPixels: maxPixels,
+      jpegOptions: jpegOptions,
     );
   }
 
@@ -422,6 +596,49 @@ class ImagePickerMaster {
     );
   }
 
+  /// Like [resizeImageForCropper], but shows something almost at once.
+  ///
+  /// On Linux the stream first emits a small preview — the thumbnail most
+  /// cameras embed in the JPEG's EXIF block, or a 1/8-scale decode when
+  /// there is none — typically within a couple of milliseconds, and then
+  /// the full [maxSize] preview. Images without a cheap first frame (and
+  /// images that already fit within [maxSize]) emit a single path. Other
+  /// platforms emit only the full preview.
+  ///
+  /// Example:
+  /// ```dart
+  /// ImagePickerMaster.instance
+  ///     .resizeImageForCropperTiered(path: pickedFile.path)
+  ///     .listen((previewPath) => setState(() => _preview = previewPath));
+  /// ```
+  Stream<String> resizeImageForCropperTiered({
+    required String path,
+    int maxSize = 1024,
+  }) {
+    return ImagePickerMasterPlatform.instance.resizeImageForCropperTiered(
+      path: path,
+      maxSize: maxSize,
+    );
+  }
+
+  /// Releases what the plugin keeps in memory for [path] between
+  /// [resizeImageForCropper] and [cropImageNative].
+  ///
+  /// On Linux the photo decoded for the cropper preview is kept so that
+  /// the crop does not decode it again. Call this when the cropper for
+  /// [path] is closed; entries are also evicted automatically under memory
+  /// pressure. Returns `true` if anything was released. Other platforms
+  /// keep no such state and return `false`.
+  ///
+  /// Example:
+  /// ```dart
+  /// final cropped = await ImagePickerMaster.instance.cropImageNative(...);
+  /// await ImagePickerMaster.instance.releaseImageSession(pickedFile.path);
+  /// ```
+  Future<bool> releaseImageSession(String path) {
+    return ImagePickerMasterPlatform.instance.releaseImageSession(path);
+  }
+
   /// Crops an image natively without going through a Dart isolate.
   ///
   /// All decode → rotate → crop → encode work runs on a native background
@@ -432,6 +649,8 @@ class ImagePickerMaster {
   /// [cropW]/[cropH] size of the crop rect in container coordinates.
   /// [containerW]/[containerH] size of the Flutter widget that displayed the image.
   /// [rotation] clockwise degrees applied before cropping (0, 90, 180, 270).
+  /// On Linux the EXIF orientation is applied before [rotation], so the
+  /// crop rect refers to the image as Flutter displays it.
   /// [quality] JPEG/WebP encode quality 0–100 (default 85, ignored for PNG).
   /// [format] output format:
   ///   - `"jpeg"` — smallest file, lossy (default)
@@ -439,6 +658,18 @@ class ImagePickerMaster {
   ///   - `"webp_lossy"` — better compression than JPEG, lossy
   ///   - `"webp_lossless"` — lossless WebP
   /// [maxSize] max edge length used when decoding the source (default 1200).
+  /// [effort] WebP encoder effort from 0 (fastest) to 6 (smallest file),
+  /// default 4; ignored for JPEG and PNG. Linux encodes WebP with libwebp
+  /// when the plugin is built against it, and falls back to JPEG otherwise.
+  /// [maxBytes] caps the output size in bytes: [quality] is lowered (to no
+  /// less than 40), then the crop is scaled down, looking for the largest
+  /// encode that fits. PNG and lossless WebP only scale down. When nothing
+  /// fits, even at 64 px, the crop fails and `null` is returned. Honoured
+  /// on Linux.
+  /// [jpegOptions] sets progressive output, fitted Huffman tables and the
+  /// chroma subsampling of JPEG crops (see [JpegEncodeOptions]). A crop
+  /// that moves DCT blocks instead of decoding keeps the source's
+  /// subsampling, so naming one here forces a re-encode.
   ///
   /// Returns the absolute path of the cropped file, or `null` on failure.
   ///
@@ -466,6 +697,9 @@ class ImagePickerMaster {
     int quality = 85,
     String format = 'jpeg',
     int maxSize = 1200,
+    int effort = 4,
+    int? maxBytes,
+    JpegEncodeOptions? jpegOptions,
   }) {
     return ImagePickerMasterPlatform.instance.cropImageNative(
       path: path,
@@ -479,6 +713,9 @@ class ImagePickerMaster {
       quality: quality,
       format: format,
       maxSize: maxSize,
+      effort: effort,
+      maxBytes: maxBytes,
+      jpegOptions: jpegOptions,
     );
   }
 }
@@ -3,8 +3,11 @@ import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 
 import 'image_picker_master_platform_interface.dart';
+import 'src/tools/file_detail.dart';
 import 'src/tools/file_picker_options.dart';
+import 'src/tools/jpeg_encode_options.dart';
 import 'src/tools/picked_file.dart';
+import 'src/tools/probed_image.dart';
 
 /// An implementation of [ImagePickerMasterPlatform] that uses method channels.
 ///
@@ -15,6 +18,12 @@ class MethodChannelImagePickerMaster extends ImagePickerMasterPlatform {
   @visibleForTesting
   final methodChannel = const MethodChannel('image_picker_master');
 
+  /// The event channel used by [pickFilesStream] on Linux.
+  @visibleForTesting
+  final pickFilesStreamChannel = const EventChannel(
+    'image_picker_master/pick_files_stream',
+  );
+
   @override
   Future<String?> getPlatformVersion() async {
     final version = await methodChannel.invokeMethod<String>(
@@ -44,11 +53,105 @@ class MethodChannelImagePickerMaster extends ImagePickerMasterPlatform {
     }
   }
 
+  @override
+  Stream<PickedFile> pickFilesStream(FilePickerOptions options) {
+    // Only the Linux plugin streams natively; elsewhere fall back to
+    // emitting the pickFiles result.
+    if (kIsWeb || defaultTargetPlatform != TargetPlatform.linux) {
+      return super.pickFilesStream(options);
+    }
+
+    return pickFilesStreamChannel
+        .receiveBroadcastStream(options.toMap())
+        .map((event) => Map<String, dynamic>.from(event as Map))
+        .takeWhile((event) => event['type'] != 'done')
+        .map(
+          (event) => PickedFile.fromMap(
+            Map<String, dynamic>.from(event['file'] as Map),
+          ),
+        );
+  }
+
+  @override
+  Future<List<PickedFile>> getFileDetails(
+    List<String> paths, {
+    Set<FileDetail> fields = const {FileDetail.size, FileDetail.mimeType},
+  }) async {
+    // Only the Linux plugin supports lazy picks and batched details.
+    if (kIsWeb || defaultTargetPlatform != TargetPlatform.linux) {
+      return super.getFileDetails(paths, fields: fields);
+    }
+    final result = await methodChannel.invokeListMethod<dynamic>(
+      'getFileDetails',
+      {'paths': paths, 'fields': fields.map((f) => f.name).toList()},
+    );
+    return (result ?? const [])
+        .map(
+          (file) => PickedFile.fromMap(Map<String, dynamic>.from(file as Map)),
+        )
+        .toList();
+  }
+
+  @override
+  Future<List<ProbedImage?>> probeImages(List<String> paths) async {
+    // Only the Linux plugin has a native header probe.
+    if (kIsWeb || defaultTargetPlatform != TargetPlatform.linux) {
+      return super.probeImages(paths);
+    }
+    final result = await methodChannel.invokeListMethod<dynamic>(
+      'probeImages',
+      {'paths': paths},
+    );
+    return (result ?? const [])
+        .map(
+          (image) =>
+              ProbedImage.fromMap(Map<String, dynamic>.from(image as Map)),
+        )
+        .toList();
+  }
+
+  @override
+  Stream<Uint8List> readFileStream(
+    String path, {
+    int chunkSize = 4 << 20,
+  }) async* {
+    // Only the Linux plugin streams file contents natively.
+    if (kIsWeb || defaultTargetPlatform != TargetPlatform.linux) {
+      yield* super.readFileStream(path, chunkSize: chunkSize);
+      return;
+    }
+
+    final stream = await methodChannel.invokeMapMethod<String, dynamic>(
+      'openFileStream',
+      {'path': path, 'chunkSize': chunkSize},
+    );
+    if (stream == null) return;
+
+    final id = stream['id'] as int;
+    final chunks = EventChannel(
+      'image_picker_master/file_stream/$id',
+    ).receiveBroadcastStream();
+    await for (final chunk in chunks) {
+      // yield returns once the listener has taken the chunk (and waits while
+      // it is paused), so the ack is what lets the native side read further.
+      yield chunk as Uint8List;
+      methodChannel.invokeMethod<void>('ackFileStream', {
+        'id': id,
+        'count': 1,
+      }).ignore();
+    }
+  }
+
   @override
   Future<PickedFile?> capturePhoto({
     required bool allowCompression,
     required int compressionQuality,
     required bool withData,
+    int? maxBytes,
+    int? maxWidth,
+    int? maxHeight,
+    int? maxPixels,
+    JpegEncodeOptions? jpegOptions,
   }) async {
     try {
       final result = await methodChannel
@@ -56,6 +159,11 @@ class MethodChannelImagePickerMaster extends ImagePickerMasterPlatform {
             'allowCompression': allowCompression,
             'compressionQuality': compressionQuality,
             'withData': withData,
+            'maxBytes': maxBytes,
+            'maxWidth': maxWidth,
+            'maxHeight': maxHeight,
+            'maxPixels': maxPixels,
+            'jpegOptions': jpegOptions?.toMap(),
           });
 
       if (result == null) return null;
@@ -92,6 +200,54 @@ class MethodChannelImagePickerMaster extends ImagePickerMasterPlatform {
     }
   }
 
+  @override
+  Stream<String> resizeImageForCropperTiered({
+    required String path,
+    int maxSize = 1024,
+  }) async* {
+    // Only the Linux plugin has a thumbnail tier.
+    if (kIsWeb || defaultTargetPlatform != TargetPlatform.linux) {
+      yield* super.resizeImageForCropperTiered(path: path, maxSize: maxSize);
+      return;
+    }
+
+    // The plugin's worker pool is FIFO, so the thumbnail request goes out
+    // first and the full decode right behind it, running while the
+    // thumbnail is produced rather than ahead of it.
+    final thumbnail = methodChannel.invokeMethod<String>(
+      'resizeImageForCropper',
+      {'path': path, 'maxSize': maxSize, 'tier': 'thumbnail'},
+    );
+    final full = resizeImageForCropper(path: path, maxSize: maxSize);
+    String? quick;
+    try {
+      quick = await thumbnail;
+    } on PlatformException {
+      quick = null;
+    }
+    if (quick != null) yield quick;
+
+    final preview = await full;
+    if (preview != null && preview != quick) yield preview;
+  }
+
+  @override
+  Future<bool> releaseImageSession(String path) async {
+    // Only the Linux plugin keeps decoded images between calls.
+    if (kIsWeb || defaultTargetPlatform != TargetPlatform.linux) {
+      return super.releaseImageSession(path);
+    }
+    try {
+      final released = await methodChannel.invokeMethod<bool>(
+        'releaseImageSession',
+        {'path': path},
+      );
+      return released ?? false;
+    } on PlatformException {
+      return false;
+    }
+  }
+
   @override
   Future<String?> cropImageNative({
     required String path,
@@ -105,6 +261,9 @@ class MethodChannelImagePickerMaster extends ImagePickerMasterPlatform {
     int quality = 85,
     String format = 'jpeg',
     int maxSize = 1200,
+    int effort = 4,
+    int? maxBytes,
+    JpegEncodeOptions? jpegOptions,
   }) async {
     try {
       return await methodChannel.invokeMethod<String>('cropImageNative', {
@@ -119,6 +278,9 @@ class MethodChannelImagePickerMaster extends ImagePickerMasterPlatform {
         'quality': quality,
         'format': format,
         'maxSize': maxSize,
+        'effort': effort,
+        'maxBytes': maxBytes,
+        'jpegOptions': jpegOptions?.toMap(),
       });
     } on PlatformException {
       return null;
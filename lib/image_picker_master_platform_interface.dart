@@ -1,9 +1,14 @@
 // lib/image_picker_master_platform_interface.dart
+import 'dart:typed_data';
+
 import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 
 import 'image_picker_master_method_channel.dart';
+import 'src/tools/file_detail.dart';
 import 'src/tools/file_picker_options.dart';
+import 'src/tools/jpeg_encode_options.dart';
 import 'src/tools/picked_file.dart';
+import 'src/tools/probed_image.dart';
 
 /// The interface that implementations of image_picker_master must implement.
 ///
@@ -50,14 +55,65 @@ abstract class ImagePickerMasterPlatform extends PlatformInterface {
     throw UnimplementedError('pickFiles() has not been implemented.');
   }
 
+  /// Picks files like [pickFiles] but emits each [PickedFile] as soon as it
+  /// has been processed instead of waiting for the whole selection.
+  ///
+  /// Files are emitted in completion order and the stream closes once every
+  /// selected file has been delivered. The default implementation waits for
+  /// [pickFiles] and then emits its result one file at a time.
+  Stream<PickedFile> pickFilesStream(FilePickerOptions options) {
+    return Stream.fromFuture(
+      pickFiles(options),
+    ).expand((files) => files ?? const <PickedFile>[]);
+  }
+
+  /// Computes the requested [fields] for each of [paths], typically files
+  /// returned by a `lazyMetadata` pick.
+  ///
+  /// Returns one [PickedFile] per path, in order, with path and name set and
+  /// only the requested fields filled in.
+  Future<List<PickedFile>> getFileDetails(
+    List<String> paths, {
+    Set<FileDetail> fields = const {FileDetail.size, FileDetail.mimeType},
+  }) {
+    throw UnimplementedError('getFileDetails() has not been implemented.');
+  }
+
+  /// Reads width, height, format and alpha from the header of each of
+  /// [paths] without decoding any pixels.
+  ///
+  /// Returns one entry per path, in order; `null` where the file is not a
+  /// readable image.
+  Future<List<ProbedImage?>> probeImages(List<String> paths) {
+    throw UnimplementedError('probeImages() has not been implemented.');
+  }
+
+  /// Reads the file at [path] as a stream of chunks of at most [chunkSize]
+  /// bytes, for files too large to return as one `bytes` value.
+  ///
+  /// The native side reads ahead only a few chunks beyond what the listener
+  /// has consumed, so memory stays bounded whatever the file size, and
+  /// pausing the subscription pauses the reads.
+  Stream<Uint8List> readFileStream(String path, {int chunkSize = 4 << 20}) {
+    throw UnimplementedError('readFileStream() has not been implemented.');
+  }
+
   /// Captures a photo using the device camera.
   ///
   /// Platform implementations should override this method to handle
-  /// camera capture on their respective platforms.
+  /// camera capture on their respective platforms. [maxBytes] caps the
+  /// size of the returned image, and [maxWidth], [maxHeight] and
+  /// [maxPixels] its dimensions, and [jpegOptions] its JPEG encoding;
+  /// platforms that cannot honour them ignore them.
   Future<PickedFile?> capturePhoto({
     required bool allowCompression,
     required int compressionQuality,
     required bool withData,
+    int? maxBytes,
+    int? maxWidth,
+    int? maxHeight,
+    int? maxPixels,
+    JpegEncodeOptions? jpegOptions,
   }) {
     throw UnimplementedError('capturePhoto() has not been implemented.');
   }
@@ -79,6 +135,26 @@ abstract class ImagePickerMasterPlatform extends PlatformInterface {
     );
   }
 
+  /// Emits a quick low-resolution preview of [path] first, when one can be
+  /// had cheaply, and then the full [resizeImageForCropper] result.
+  ///
+  /// The default implementation has no quick tier and emits only the full
+  /// preview.
+  Stream<String> resizeImageForCropperTiered({
+    required String path,
+    int maxSize = 1024,
+  }) async* {
+    final preview = await resizeImageForCropper(path: path, maxSize: maxSize);
+    if (preview != null) yield preview;
+  }
+
+  /// Releases native state kept for [path] between [resizeImageForCropper]
+  /// and [cropImageNative], such as the decoded image.
+  ///
+  /// Returns `true` if anything was released. The default implementation
+  /// keeps no such state and returns `false`.
+  Future<bool> releaseImageSession(String path) async => false;
+
   /// Crops an image natively without going through a Dart isolate.
   ///
   /// Uses Android's `BitmapFactory.inSampleSize` / platform-native equivalents
@@ -93,6 +169,11 @@ abstract class ImagePickerMasterPlatform extends PlatformInterface {
   /// [quality] JPEG/WebP encode quality 0–100 (default 85, ignored for PNG).
   /// [format] output format: `"jpeg"` | `"png"` | `"webp_lossy"` | `"webp_lossless"`.
   /// [maxSize] max edge length used when decoding the source (default 1200).
+  /// [effort] WebP encoder effort 0 (fastest) – 6 (smallest), default 4.
+  /// [maxBytes] caps the output size; quality, then dimensions, are
+  /// lowered until the encode fits.
+  /// [jpegOptions] progressive output, Huffman tables and chroma
+  /// subsampling of JPEG crops.
   ///
   /// Returns the absolute path of the cropped file, or `null` on failure.
   Future<String?> cropImageNative({
@@ -107,6 +188,9 @@ abstract class ImagePickerMasterPlatform extends PlatformInterface {
     int quality = 85,
     String format = 'jpeg',
     int maxSize = 1200,
+    int effort = 4,
+    int? maxBytes,
+    JpegEncodeOptions? jpegOptions,
   }) {
     throw UnimplementedError('cropImageNative() has not been implemented.');
   }
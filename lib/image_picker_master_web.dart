@@ -9,6 +9,7 @@ import 'package:web/web.dart' as web;
 
 import 'image_picker_master_platform_interface.dart';
 import 'src/tools/file_picker_options.dart';
+import 'src/tools/jpeg_encode_options.dart';
 import 'src/tools/file_type.dart';
 import 'src/tools/picked_file.dart';
 
@@ -87,6 +88,11 @@ class ImagePickerMasterWeb extends ImagePickerMasterPlatform {
     required bool allowCompression,
     required int compressionQuality,
     required bool withData,
+    int? maxBytes,
+    int? maxWidth,
+    int? maxHeight,
+    int? maxPixels,
+    JpegEncodeOptions? jpegOptions,
   }) async {
     // mediaDevices is non-nullable in package:web but may be unavailable
     web.MediaStream stream;
@@ -238,6 +244,9 @@ class ImagePickerMasterWeb extends ImagePickerMasterPlatform {
     int quality = 85,
     String format = 'jpeg',
     int maxSize = 1200,
+    int effort = 4,
+    int? maxBytes,
+    JpegEncodeOptions? jpegOptions,
   }) async {
     try {
       // ── Step 1: load the source blob URL ─────────────────────────────
@@ -3,6 +3,7 @@
 
 import 'image_picker_master_platform_interface.dart';
 import 'src/tools/file_picker_options.dart';
+import 'src/tools/jpeg_encode_options.dart';
 import 'src/tools/picked_file.dart';
 
 /// A stub implementation of [ImagePickerMasterPlatform] for non-web platforms.
@@ -41,6 +42,11 @@ class ImagePickerMasterWeb extends ImagePickerMasterPlatform {
     required bool allowCompression,
     required int compressionQuality,
     required bool withData,
+    int? maxBytes,
+    int? maxWidth,
+    int? maxHeight,
+    int? maxPixels,
+    JpegEncodeOptions? jpegOptions,
   }) async {
     throw UnsupportedError(
       'Web implementation is not supported on this platform',
@@ -70,6 +76,9 @@ class ImagePickerMasterWeb extends ImagePickerMasterPlatform {
     int quality = 85,
     String format = 'jpeg',
     int maxSize = 1200,
+    int effort = 4,
+    int? maxBytes,
+    JpegEncodeOptions? jpegOptions,
   }) async {
     throw UnsupportedError(
       'Web implementation is not supported on this platform',
@@ -0,0 +1,20 @@
+/// Per-file details that `ImagePickerMaster.getFileDetails` can compute.
+///
+/// Used together with `lazyMetadata` picks, which return only each file's
+/// path and name, so an app pays only for the details it actually shows.
+enum FileDetail {
+  /// File size in bytes (`PickedFile.size`).
+  size,
+
+  /// MIME type guessed from the file name (`PickedFile.mimeType`).
+  mimeType,
+
+  /// Pixel width and height, format and alpha read from the image header
+  /// (`PickedFile.width`, `height`, `format`, `hasAlpha`), plus the EXIF
+  /// `orientation`, `dateTimeOriginal` and thumbnail location of JPEG and
+  /// TIFF files; null for non-images.
+  dimensions,
+
+  /// The whole file contents (`PickedFile.bytes`).
+  bytes,
+}
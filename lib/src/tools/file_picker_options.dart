@@ -1,4 +1,5 @@
 import 'package:image_picker_master/src/tools/file_type.dart';
+import 'package:image_picker_master/src/tools/jpeg_encode_options.dart';
 
 /// Configuration options for file picking operations.
 ///
@@ -24,12 +25,40 @@ class FilePickerOptions {
   /// The compression quality (0-100) when compression is enabled.
   final int? compressionQuality;
 
+  /// Encoding of compressed copies: `'jpeg'`, `'webp_lossy'` or
+  /// `'webp_lossless'`.
+  final String compressionFormat;
+
+  /// Progressive, Huffman and chroma subsampling settings for JPEG copies.
+  /// `null` writes baseline JPEGs with the plugin's defaults.
+  final JpegEncodeOptions? jpegOptions;
+
+  /// Upper bound in bytes for each picked image. Larger images are
+  /// compressed, even without [allowCompression], at the highest quality
+  /// and then the largest size that fits. One that cannot fit even at
+  /// 64 px is returned as picked, so check the picked file's `size`
+  /// against the cap. `null` means no limit.
+  final int? maxBytes;
+
+  /// Upper bounds on each picked image's width, height and pixel count.
+  /// Larger images are scaled down, keeping their aspect ratio, and
+  /// compressed, even without [allowCompression]. `null` means no limit.
+  final int? maxWidth;
+  final int? maxHeight;
+  final int? maxPixels;
+
+  /// Whether to return only each file's path and name, skipping size, MIME
+  /// type, compression and bytes. Fetch those later with `getFileDetails`.
+  final bool lazyMetadata;
+
   /// Creates a new [FilePickerOptions] instance.
   ///
   /// [type] defaults to [FileType.all].
   /// [allowMultiple] defaults to false.
   /// [withData] defaults to false.
   /// [allowCompression] defaults to false.
+  /// [compressionFormat] defaults to `'jpeg'`.
+  /// [lazyMetadata] defaults to false.
   const FilePickerOptions({
     this.type = FileType.all,
     this.allowMultiple = false,
@@ -37,6 +66,13 @@ class FilePickerOptions {
     this.withData = false,
     this.allowCompression = false,
     this.compressionQuality,
+    this.compressionFormat = 'jpeg',
+    this.jpegOptions,
+    this.maxBytes,
+    this.maxWidth,
+    this.maxHeight,
+    this.maxPixels,
+    this.lazyMetadata = false,
   });
 
   /// Converts this options object to a map for platform channel communication.
@@ -48,6 +84,13 @@ class FilePickerOptions {
       'withData': withData,
       'allowCompression': allowCompression,
       'compressionQuality': compressionQuality,
+      'compressionFormat': compressionFormat,
+      'jpegOptions': jpegOptions?.toMap(),
+      'maxBytes': maxBytes,
+      'maxWidth': maxWidth,
+      'maxHeight': maxHeight,
+      'maxPixels': maxPixels,
+      'lazyMetadata': lazyMetadata,
     };
   }
 }
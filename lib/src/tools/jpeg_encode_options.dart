@@ -0,0 +1,47 @@
+/// Resolution of a JPEG's colour (chroma) planes relative to brightness.
+enum ChromaSubsampling {
+  /// Half width and height: the smallest files, and fine for photos.
+  yuv420,
+
+  /// Half width.
+  yuv422,
+
+  /// Full resolution: keeps sharp coloured edges in screenshots and text.
+  yuv444,
+}
+
+/// Encoder settings for the JPEGs the plugin writes: compressed picks,
+/// captured photos and native crops. Quality is set separately.
+///
+/// Honoured on Linux when built with libjpeg-turbo; other platforms and
+/// the gdk-pixbuf fallback write baseline 4:2:0 JPEGs.
+class JpegEncodeOptions {
+  /// Writes the image as several scans, coarse to fine, so a partial
+  /// download already shows all of it. Implies [optimizeHuffman].
+  final bool progressive;
+
+  /// Fits the Huffman tables to each image instead of using the standard
+  /// ones: typically 5–10% smaller, for a slower encode.
+  final bool optimizeHuffman;
+
+  /// Chroma subsampling. `null` leaves it to the plugin: 4:2:0, except that
+  /// a JPEG re-encoded or cropped without decoding keeps its own.
+  final ChromaSubsampling? chromaSubsampling;
+
+  /// Creates a new [JpegEncodeOptions] instance. The defaults match what the
+  /// plugin writes without one.
+  const JpegEncodeOptions({
+    this.progressive = false,
+    this.optimizeHuffman = false,
+    this.chromaSubsampling,
+  });
+
+  /// Converts these options to a map for platform channel communication.
+  Map<String, dynamic> toMap() {
+    return {
+      'progressive': progressive,
+      'optimizeHuffman': optimizeHuffman,
+      'chromaSubsampling': chromaSubsampling?.name,
+    };
+  }
+}
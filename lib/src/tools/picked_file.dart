@@ -20,16 +20,56 @@ class PickedFile {
   /// The bytes of the picked file (only available when withData is true).
   final Uint8List? bytes;
 
+  /// Pixel width of an image, read from its header (null for non-images).
+  final int? width;
+
+  /// Pixel height of an image, read from its header (null for non-images).
+  final int? height;
+
+  /// Image format from the header, e.g. `'jpeg'` or `'png'` (null for
+  /// non-images).
+  final String? format;
+
+  /// Whether the image carries transparency (null for non-images).
+  final bool? hasAlpha;
+
+  /// EXIF orientation, 1–8 (1 when the image has EXIF but no orientation
+  /// tag; null without EXIF). [width] and [height] are the stored size, so
+  /// for 5–8 the image is shown with the two swapped. Linux applies it in
+  /// `resizeImageForCropper` and `cropImageNative`.
+  final int? orientation;
+
+  /// EXIF DateTimeOriginal as written by the camera, `'YYYY:MM:DD HH:MM:SS'`
+  /// in its local time (null when absent).
+  final String? dateTimeOriginal;
+
+  /// Byte offset within the file of the embedded EXIF JPEG thumbnail (null
+  /// when there is none).
+  final int? exifThumbnailOffset;
+
+  /// Length in bytes of the embedded EXIF JPEG thumbnail (null when there is
+  /// none).
+  final int? exifThumbnailLength;
+
   /// Creates a new [PickedFile] instance.
   ///
   /// [path], [name], and [size] are required parameters.
-  /// [mimeType] and [bytes] are optional.
+  /// [mimeType], [bytes], [width], [height], [format], [hasAlpha] and the
+  /// EXIF fields are optional.
   PickedFile({
     required this.path,
     required this.name,
     required this.size,
     this.mimeType,
     this.bytes,
+    this.width,
+    this.height,
+    this.format,
+    this.hasAlpha,
+    this.orientation,
+    this.dateTimeOriginal,
+    this.exifThumbnailOffset,
+    this.exifThumbnailLength,
   });
 
   /// Converts this [PickedFile] to a map representation.
@@ -42,6 +82,14 @@ class PickedFile {
       'size': size,
       'mimeType': mimeType,
       'bytes': bytes,
+      'width': width,
+      'height': height,
+      'format': format,
+      'hasAlpha': hasAlpha,
+      'orientation': orientation,
+      'dateTimeOriginal': dateTimeOriginal,
+      'exifThumbnailOffset': exifThumbnailOffset,
+      'exifThumbnailLength': exifThumbnailLength,
     };
   }
 
@@ -56,6 +104,14 @@ class PickedFile {
       size: map['size'] ?? 0,
       mimeType: map['mimeType'],
       bytes: map['bytes'],
+      width: map['width'],
+      height: map['height'],
+      format: map['format'],
+      hasAlpha: map['hasAlpha'],
+      orientation: map['orientation'],
+      dateTimeOriginal: map['dateTimeOriginal'],
+      exifThumbnailOffset: map['exifThumbnailOffset'],
+      exifThumbnailLength: map['exifThumbnailLength'],
     );
   }
 }
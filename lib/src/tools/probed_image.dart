@@ -0,0 +1,43 @@
+/// Image properties read from a file's header without decoding it.
+///
+/// Returned by `ImagePickerMaster.probeImages`.
+class ProbedImage {
+  /// The absolute path of the probed file.
+  final String path;
+
+  /// Pixel width as stored in the file (before any EXIF orientation).
+  final int width;
+
+  /// Pixel height as stored in the file (before any EXIF orientation).
+  final int height;
+
+  /// The image format, e.g. `'jpeg'`, `'png'`, `'gif'`, `'webp'`.
+  final String format;
+
+  /// Whether the image carries transparency.
+  final bool hasAlpha;
+
+  /// Creates a new [ProbedImage] instance.
+  const ProbedImage({
+    required this.path,
+    required this.width,
+    required this.height,
+    required this.format,
+    this.hasAlpha = false,
+  });
+
+  /// Creates a [ProbedImage] from a platform channel map, or returns `null`
+  /// when the file was not a readable image.
+  static ProbedImage? fromMap(Map<String, dynamic> map) {
+    final width = map['width'];
+    final height = map['height'];
+    if (width is! int || height is! int) return null;
+    return ProbedImage(
+      path: map['path'] ?? '',
+      width: width,
+      height: height,
+      format: map['format'] ?? '',
+      hasAlpha: map['hasAlpha'] ?? false,
+    );
+  }
+}
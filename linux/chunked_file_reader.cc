@@ -0,0 +1,58 @@
+#include "chunked_file_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace image_picker_master {
+
+std::unique_ptr<ChunkedFileReader> ChunkedFileReader::Open(
+    const std::string& path, size_t chunk_size) {
+  if (chunk_size == 0) return nullptr;
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return nullptr;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return nullptr;
+  }
+
+  // Chunks are requested front to back; let the kernel read ahead further.
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  return std::unique_ptr<ChunkedFileReader>(
+      new ChunkedFileReader(fd, static_cast<int64_t>(st.st_size), chunk_size));
+}
+
+ChunkedFileReader::~ChunkedFileReader() {
+  close(fd_);
+}
+
+size_t ChunkedFileReader::chunk_count() const {
+  return static_cast<size_t>((static_cast<uint64_t>(size_) + chunk_size_ - 1) /
+                             chunk_size_);
+}
+
+bool ChunkedFileReader::ReadChunk(size_t index,
+                                  std::vector<uint8_t>* out) const {
+  if (index >= chunk_count()) return false;
+  uint64_t offset = static_cast<uint64_t>(index) * chunk_size_;
+  size_t length = static_cast<size_t>(
+      std::min<uint64_t>(chunk_size_, static_cast<uint64_t>(size_) - offset));
+  out->resize(length);
+
+  size_t done = 0;
+  while (done < length) {
+    ssize_t n = pread(fd_, out->data() + done, length - done,
+                      static_cast<off_t>(offset + done));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;  // error, or the file shrank under us
+    done += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+}  // namespace image_picker_master
@@ -0,0 +1,47 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_CHUNKED_FILE_READER_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_CHUNKED_FILE_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace image_picker_master {
+
+// A regular file split into fixed-size chunks (the last one may be
+// shorter). Chunks are read with pread, so several workers can read
+// different chunks at once without sharing a file position.
+class ChunkedFileReader {
+ public:
+  // Opens |path| for reading in |chunk_size|-byte chunks. Returns nullptr
+  // when the file cannot be opened, is not a regular file, or |chunk_size|
+  // is zero.
+  static std::unique_ptr<ChunkedFileReader> Open(const std::string& path,
+                                                 size_t chunk_size);
+
+  ~ChunkedFileReader();
+
+  ChunkedFileReader(const ChunkedFileReader&) = delete;
+  ChunkedFileReader& operator=(const ChunkedFileReader&) = delete;
+
+  int64_t size() const { return size_; }
+  size_t  chunk_size() const { return chunk_size_; }
+  size_t  chunk_count() const;
+
+  // Reads chunk |index| into |out|, resizing it to the chunk's length.
+  // Returns false on an I/O error or an index past the end.
+  bool ReadChunk(size_t index, std::vector<uint8_t>* out) const;
+
+ private:
+  ChunkedFileReader(int fd, int64_t size, size_t chunk_size)
+      : fd_(fd), size_(size), chunk_size_(chunk_size) {}
+
+  const int     fd_;
+  const int64_t size_;
+  const size_t  chunk_size_;
+};
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_CHUNKED_FILE_READER_H_
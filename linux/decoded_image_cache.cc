@@ -0,0 +1,93 @@
+#include "decoded_image_cache.h"
+
+#include <iterator>
+
+namespace image_picker_master {
+
+DecodedImageCache::DecodedImageCache(uint64_t max_bytes)
+    : max_bytes_(max_bytes) {}
+
+bool DecodedImageCache::Lookup(const std::string& path,
+                               const SourceStamp& stamp,
+                               int min_width, int min_height,
+                               DecodedImage* out) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = index_.find(path);
+  if (it == index_.end()) return false;
+
+  const Entry& entry = *it->second;
+  if (!(entry.stamp == stamp)) {
+    EraseLocked(it->second);  // the file changed since it was decoded
+    return false;
+  }
+  if (entry.image.pixels.width < min_width ||
+      entry.image.pixels.height < min_height) {
+    return false;
+  }
+
+  lru_.splice(lru_.begin(), lru_, it->second);
+  *out = entry.image;
+  return true;
+}
+
+void DecodedImageCache::Insert(const std::string& path,
+                               const SourceStamp& stamp,
+                               const DecodedImage& image) {
+  const ImageBuffer& px = image.pixels;
+  uint64_t bytes = static_cast<uint64_t>(px.stride) * px.height;
+  if (px.empty() || bytes > max_bytes_) return;
+
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = index_.find(path);
+  if (it != index_.end()) {
+    const Entry& old = *it->second;
+    if (old.stamp == stamp &&
+        static_cast<int64_t>(old.image.pixels.width) * old.image.pixels.height >
+            static_cast<int64_t>(px.width) * px.height) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return;
+    }
+    EraseLocked(it->second);
+  }
+
+  lru_.push_front(Entry{path, stamp, image, bytes});
+  index_.emplace(path, lru_.begin());
+  total_bytes_ += bytes;
+
+  while (total_bytes_ > max_bytes_ && lru_.size() > 1) {
+    EraseLocked(std::prev(lru_.end()));
+  }
+}
+
+bool DecodedImageCache::Release(const std::string& path) {
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = index_.find(path);
+  if (it == index_.end()) return false;
+  EraseLocked(it->second);
+  return true;
+}
+
+void DecodedImageCache::Clear() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  lru_.clear();
+  index_.clear();
+  total_bytes_ = 0;
+}
+
+uint64_t DecodedImageCache::total_bytes() const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return total_bytes_;
+}
+
+size_t DecodedImageCache::size() const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return lru_.size();
+}
+
+void DecodedImageCache::EraseLocked(std::list<Entry>::iterator it) {
+  total_bytes_ -= it->bytes;
+  index_.erase(it->path);
+  lru_.erase(it);
+}
+
+}  // namespace image_picker_master
@@ -0,0 +1,84 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_DECODED_IMAGE_CACHE_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_DECODED_IMAGE_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "image_buffer.h"
+
+namespace image_picker_master {
+
+// A source file as it was when it was decoded.
+struct SourceStamp {
+  int64_t mtime_ns = 0;
+  int64_t size     = 0;
+
+  bool operator==(const SourceStamp& other) const {
+    return mtime_ns == other.mtime_ns && size == other.size;
+  }
+};
+
+// Decoded pixels of a whole image, possibly at a reduced scale (JPEG DCT
+// scaling). One decoded pixel covers source_width / pixels.width source
+// pixels horizontally, and likewise vertically.
+struct DecodedImage {
+  ImageBuffer pixels;
+  int source_width  = 0;
+  int source_height = 0;
+};
+
+// Small LRU of decoded images shared by resizeImageForCropper and
+// cropImageNative, so a cropper session decodes its photo once. At most
+// one entry per path; bounded by total pixel bytes. Buffers are shared, so
+// an entry evicted while a job is still reading it stays valid for that
+// job. Thread-safe.
+class DecodedImageCache {
+ public:
+  explicit DecodedImageCache(uint64_t max_bytes);
+
+  DecodedImageCache(const DecodedImageCache&) = delete;
+  DecodedImageCache& operator=(const DecodedImageCache&) = delete;
+
+  // Returns true and fills |out| when |path| is cached for |stamp| at no
+  // less than |min_width| × |min_height|.
+  bool Lookup(const std::string& path, const SourceStamp& stamp,
+              int min_width, int min_height, DecodedImage* out);
+
+  // Caches |image| for |path|, replacing an older entry unless that one is
+  // for the same |stamp| and has more pixels. Images larger than the whole
+  // budget are not cached.
+  void Insert(const std::string& path, const SourceStamp& stamp,
+              const DecodedImage& image);
+
+  // Drops the entry for |path|, if any. Returns whether one was dropped.
+  bool Release(const std::string& path);
+
+  void Clear();
+
+  uint64_t total_bytes() const;
+  size_t   size() const;
+
+ private:
+  struct Entry {
+    std::string  path;
+    SourceStamp  stamp;
+    DecodedImage image;
+    uint64_t     bytes = 0;
+  };
+
+  void EraseLocked(std::list<Entry>::iterator it);
+
+  const uint64_t max_bytes_;
+
+  mutable std::mutex mutex_;
+  std::list<Entry>   lru_;  // front = most recently used
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  uint64_t           total_bytes_ = 0;
+};
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_DECODED_IMAGE_CACHE_H_
@@ -0,0 +1,214 @@
+#include "exif_parser.h"
+
+#include <cstring>
+#include <memory>
+
+#include "mapped_file.h"
+
+namespace image_picker_master {
+
+namespace {
+
+constexpr uint16_t kTagOrientation      = 0x0112;
+constexpr uint16_t kTagExifIfd          = 0x8769;
+constexpr uint16_t kTagDateTimeOriginal = 0x9003;
+constexpr uint16_t kTagThumbnailOffset  = 0x0201;
+constexpr uint16_t kTagThumbnailLength  = 0x0202;
+
+constexpr uint16_t kTypeAscii = 2;
+constexpr uint16_t kTypeShort = 3;
+constexpr uint16_t kTypeLong  = 4;
+
+// Real files carry a few dozen entries per IFD; anything near this is junk.
+constexpr uint16_t kMaxIfdEntries = 1024;
+
+// The TIFF structure inside an EXIF block: all offsets are relative to its
+// first byte, |file_offset| is where that byte sits in the file.
+class Tiff {
+ public:
+  Tiff(const uint8_t* data, size_t size, uint64_t file_offset)
+      : data_(data), size_(size), file_offset_(file_offset) {}
+
+  bool ParseHeader(uint32_t* ifd0) {
+    if (size_ < 8) return false;
+    if (memcmp(data_, "II*\0", 4) == 0) {
+      little_endian_ = true;
+    } else if (memcmp(data_, "MM\0*", 4) == 0) {
+      little_endian_ = false;
+    } else {
+      return false;
+    }
+    *ifd0 = U32(data_ + 4);
+    return true;
+  }
+
+  // Calls |visit|(tag, entry) for every entry of the IFD at |offset| and
+  // returns the next IFD's offset (0 when there is none or it is invalid).
+  template <typename Visit>
+  uint32_t ForEachEntry(uint32_t offset, Visit visit) const {
+    if (offset < 8 || offset > size_ - 2) return 0;
+    uint16_t count = U16(data_ + offset);
+    if (count > kMaxIfdEntries) return 0;
+    uint64_t end = offset + 2 + uint64_t{12} * count;
+    if (end > size_) return 0;
+    for (uint16_t i = 0; i < count; i++) {
+      const uint8_t* entry = data_ + offset + 2 + 12 * i;
+      visit(U16(entry), entry);
+    }
+    return end + 4 <= size_ ? U32(data_ + end) : 0;
+  }
+
+  // First value of a SHORT or LONG entry.
+  bool Uint(const uint8_t* entry, uint32_t* value) const {
+    uint16_t type = U16(entry + 2);
+    if (U32(entry + 4) < 1) return false;
+    if (type == kTypeShort) {
+      *value = U16(entry + 8);
+    } else if (type == kTypeLong) {
+      *value = U32(entry + 8);
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  // Copies an ASCII entry of exactly |n| characters (plus NUL) into |out|.
+  bool Ascii(const uint8_t* entry, char* out, size_t n) const {
+    if (U16(entry + 2) != kTypeAscii) return false;
+    uint32_t count = U32(entry + 4);
+    if (count < n) return false;
+    const uint8_t* text;
+    if (count <= 4) {
+      text = entry + 8;
+    } else {
+      uint32_t offset = U32(entry + 8);
+      if (offset > size_ || n > size_ - offset) return false;
+      text = data_ + offset;
+    }
+    for (size_t i = 0; i < n; i++) {
+      if (text[i] < 0x20 || text[i] > 0x7E) return false;
+    }
+    memcpy(out, text, n);
+    out[n] = '\0';
+    return true;
+  }
+
+  size_t   size() const { return size_; }
+  uint64_t file_offset() const { return file_offset_; }
+
+ private:
+  uint16_t U16(const uint8_t* p) const {
+    return little_endian_ ? static_cast<uint16_t>(p[0] | p[1] << 8)
+                          : static_cast<uint16_t>(p[0] << 8 | p[1]);
+  }
+  uint32_t U32(const uint8_t* p) const {
+    return little_endian_
+        ? static_cast<uint32_t>(p[0]) | p[1] << 8 | p[2] << 16 |
+              static_cast<uint32_t>(p[3]) << 24
+        : static_cast<uint32_t>(p[0]) << 24 | p[1] << 16 | p[2] << 8 | p[3];
+  }
+
+  const uint8_t* data_;
+  size_t         size_;
+  uint64_t       file_offset_;
+  bool           little_endian_ = true;
+};
+
+bool parse_tiff(const Tiff& tiff_in, ExifInfo* out) {
+  Tiff tiff = tiff_in;
+  uint32_t ifd0 = 0;
+  if (!tiff.ParseHeader(&ifd0)) return false;
+
+  *out = ExifInfo();
+  uint32_t exif_ifd = 0;
+  uint32_t ifd1 = tiff.ForEachEntry(ifd0, [&](uint16_t tag, const uint8_t* e) {
+    uint32_t value = 0;
+    if (tag == kTagOrientation && tiff.Uint(e, &value) && value >= 1 &&
+        value <= 8) {
+      out->orientation = static_cast<int>(value);
+    } else if (tag == kTagExifIfd && tiff.Uint(e, &value)) {
+      exif_ifd = value;
+    }
+  });
+
+  if (exif_ifd != 0 && exif_ifd != ifd0) {
+    tiff.ForEachEntry(exif_ifd, [&](uint16_t tag, const uint8_t* e) {
+      if (tag == kTagDateTimeOriginal) {
+        tiff.Ascii(e, out->date_time_original, 19);
+      }
+    });
+  }
+
+  if (ifd1 != 0 && ifd1 != ifd0 && ifd1 != exif_ifd) {
+    uint32_t offset = 0, length = 0;
+    tiff.ForEachEntry(ifd1, [&](uint16_t tag, const uint8_t* e) {
+      if (tag == kTagThumbnailOffset) tiff.Uint(e, &offset);
+      else if (tag == kTagThumbnailLength) tiff.Uint(e, &length);
+    });
+    if (offset != 0 && length != 0 && offset < tiff.size() &&
+        length <= tiff.size() - offset) {
+      out->thumbnail_offset = tiff.file_offset() + offset;
+      out->thumbnail_length = length;
+    }
+  }
+  return true;
+}
+
+// Walks JPEG marker segments up to the start of scan looking for APP1
+// "Exif\0\0".
+bool parse_jpeg(const uint8_t* data, size_t size, ExifInfo* out) {
+  size_t pos = 2;
+  while (pos + 4 <= size) {
+    if (data[pos] != 0xFF) return false;
+    uint8_t marker = data[pos + 1];
+    if (marker == 0xFF) {  // fill byte
+      pos++;
+      continue;
+    }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+      pos += 2;
+      continue;
+    }
+    if (marker == 0xDA || marker == 0xD9) return false;  // no EXIF before data
+
+    size_t length = static_cast<size_t>(data[pos + 2] << 8 | data[pos + 3]);
+    if (length < 2 || length > size - pos - 2) return false;
+    const uint8_t* payload = data + pos + 4;
+    size_t payload_size = length - 2;
+    if (marker == 0xE1 && payload_size > 6 &&
+        memcmp(payload, "Exif\0\0", 6) == 0) {
+      return parse_tiff(Tiff(payload + 6, payload_size - 6, pos + 4 + 6), out);
+    }
+    pos += 2 + length;
+  }
+  return false;
+}
+
+}  // namespace
+
+bool ParseExif(const uint8_t* data, size_t size, ExifInfo* out) {
+  if (!data || size < 8) return false;
+  if (data[0] == 0xFF && data[1] == 0xD8) return parse_jpeg(data, size, out);
+  return parse_tiff(Tiff(data, size, 0), out);
+}
+
+bool ReadExif(const std::string& path, ExifInfo* out) {
+  std::unique_ptr<MappedFile> file =
+      MappedFile::Open(path, MappedFile::Access::kHeaders);
+  return file && ParseExif(file->data(), file->size(), out);
+}
+
+void ExifOrientationTransform(int orientation, int* rotation, bool* mirror) {
+  switch (orientation) {
+    case 2:  *rotation = 0;   *mirror = true;  break;
+    case 3:  *rotation = 180; *mirror = false; break;
+    case 4:  *rotation = 180; *mirror = true;  break;  // flip vertical
+    case 5:  *rotation = 90;  *mirror = true;  break;  // transpose
+    case 6:  *rotation = 270; *mirror = false; break;  // 90° clockwise
+    case 7:  *rotation = 270; *mirror = true;  break;  // transverse
+    case 8:  *rotation = 90;  *mirror = false; break;  // 90° counter-clockwise
+    default: *rotation = 0;   *mirror = false; break;
+  }
+}
+
+}  // namespace image_picker_master
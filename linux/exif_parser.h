@@ -0,0 +1,37 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_EXIF_PARSER_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_EXIF_PARSER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace image_picker_master {
+
+// The EXIF fields the plugin reports and acts on.
+struct ExifInfo {
+  int      orientation = 1;           // 1–8 (tag 0x0112); 1 when absent
+  char     date_time_original[20] = {};  // "YYYY:MM:DD HH:MM:SS" or empty
+  uint64_t thumbnail_offset = 0;      // file offset of the IFD1 JPEG, or 0
+  uint32_t thumbnail_length = 0;
+};
+
+// Parses the EXIF block of a JPEG (the APP1 "Exif" segment) or the IFDs of
+// a TIFF file held in |data|. Works in place over the bytes — typically a
+// read-only mapping — and never allocates. Every offset and count is bounds
+// checked, so truncated or hostile input only ever yields false or fewer
+// fields. Returns false when there is no readable EXIF.
+bool ParseExif(const uint8_t* data, size_t size, ExifInfo* out);
+
+// Maps |path| without readahead and runs ParseExif over it, so only the
+// pages holding the headers are actually read.
+bool ReadExif(const std::string& path, ExifInfo* out);
+
+// The transform that shows an image with EXIF |orientation| upright: mirror
+// left-right first, then turn by |rotation| degrees in the
+// gdk_pixbuf_rotate_simple sense (90 counter-clockwise, 270 clockwise), as
+// CropRotateScaleSpec expects. Unknown values map to the identity.
+void ExifOrientationTransform(int orientation, int* rotation, bool* mirror);
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_EXIF_PARSER_H_
@@ -0,0 +1,89 @@
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include <algorithm>
+#include <string>
+
+#include "image_codec.h"
+#include "image_probe.h"
+
+namespace image_picker_master {
+
+namespace {
+
+class GdkPixbufJpegCodec : public JpegCodec {
+ public:
+  const char* name() const override { return "gdk-pixbuf"; }
+
+  bool Decode(const uint8_t* data, size_t size,
+              const JpegDecodeOptions& options,
+              ImageBuffer* out) const override {
+    *out = ImageBuffer();
+    ImageProbe probe;
+    if (!ProbeImageData(data, size, &probe) || probe.format != "jpeg") {
+      return false;
+    }
+
+    GdkPixbufLoader* loader = gdk_pixbuf_loader_new_with_type("jpeg", nullptr);
+    if (!loader) return false;
+    if (options.scale_denom > 1) {
+      // The JPEG loader turns the size hint into DCT scaling as well.
+      int denom = options.scale_denom;
+      gdk_pixbuf_loader_set_size(loader, (probe.width + denom - 1) / denom,
+                                 (probe.height + denom - 1) / denom);
+    }
+    bool loaded = gdk_pixbuf_loader_write(loader, data, size, nullptr);
+    loaded = gdk_pixbuf_loader_close(loader, nullptr) && loaded;
+    GdkPixbuf* pixbuf = loaded ? gdk_pixbuf_loader_get_pixbuf(loader) : nullptr;
+    if (pixbuf) g_object_ref(pixbuf);
+    g_object_unref(loader);
+    if (!pixbuf) return false;
+
+    out->storage = std::shared_ptr<uint8_t>(
+        gdk_pixbuf_get_pixels(pixbuf),
+        [pixbuf](uint8_t*) { g_object_unref(pixbuf); });
+    out->pixels   = out->storage.get();
+    out->width    = gdk_pixbuf_get_width(pixbuf);
+    out->height   = gdk_pixbuf_get_height(pixbuf);
+    out->stride   = gdk_pixbuf_get_rowstride(pixbuf);
+    out->channels = gdk_pixbuf_get_n_channels(pixbuf);
+    return true;
+  }
+
+  bool Encode(const ImageBuffer& pixels,
+              const JpegEncodeOptions& options,
+              std::vector<uint8_t>* out) const override {
+    out->clear();
+    if (pixels.empty() || (pixels.channels != 3 && pixels.channels != 4)) {
+      return false;
+    }
+    GdkPixbuf* pixbuf = gdk_pixbuf_new_from_data(
+        pixels.pixels, GDK_COLORSPACE_RGB, pixels.channels == 4, 8,
+        pixels.width, pixels.height, pixels.stride, nullptr, nullptr);
+    std::string quality = std::to_string(std::clamp(options.quality, 0, 100));
+    GError* error = nullptr;
+    gboolean ok = gdk_pixbuf_save_to_callback(
+        pixbuf,
+        [](const gchar* buf, gsize count, GError**, gpointer data) -> gboolean {
+          auto* bytes = static_cast<std::vector<uint8_t>*>(data);
+          bytes->insert(bytes->end(), buf, buf + count);
+          return TRUE;
+        },
+        out, "jpeg", &error, "quality", quality.c_str(), nullptr);
+    g_object_unref(pixbuf);
+    if (!ok || error) {
+      if (error) g_error_free(error);
+      out->clear();
+      return false;
+    }
+    return true;
+  }
+};
+
+}  // namespace
+
+const JpegCodec& GdkPixbufCodec() {
+  static const GdkPixbufJpegCodec codec;
+  return codec;
+}
+
+}  // namespace image_picker_master
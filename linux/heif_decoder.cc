@@ -0,0 +1,192 @@
+#include "heif_decoder.h"
+
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBHEIF
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <libheif/heif.h>
+
+#include "mapped_file.h"
+#endif
+
+namespace image_picker_master {
+
+bool IsHeifFormat(const std::string& format) {
+  return format == "heif" || format == "avif";
+}
+
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBHEIF
+
+namespace {
+
+// A parsed file: the mapping stays alive as long as the context, which
+// reads from it without copying.
+struct HeifFile {
+  std::unique_ptr<MappedFile> file;
+  heif_context* context = nullptr;
+  heif_image_handle* primary = nullptr;
+
+  ~HeifFile() {
+    if (primary) heif_image_handle_release(primary);
+    if (context) heif_context_free(context);
+  }
+};
+
+// ISO BMFF files open with an ftyp box; checking for it first keeps
+// non-HEIF files from ever reaching libheif.
+bool has_ftyp(const MappedFile& file) {
+  return file.size() >= 12 && memcmp(file.data() + 4, "ftyp", 4) == 0;
+}
+
+bool open_heif(const std::string& path, HeifFile* out) {
+#if LIBHEIF_HAVE_VERSION(1, 13, 0)
+  // Loads libheif's codec plugins; later calls only bump a refcount.
+  static std::once_flag init;
+  std::call_once(init, [] { heif_init(nullptr); });
+#endif
+  out->file = MappedFile::Open(path);
+  if (!out->file || !has_ftyp(*out->file)) return false;
+  out->context = heif_context_alloc();
+  if (!out->context) return false;
+  heif_error error = heif_context_read_from_memory_without_copy(
+      out->context, out->file->data(), out->file->size(), nullptr);
+  if (error.code != heif_error_Ok) return false;
+  error = heif_context_get_primary_image_handle(out->context, &out->primary);
+  return error.code == heif_error_Ok;
+}
+
+// Decodes |handle| to interleaved RGB(A). The buffer aliases the decoded
+// heif_image, which is released with the buffer's storage.
+bool decode_handle(heif_image_handle* handle, ImageBuffer* out) {
+  const bool alpha = heif_image_handle_has_alpha_channel(handle) != 0;
+  heif_image* image = nullptr;
+  heif_error error = heif_decode_image(
+      handle, &image, heif_colorspace_RGB,
+      alpha ? heif_chroma_interleaved_RGBA : heif_chroma_interleaved_RGB,
+      nullptr);
+  if (error.code != heif_error_Ok || !image) return false;
+
+  int stride = 0;
+  uint8_t* pixels = heif_image_get_plane(image, heif_channel_interleaved,
+                                         &stride);
+  if (!pixels) {
+    heif_image_release(image);
+    return false;
+  }
+  out->storage = std::shared_ptr<uint8_t>(
+      pixels, [image](uint8_t*) { heif_image_release(image); });
+  out->pixels   = pixels;
+  out->width    = heif_image_get_width(image, heif_channel_interleaved);
+  out->height   = heif_image_get_height(image, heif_channel_interleaved);
+  out->stride   = stride;
+  out->channels = alpha ? 4 : 3;
+  return true;
+}
+
+// Thumbnail handles of |primary|, each paired with its upright size.
+struct Thumbnail {
+  heif_item_id id;
+  int width;
+  int height;
+};
+
+std::vector<Thumbnail> list_thumbnails(heif_image_handle* primary) {
+  int count = heif_image_handle_get_number_of_thumbnails(primary);
+  std::vector<heif_item_id> ids(count > 0 ? count : 0);
+  if (ids.empty()) return {};
+  count = heif_image_handle_get_list_of_thumbnail_IDs(primary, ids.data(),
+                                                      count);
+  std::vector<Thumbnail> thumbnails;
+  for (int i = 0; i < count; i++) {
+    heif_image_handle* handle = nullptr;
+    if (heif_image_handle_get_thumbnail(primary, ids[i], &handle).code !=
+        heif_error_Ok) {
+      continue;
+    }
+    thumbnails.push_back(Thumbnail{ids[i],
+                                   heif_image_handle_get_width(handle),
+                                   heif_image_handle_get_height(handle)});
+    heif_image_handle_release(handle);
+  }
+  return thumbnails;
+}
+
+bool decode_thumbnail(heif_image_handle* primary, heif_item_id id,
+                      ImageBuffer* out) {
+  heif_image_handle* handle = nullptr;
+  if (heif_image_handle_get_thumbnail(primary, id, &handle).code !=
+      heif_error_Ok) {
+    return false;
+  }
+  bool ok = decode_handle(handle, out);
+  heif_image_handle_release(handle);
+  return ok;
+}
+
+}  // namespace
+
+bool HeifDecodeAvailable() { return true; }
+
+bool ProbeHeif(const std::string& path, ImageProbe* out) {
+  HeifFile heif;
+  if (!open_heif(path, &heif)) return false;
+  const uint8_t* brand = heif.file->data() + 8;
+  bool avif = memcmp(brand, "avif", 4) == 0 || memcmp(brand, "avis", 4) == 0;
+  out->format    = avif ? "avif" : "heif";
+  out->width     = heif_image_handle_get_width(heif.primary);
+  out->height    = heif_image_handle_get_height(heif.primary);
+  out->has_alpha = heif_image_handle_has_alpha_channel(heif.primary) != 0;
+  return out->width > 0 && out->height > 0;
+}
+
+bool DecodeHeif(const std::string& path, int min_width, int min_height,
+                ImageBuffer* out) {
+  HeifFile heif;
+  if (!open_heif(path, &heif)) return false;
+
+  const Thumbnail* best = nullptr;
+  std::vector<Thumbnail> thumbnails = list_thumbnails(heif.primary);
+  for (const Thumbnail& thumbnail : thumbnails) {
+    if (thumbnail.width >= min_width && thumbnail.height >= min_height &&
+        (!best || thumbnail.width < best->width)) {
+      best = &thumbnail;
+    }
+  }
+  if (best && decode_thumbnail(heif.primary, best->id, out)) return true;
+  return decode_handle(heif.primary, out);
+}
+
+bool DecodeHeifThumbnail(const std::string& path, ImageBuffer* out) {
+  HeifFile heif;
+  if (!open_heif(path, &heif)) return false;
+
+  const Thumbnail* largest = nullptr;
+  std::vector<Thumbnail> thumbnails = list_thumbnails(heif.primary);
+  for (const Thumbnail& thumbnail : thumbnails) {
+    if (!largest || thumbnail.width > largest->width) largest = &thumbnail;
+  }
+  return largest && decode_thumbnail(heif.primary, largest->id, out);
+}
+
+#else  // !IMAGE_PICKER_MASTER_HAVE_LIBHEIF
+
+bool HeifDecodeAvailable() { return false; }
+
+bool ProbeHeif(const std::string& /*path*/, ImageProbe* /*out*/) {
+  return false;
+}
+
+bool DecodeHeif(const std::string& /*path*/, int /*min_width*/,
+                int /*min_height*/, ImageBuffer* /*out*/) {
+  return false;
+}
+
+bool DecodeHeifThumbnail(const std::string& /*path*/, ImageBuffer* /*out*/) {
+  return false;
+}
+
+#endif  // IMAGE_PICKER_MASTER_HAVE_LIBHEIF
+
+}  // namespace image_picker_master
@@ -0,0 +1,39 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_HEIF_DECODER_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_HEIF_DECODER_H_
+
+#include <string>
+
+#include "image_buffer.h"
+#include "image_probe.h"
+
+namespace image_picker_master {
+
+// True when the plugin was built against libheif. Which codecs it can
+// actually decode (HEVC for HEIC, AV1 for AVIF) depends on how libheif
+// itself was built; the calls below return false for the rest.
+bool HeifDecodeAvailable();
+
+// True for the probe format names of HEIF and AVIF files.
+bool IsHeifFormat(const std::string& format);
+
+// Width, height and alpha of the primary image of the HEIF / AVIF file at
+// |path|, read from its metadata boxes without decoding. |format| is
+// "heif" or "avif" (gdk-pixbuf's loader names). Unlike the other formats
+// the size is as displayed: libheif applies the file's rotation and mirror
+// (irot / imir) on decode, so there is no EXIF orientation left to apply.
+bool ProbeHeif(const std::string& path, ImageProbe* out);
+
+// Decodes the primary image of the file at |path|, upright, to RGB or RGBA
+// (when it has alpha). When an embedded thumbnail is at least |min_width| x
+// |min_height| the smallest such thumbnail is decoded instead, which for a
+// preview skips most of the work. |out| points straight into libheif's
+// decoded image, which its storage keeps alive.
+bool DecodeHeif(const std::string& path, int min_width, int min_height,
+                ImageBuffer* out);
+
+// Decodes only the largest embedded thumbnail; false when there is none.
+bool DecodeHeifThumbnail(const std::string& path, ImageBuffer* out);
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_HEIF_DECODER_H_
@@ -0,0 +1,54 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_BUFFER_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace image_picker_master {
+
+// 8-bit interleaved RGB or RGBA pixels. |storage| owns (or pins) the memory
+// that |pixels| points into, so a buffer can alias a GdkPixbuf or be a
+// sub-rectangle of another buffer without copying.
+struct ImageBuffer {
+  std::shared_ptr<uint8_t> storage;
+  uint8_t* pixels  = nullptr;
+  int width        = 0;
+  int height       = 0;
+  int stride       = 0;  // bytes per row
+  int channels     = 0;  // 3 (RGB) or 4 (RGBA)
+
+  bool empty() const { return pixels == nullptr; }
+
+  uint8_t* row(int y) const {
+    return pixels + static_cast<size_t>(y) * static_cast<size_t>(stride);
+  }
+
+  // Uninitialised |width| x |height| buffer with tightly packed rows.
+  static ImageBuffer Allocate(int width, int height, int channels) {
+    ImageBuffer buffer;
+    size_t size = static_cast<size_t>(width) * height * channels;
+    buffer.storage  = std::shared_ptr<uint8_t>(new uint8_t[size],
+                                               std::default_delete<uint8_t[]>());
+    buffer.pixels   = buffer.storage.get();
+    buffer.width    = width;
+    buffer.height   = height;
+    buffer.stride   = width * channels;
+    buffer.channels = channels;
+    return buffer;
+  }
+
+  // View of the given rectangle sharing this buffer's storage. The caller
+  // keeps the rectangle inside the buffer.
+  ImageBuffer SubRect(int x, int y, int w, int h) const {
+    ImageBuffer view = *this;
+    view.pixels = row(y) + static_cast<size_t>(x) * channels;
+    view.width  = w;
+    view.height = h;
+    return view;
+  }
+};
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_BUFFER_H_
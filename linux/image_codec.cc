@@ -0,0 +1,367 @@
+#include "image_codec.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBJPEG
+#include <csetjmp>
+#include <cstdio>
+
+#include <jpeglib.h>
+
+#include "jpeg_error_manager.h"
+#include "jpeg_vector_destination.h"
+#endif
+
+namespace image_picker_master {
+
+namespace {
+
+// Luma sampling factors (chroma is always 1×1) for each subsampling;
+// anything unknown is 4:2:0.
+void sampling_factors(ChromaSubsampling subsampling, int* h, int* v) {
+  *h = 2;
+  *v = 2;
+  switch (subsampling) {
+    case ChromaSubsampling::k444: *h = 1; *v = 1; break;
+    case ChromaSubsampling::k422: *h = 2; *v = 1; break;
+    case ChromaSubsampling::k420: *h = 2; *v = 2; break;
+  }
+}
+
+int round_up(int value, int multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+}  // namespace
+
+int YuvImage::plane_width(int plane) const {
+  int h = 1, v = 1;
+  sampling_factors(subsampling, &h, &v);
+  return plane == 0 ? width : (width + h - 1) / h;
+}
+
+int YuvImage::plane_height(int plane) const {
+  int h = 1, v = 1;
+  sampling_factors(subsampling, &h, &v);
+  return plane == 0 ? height : (height + v - 1) / v;
+}
+
+YuvImage YuvImage::Allocate(int width, int height,
+                            ChromaSubsampling subsampling) {
+  int h = 1, v = 1;
+  sampling_factors(subsampling, &h, &v);
+  const int luma_w = round_up(width, 8 * h);
+  const int luma_h = round_up(height, 8 * v);
+
+  YuvImage image;
+  image.width       = width;
+  image.height      = height;
+  image.subsampling = subsampling;
+  image.strides[0]  = luma_w;
+  image.rows[0]     = luma_h;
+  for (int c = 1; c < 3; c++) {
+    image.strides[c] = luma_w / h;
+    image.rows[c]    = luma_h / v;
+  }
+
+  size_t total = 0;
+  for (int c = 0; c < 3; c++) {
+    total += static_cast<size_t>(image.strides[c]) * image.rows[c];
+  }
+  image.storage = std::shared_ptr<uint8_t>(new uint8_t[total](),
+                                           std::default_delete<uint8_t[]>());
+  uint8_t* next = image.storage.get();
+  for (int c = 0; c < 3; c++) {
+    image.planes[c] = next;
+    next += static_cast<size_t>(image.strides[c]) * image.rows[c];
+  }
+  return image;
+}
+
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBJPEG
+
+namespace {
+
+void set_sampling(j_compress_ptr cinfo, ChromaSubsampling subsampling) {
+  int h = 1, v = 1;
+  sampling_factors(subsampling, &h, &v);
+  cinfo->comp_info[0].h_samp_factor = h;
+  cinfo->comp_info[0].v_samp_factor = v;
+  for (int c = 1; c < 3; c++) {
+    cinfo->comp_info[c].h_samp_factor = 1;
+    cinfo->comp_info[c].v_samp_factor = 1;
+  }
+}
+
+// Progressive scans and Huffman optimization, applied after
+// jpeg_set_defaults (which resets both). libjpeg optimizes the tables of a
+// progressive file anyway; it is set here so the intent is explicit.
+void set_entropy_coding(j_compress_ptr cinfo,
+                        const JpegEncodeOptions& options) {
+  cinfo->optimize_coding =
+      options.optimize_coding || options.progressive ? TRUE : FALSE;
+  if (options.progressive) jpeg_simple_progression(cinfo);
+}
+
+class LibjpegJpegCodec : public JpegCodec {
+ public:
+  const char* name() const override {
+#ifdef LIBJPEG_TURBO_VERSION
+    return "libjpeg-turbo";
+#else
+    return "libjpeg";
+#endif
+  }
+
+  bool Decode(const uint8_t* data, size_t size,
+              const JpegDecodeOptions& options,
+              ImageBuffer* out) const override {
+    *out = ImageBuffer();
+    if (!data || size == 0) return false;
+
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager       jerr;
+    cinfo.err = InstallJpegErrorManager(&jerr);
+    if (setjmp(jerr.jump)) {
+      jpeg_destroy_decompress(&cinfo);
+      *out = ImageBuffer();
+      return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, static_cast<unsigned long>(size));
+    jpeg_read_header(&cinfo, TRUE);
+    if (cinfo.jpeg_color_space == JCS_CMYK ||
+        cinfo.jpeg_color_space == JCS_YCCK) {
+      jpeg_destroy_decompress(&cinfo);
+      return false;
+    }
+
+    cinfo.out_color_space     = JCS_RGB;
+    cinfo.scale_num           = 1;
+    cinfo.scale_denom         = static_cast<unsigned int>(options.scale_denom);
+    cinfo.dct_method          = options.fast_dct ? JDCT_IFAST : JDCT_ISLOW;
+    cinfo.do_fancy_upsampling = options.fast_upsample ? FALSE : TRUE;
+    jpeg_start_decompress(&cinfo);
+
+    *out = ImageBuffer::Allocate(static_cast<int>(cinfo.output_width),
+                                 static_cast<int>(cinfo.output_height), 3);
+    while (cinfo.output_scanline < cinfo.output_height) {
+      JSAMPROW rows[4];
+      int count = std::min<int>(4, cinfo.output_height - cinfo.output_scanline);
+      for (int i = 0; i < count; i++) {
+        rows[i] = out->row(static_cast<int>(cinfo.output_scanline) + i);
+      }
+      jpeg_read_scanlines(&cinfo, rows, static_cast<JDIMENSION>(count));
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+  }
+
+  bool Encode(const ImageBuffer& pixels,
+              const JpegEncodeOptions& options,
+              std::vector<uint8_t>* out) const override {
+    out->clear();
+    if (pixels.empty() || (pixels.channels != 3 && pixels.channels != 4)) {
+      return false;
+    }
+#ifndef JCS_EXTENSIONS
+    // Plain IJG libjpeg only takes RGB; RGBA rows are repacked here.
+    std::vector<uint8_t> rgb_row(pixels.channels == 4 ? pixels.width * 3 : 0);
+#endif
+
+    jpeg_compress_struct cinfo;
+    JpegErrorManager     jerr;
+    VectorDestination    dest;
+    cinfo.err = InstallJpegErrorManager(&jerr);
+    if (setjmp(jerr.jump)) {
+      jpeg_destroy_compress(&cinfo);
+      out->clear();
+      return false;
+    }
+
+    jpeg_create_compress(&cinfo);
+    UseVectorDestination(
+        &cinfo, &dest, out,
+        static_cast<size_t>(pixels.width) * pixels.height / 4);
+    cinfo.image_width      = static_cast<JDIMENSION>(pixels.width);
+    cinfo.image_height     = static_cast<JDIMENSION>(pixels.height);
+    cinfo.input_components = pixels.channels;
+#ifdef JCS_EXTENSIONS
+    cinfo.in_color_space = pixels.channels == 4 ? JCS_EXT_RGBX : JCS_RGB;
+#else
+    cinfo.input_components = 3;
+    cinfo.in_color_space   = JCS_RGB;
+#endif
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, std::clamp(options.quality, 0, 100), TRUE);
+    set_sampling(&cinfo, options.subsampling);
+    set_entropy_coding(&cinfo, options);
+    cinfo.dct_method = options.fast_dct ? JDCT_IFAST : JDCT_ISLOW;
+    jpeg_start_compress(&cinfo, TRUE);
+
+    while (cinfo.next_scanline < cinfo.image_height) {
+      JSAMPROW row = pixels.row(static_cast<int>(cinfo.next_scanline));
+#ifndef JCS_EXTENSIONS
+      if (pixels.channels == 4) {
+        for (int x = 0; x < pixels.width; x++) {
+          memcpy(&rgb_row[x * 3], row + x * 4, 3);
+        }
+        row = rgb_row.data();
+      }
+#endif
+      jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    return true;
+  }
+
+  bool DecodeYuv(const uint8_t* data, size_t size,
+                 YuvImage* out) const override {
+    *out = YuvImage();
+    if (!data || size == 0) return false;
+
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager       jerr;
+    cinfo.err = InstallJpegErrorManager(&jerr);
+    if (setjmp(jerr.jump)) {
+      jpeg_destroy_decompress(&cinfo);
+      *out = YuvImage();
+      return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, static_cast<unsigned long>(size));
+    jpeg_read_header(&cinfo, TRUE);
+
+    ChromaSubsampling subsampling;
+    if (!file_subsampling(&cinfo, &subsampling)) {
+      jpeg_destroy_decompress(&cinfo);
+      return false;
+    }
+    cinfo.raw_data_out = TRUE;
+    jpeg_start_decompress(&cinfo);
+
+    *out = YuvImage::Allocate(static_cast<int>(cinfo.image_width),
+                              static_cast<int>(cinfo.image_height),
+                              subsampling);
+    const int max_v = cinfo.max_v_samp_factor;
+    JSAMPROW  rows[3][2 * DCTSIZE];
+    JSAMPARRAY planes[3] = {rows[0], rows[1], rows[2]};
+    for (int y = 0; cinfo.output_scanline < cinfo.output_height;
+         y += max_v * DCTSIZE) {
+      for (int c = 0; c < 3; c++) {
+        int v = cinfo.comp_info[c].v_samp_factor;
+        int first = y / max_v * v;
+        for (int r = 0; r < v * DCTSIZE; r++) {
+          rows[c][r] = out->planes[c] +
+                       static_cast<size_t>(first + r) * out->strides[c];
+        }
+      }
+      jpeg_read_raw_data(&cinfo, planes,
+                         static_cast<JDIMENSION>(max_v * DCTSIZE));
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+  }
+
+  bool EncodeYuv(const YuvImage& yuv,
+                 const JpegEncodeOptions& options,
+                 std::vector<uint8_t>* out) const override {
+    out->clear();
+    if (yuv.empty()) return false;
+
+    jpeg_compress_struct cinfo;
+    JpegErrorManager     jerr;
+    VectorDestination    dest;
+    cinfo.err = InstallJpegErrorManager(&jerr);
+    if (setjmp(jerr.jump)) {
+      jpeg_destroy_compress(&cinfo);
+      out->clear();
+      return false;
+    }
+
+    jpeg_create_compress(&cinfo);
+    UseVectorDestination(&cinfo, &dest, out,
+                         static_cast<size_t>(yuv.width) * yuv.height / 4);
+    cinfo.image_width      = static_cast<JDIMENSION>(yuv.width);
+    cinfo.image_height     = static_cast<JDIMENSION>(yuv.height);
+    cinfo.input_components = 3;
+    cinfo.in_color_space   = JCS_YCbCr;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, std::clamp(options.quality, 0, 100), TRUE);
+    set_sampling(&cinfo, yuv.subsampling);
+    set_entropy_coding(&cinfo, options);
+    cinfo.dct_method  = options.fast_dct ? JDCT_IFAST : JDCT_ISLOW;
+    cinfo.raw_data_in = TRUE;
+    jpeg_start_compress(&cinfo, TRUE);
+
+    const int max_v = cinfo.max_v_samp_factor;
+    JSAMPROW  rows[3][2 * DCTSIZE];
+    JSAMPARRAY planes[3] = {rows[0], rows[1], rows[2]};
+    for (int y = 0; cinfo.next_scanline < cinfo.image_height;
+         y += max_v * DCTSIZE) {
+      for (int c = 0; c < 3; c++) {
+        int v = cinfo.comp_info[c].v_samp_factor;
+        int first = y / max_v * v;
+        for (int r = 0; r < v * DCTSIZE; r++) {
+          // Rows past the padded plane (only in a caller-built image)
+          // repeat its last row.
+          int row = std::min(first + r, yuv.rows[c] - 1);
+          rows[c][r] = yuv.planes[c] + static_cast<size_t>(row) * yuv.strides[c];
+        }
+      }
+      jpeg_write_raw_data(&cinfo, planes,
+                          static_cast<JDIMENSION>(max_v * DCTSIZE));
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    return true;
+  }
+
+ private:
+  // The subsampling of a 3-component YCbCr file, if it is one we handle.
+  static bool file_subsampling(j_decompress_ptr cinfo,
+                               ChromaSubsampling* subsampling) {
+    if (cinfo->num_components != 3 || cinfo->jpeg_color_space != JCS_YCbCr) {
+      return false;
+    }
+    for (int c = 1; c < 3; c++) {
+      if (cinfo->comp_info[c].h_samp_factor != 1 ||
+          cinfo->comp_info[c].v_samp_factor != 1) {
+        return false;
+      }
+    }
+    int h = cinfo->comp_info[0].h_samp_factor;
+    int v = cinfo->comp_info[0].v_samp_factor;
+    if (h == 1 && v == 1)      *subsampling = ChromaSubsampling::k444;
+    else if (h == 2 && v == 1) *subsampling = ChromaSubsampling::k422;
+    else if (h == 2 && v == 2) *subsampling = ChromaSubsampling::k420;
+    else return false;
+    return true;
+  }
+};
+
+}  // namespace
+
+const JpegCodec* LibjpegCodec() {
+  static const LibjpegJpegCodec codec;
+  return &codec;
+}
+
+#else  // !IMAGE_PICKER_MASTER_HAVE_LIBJPEG
+
+const JpegCodec* LibjpegCodec() { return nullptr; }
+
+#endif  // IMAGE_PICKER_MASTER_HAVE_LIBJPEG
+
+const JpegCodec& DefaultJpegCodec() {
+  const JpegCodec* libjpeg = LibjpegCodec();
+  return libjpeg ? *libjpeg : GdkPixbufCodec();
+}
+
+}  // namespace image_picker_master
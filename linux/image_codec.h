@@ -0,0 +1,110 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_CODEC_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "image_buffer.h"
+
+namespace image_picker_master {
+
+// Chroma resolution of a JPEG's Cb and Cr planes relative to luma.
+enum class ChromaSubsampling {
+  k444,  // full resolution
+  k422,  // half width
+  k420,  // half width and height — what gdk-pixbuf always writes
+};
+
+struct JpegDecodeOptions {
+  int  scale_denom   = 1;      // 1, 2, 4 or 8, applied inside the IDCT
+  bool fast_dct      = false;  // integer "fast" IDCT: quicker, slightly lossy
+  bool fast_upsample = false;  // box chroma upsampling instead of triangle
+};
+
+struct JpegEncodeOptions {
+  int               quality     = 85;  // 0–100
+  ChromaSubsampling subsampling = ChromaSubsampling::k420;
+  bool              fast_dct    = false;  // integer "fast" forward DCT
+  // Several scans, coarse to fine, so a partial download already shows the
+  // whole image. Implies optimized Huffman tables.
+  bool              progressive = false;
+  // Huffman tables fitted to this image instead of the standard ones:
+  // typically 5-10% smaller, for a second pass over the coefficients.
+  bool              optimize_coding = false;
+};
+
+// YCbCr planes of a JPEG, as the codec works on them internally. Each
+// plane is padded to whole MCUs (right and bottom), which is what lets
+// them go straight back into EncodeYuv; only the top-left
+// plane_width × plane_height of each is image.
+struct YuvImage {
+  std::shared_ptr<uint8_t> storage;
+  uint8_t*          planes[3] = {nullptr, nullptr, nullptr};
+  int               strides[3] = {0, 0, 0};
+  int               rows[3] = {0, 0, 0};  // padded plane heights
+  int               width  = 0;
+  int               height = 0;
+  ChromaSubsampling subsampling = ChromaSubsampling::k420;
+
+  int plane_width(int plane) const;
+  int plane_height(int plane) const;
+  bool empty() const { return !planes[0]; }
+
+  // Zeroed planes for a |width| × |height| image, padded to whole MCUs.
+  static YuvImage Allocate(int width, int height, ChromaSubsampling subsampling);
+};
+
+// One JPEG implementation. Backends differ in what they can do; the
+// optional methods return false where a backend cannot, and options a
+// backend cannot honour are ignored. Thread-safe: each call is independent.
+class JpegCodec {
+ public:
+  virtual ~JpegCodec() = default;
+
+  virtual const char* name() const = 0;
+
+  // Decodes the JPEG in |data| to RGB. False for non-JPEG input or errors.
+  virtual bool Decode(const uint8_t* data, size_t size,
+                      const JpegDecodeOptions& options,
+                      ImageBuffer* out) const = 0;
+
+  // Encodes 3- or 4-channel |pixels| (alpha is dropped) into |out|.
+  virtual bool Encode(const ImageBuffer& pixels,
+                      const JpegEncodeOptions& options,
+                      std::vector<uint8_t>* out) const = 0;
+
+  // Decodes a YCbCr JPEG to its planes at full size, with no colour
+  // conversion or chroma upsampling. Only 4:4:4, 4:2:2 and 4:2:0 files.
+  virtual bool DecodeYuv(const uint8_t* /*data*/, size_t /*size*/,
+                         YuvImage* /*out*/) const {
+    return false;
+  }
+
+  // Encodes |yuv| as-is, keeping its subsampling; |options.subsampling| is
+  // ignored. Together with DecodeYuv this re-encodes a JPEG without leaving
+  // YCbCr.
+  virtual bool EncodeYuv(const YuvImage& /*yuv*/,
+                         const JpegEncodeOptions& /*options*/,
+                         std::vector<uint8_t>* /*out*/) const {
+    return false;
+  }
+};
+
+// libjpeg-turbo through its libjpeg API, or nullptr when the plugin was
+// built without libjpeg. Supports everything above.
+const JpegCodec* LibjpegCodec();
+
+// gdk-pixbuf's JPEG loader and saver. Decode scales through the loader's
+// size hint; Encode honours quality only (always baseline 4:2:0, standard
+// Huffman tables, accurate DCT); no YUV paths.
+const JpegCodec& GdkPixbufCodec();
+
+// The best available backend: LibjpegCodec() when built in, otherwise
+// GdkPixbufCodec().
+const JpegCodec& DefaultJpegCodec();
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_CODEC_H_
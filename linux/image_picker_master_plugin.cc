@@ -2,65 +2,226 @@
 
 #include <flutter_linux/flutter_linux.h>
 #include <gtk/gtk.h>
+#include <fcntl.h>
 #include <sys/utsname.h>
+#include <unistd.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <gio/gio.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
+#include <cerrno>
 #include <cstring>
 #include <memory>
 #include <vector>
 #include <string>
-#include <fstream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <cmath>
 #include <filesystem>
-
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include "decoded_image_cache.h"
+#include "exif_parser.h"
+#include "heif_decoder.h"
+#include "image_codec.h"
+#include "image_buffer.h"
+#include "image_probe.h"
+#include "image_resampler.h"
 #include "image_picker_master_plugin_private.h"
+#include "image_transform.h"
+#include "chunked_file_reader.h"
+#include "jpeg_decoder.h"
+#include "jpeg_lossless.h"
+#include "mapped_file.h"
+#include "preview_cache.h"
+#include "size_budget.h"
+#include "webp_encoder.h"
+#include "worker_pool.h"
+
+using image_picker_master::ChromaSubsampling;
+using image_picker_master::ChunkedFileReader;
+using image_picker_master::CropRotateScale;
+using image_picker_master::CropRotateScaleSpec;
+using image_picker_master::DecodeJpegRegion;
+using image_picker_master::DecodedImage;
+using image_picker_master::DecodedImageCache;
+using image_picker_master::ExifInfo;
+using image_picker_master::JpegCodec;
+using image_picker_master::JpegDecodeOptions;
+using image_picker_master::JpegEncodeOptions;
+using image_picker_master::ImageBuffer;
+using image_picker_master::ImageProbe;
+using image_picker_master::JpegRegion;
+using image_picker_master::JpegRegionDecodeAvailable;
+using image_picker_master::MappedFile;
+using image_picker_master::PixelRect;
+using image_picker_master::PreviewCache;
+using image_picker_master::PreviewKey;
+using image_picker_master::SourceStamp;
+using image_picker_master::WebpEncodeOptions;
+using image_picker_master::ResampleFilter;
+using image_picker_master::ResampleIsa;
+using image_picker_master::ResampleRegion;
+using image_picker_master::WorkerPool;
+using image_picker_master::YuvImage;
 
 #define IMAGE_PICKER_MASTER_PLUGIN(obj) \
   (G_TYPE_CHECK_INSTANCE_CAST((obj), image_picker_master_plugin_get_type(), \
                               ImagePickerMasterPlugin))
 
+// One readFileStream. Everything except |reader| is touched only on the
+// main context; workers just call reader->ReadChunk().
+struct FileStream {
+  guint64 id = 0;
+  std::unique_ptr<ChunkedFileReader> reader;
+  // "image_picker_master/file_stream/<id>"
+  FlEventChannel* channel = nullptr;
+  bool   listening = false;
+  bool   closed    = false;  // ended, failed or cancelled
+  size_t next_read = 0;      // next chunk to hand to the pool
+  size_t next_send = 0;      // next chunk to send, in file order
+  size_t acked     = 0;      // chunks Dart has taken
+  // Chunks read out of order, waiting for the ones before them.
+  std::map<size_t, std::vector<uint8_t>> ready;
+};
+
 struct _ImagePickerMasterPlugin {
   GObject parent_instance;
   std::vector<std::string>* temporary_files;
+  // Guards temporary_files — worker-pool jobs register their outputs too.
+  std::mutex* temp_files_mutex;
+  // "image_picker_master/pick_files_stream" — see pickFilesStream below.
+  FlEventChannel* pick_files_stream_channel;
+  // Bumped on every listen/cancel so events from an abandoned stream are
+  // dropped instead of leaking into the next one. Main context only.
+  guint64 pick_files_stream_generation;
+  // resizeImageForCropper results under /tmp/cropper_preview, keyed by
+  // source identity and maxSize.
+  PreviewCache* preview_cache;
+  // Decoded photos shared by resizeImageForCropper and cropImageNative.
+  DecodedImageCache* decoded_cache;
+  // Needed to create one event channel per readFileStream.
+  FlBinaryMessenger* messenger;
+  // Open readFileStream streams by id. Main context only.
+  std::map<guint64, std::shared_ptr<FileStream>>* file_streams;
+  guint64 next_file_stream_id;
 };
 
+// Disk budget for cached cropper previews.
+static constexpr uint64_t kPreviewCacheBytes = 64ull << 20;
+// Memory budget for decoded photos kept between resize and crop.
+static constexpr uint64_t kDecodedCacheBytes = 256ull << 20;
+// readFileStream chunk size when Dart does not pick one, and its bounds.
+static constexpr size_t kDefaultStreamChunkBytes = 4u << 20;
+static constexpr size_t kMinStreamChunkBytes = 64u << 10;
+static constexpr size_t kMaxStreamChunkBytes = 64u << 20;
+// Chunks a readFileStream may hold between disk and Dart before Dart
+// acknowledges one: reads in flight, read but unsent, and sent but unacked.
+static constexpr size_t kStreamWindowChunks = 4;
+// libwebp method (0-6) for compressed copies and for crops that do not pick
+// one: its default speed / size trade-off.
+static constexpr int kDefaultWebpEffort = 4;
+// Lowest quality a maxBytes search goes to before shrinking the image.
+static constexpr int kMinBudgetQuality = 40;
+// Below this density a picked image is already smaller than a JPEG of
+// nearly any photo would be, so allowCompression leaves it alone.
+static constexpr double kCompactBitsPerPixel = 0.4;
+
 G_DEFINE_TYPE(ImagePickerMasterPlugin, image_picker_master_plugin, g_object_get_type())
 
 // ─── Forward declarations ──────────────────────────────────────────────────
 
-static std::vector<uint8_t> read_file_bytes(const std::string& file_path);
+static GBytes* map_file_bytes(const std::string& file_path);
+static bool probe_image(const std::string& file_path, ImageProbe* probe);
+static void set_probe_fields(FlValue* map, const ImageProbe* probe);
+static bool read_exif(const std::string& file_path, const ImageProbe& probe,
+                      ExifInfo* exif);
+static void set_exif_fields(FlValue* map, const ExifInfo* exif);
 static bool is_image_file(const std::string& file_path);
 static std::string get_file_extension(const std::string& file_path);
 static std::string create_temp_file_path(const std::string& extension);
-static bool compress_image(const std::string& input_path,
-                           const std::string& output_path,
-                           int quality);
+static GBytes* bytes_from_vector(std::vector<uint8_t>&& data);
+static GBytes* encode_jpeg(const ImageBuffer& pixels, int quality,
+                           const JpegEncodeOptions& tuning = JpegEncodeOptions());
+static OutputFormat parse_output_format(const std::string& name);
+static const char* output_extension(OutputFormat format);
+static const char* output_mime_type(OutputFormat format);
+static GBytes* encode_image(const ImageBuffer& pixels, OutputFormat format,
+                            int quality, int effort,
+                            const JpegEncodeOptions& jpeg);
+static GBytes* encode_image_within(const ImageBuffer& pixels,
+                                   OutputFormat format, int quality,
+                                   int effort, const JpegEncodeOptions& jpeg,
+                                   int64_t max_bytes,
+                                   bool* over_budget = nullptr);
+static bool fit_dimensions(int width, int height,
+                           const FileMapOptions& options,
+                           int* fit_width, int* fit_height);
+static bool needs_compression(const std::string& file_path,
+                              const FileMapOptions& options,
+                              bool* keep_if_larger);
+static GBytes* compress_image(const std::string& input_path,
+                              const FileMapOptions& options);
 static void cleanup_temp_files(ImagePickerMasterPlugin* self);
+static void track_temp_file(ImagePickerMasterPlugin* self,
+                            const std::string& path);
 static FlMethodResponse* create_error_response(const std::string& code,
                                                const std::string& message);
 static std::string get_mime_type(const std::string& file_path);
 static FlValue* build_file_map(const std::string& file_path,
-                               bool with_data,
-                               bool allow_compression,
-                               int compression_quality,
+                               const FileMapOptions& options,
                                ImagePickerMasterPlugin* self);
 
+// Main-context / worker-pool plumbing
+static void post_to_main_context(std::function<void()> fn);
+static void respond_on_worker(ImagePickerMasterPlugin* self,
+                              FlMethodCall* method_call,
+                              std::function<FlMethodResponse*()> job);
+
 // Method handlers
-static FlMethodResponse* handle_pick_files(FlValue* arguments,
-                                           ImagePickerMasterPlugin* self);
-static FlMethodResponse* handle_capture_photo(FlValue* arguments,
-                                              ImagePickerMasterPlugin* self);
+static void parse_size_limits(FlValue* arguments, FileMapOptions* options);
+static bool parse_jpeg_options(FlValue* arguments, JpegEncodeOptions* jpeg);
+static FlMethodResponse* run_pick_files_dialog(
+    FlValue* arguments,
+    std::vector<std::string>* file_paths,
+    FileMapOptions* options);
+static void handle_pick_files(FlMethodCall* method_call,
+                              ImagePickerMasterPlugin* self);
+static void stream_picked_files(ImagePickerMasterPlugin* self,
+                                guint64 generation,
+                                std::vector<std::string> file_paths,
+                                const FileMapOptions& options);
+static void handle_capture_photo(FlMethodCall* method_call,
+                                 ImagePickerMasterPlugin* self);
 static FlMethodResponse* handle_clear_temporary_files(ImagePickerMasterPlugin* self);
+static bool preview_key_for(FlValue* arguments, PreviewKey* key);
 static FlMethodResponse* handle_resize_image_for_cropper(FlValue* arguments,
                                                          ImagePickerMasterPlugin* self);
-static FlMethodResponse* handle_crop_image_native(FlValue* arguments,
-                                                   ImagePickerMasterPlugin* self);
+static FlMethodResponse* handle_release_image_session(FlValue* arguments,
+                                                      ImagePickerMasterPlugin* self);
+static FlMethodResponse* handle_get_file_details(FlValue* arguments,
+                                                 ImagePickerMasterPlugin* self,
+                                                 FlMethodCall* method_call);
+static FlMethodResponse* handle_probe_images(FlValue* arguments,
+                                             ImagePickerMasterPlugin* self,
+                                             FlMethodCall* method_call);
+static FlMethodResponse* handle_open_file_stream(FlValue* arguments,
+                                                 ImagePickerMasterPlugin* self);
+static FlMethodResponse* handle_ack_file_stream(FlValue* arguments,
+                                                ImagePickerMasterPlugin* self);
+static void pump_file_stream(ImagePickerMasterPlugin* self,
+                             const std::shared_ptr<FileStream>& stream);
+static void finish_file_stream(const std::shared_ptr<FileStream>& stream);
 
 // ─── Method dispatch ───────────────────────────────────────────────────────
+// pickFiles / capturePhoto run their GTK dialog here on the main context and
+// hand the per-file work to the worker pool; resizeImageForCropper and
+// cropImageNative run entirely on the pool. Those handlers respond to
+// |method_call| themselves once the job finishes.
 
 static void image_picker_master_plugin_handle_method_call(
     ImagePickerMasterPlugin* self,
@@ -73,15 +234,46 @@ static void image_picker_master_plugin_handle_method_call(
   if (strcmp(method, "getPlatformVersion") == 0) {
     response = get_platform_version();
   } else if (strcmp(method, "pickFiles") == 0) {
-    response = handle_pick_files(arguments, self);
+    handle_pick_files(method_call, self);
+    return;
   } else if (strcmp(method, "capturePhoto") == 0) {
-    response = handle_capture_photo(arguments, self);
+    handle_capture_photo(method_call, self);
+    return;
   } else if (strcmp(method, "clearTemporaryFiles") == 0) {
     response = handle_clear_temporary_files(self);
   } else if (strcmp(method, "resizeImageForCropper") == 0) {
-    response = handle_resize_image_for_cropper(arguments, self);
+    // Reopening a photo is answered from the preview cache right here —
+    // a stat and a map lookup — without a trip through the pool.
+    PreviewKey key;
+    std::string cached;
+    if (preview_key_for(arguments, &key) &&
+        self->preview_cache->Lookup(key, &cached)) {
+      response = FL_METHOD_RESPONSE(
+          fl_method_success_response_new(fl_value_new_string(cached.c_str())));
+    } else {
+      // |arguments| is owned by |method_call|, which the job keeps alive.
+      respond_on_worker(self, method_call, [arguments, self]() {
+        return handle_resize_image_for_cropper(arguments, self);
+      });
+      return;
+    }
   } else if (strcmp(method, "cropImageNative") == 0) {
-    response = handle_crop_image_native(arguments, self);
+    respond_on_worker(self, method_call, [arguments, self]() {
+      return handle_crop_image_native(arguments, self);
+    });
+    return;
+  } else if (strcmp(method, "releaseImageSession") == 0) {
+    response = handle_release_image_session(arguments, self);
+  } else if (strcmp(method, "getFileDetails") == 0) {
+    response = handle_get_file_details(arguments, self, method_call);
+    if (!response) return;  // answered from the worker pool
+  } else if (strcmp(method, "probeImages") == 0) {
+    response = handle_probe_images(arguments, self, method_call);
+    if (!response) return;  // answered from the worker pool
+  } else if (strcmp(method, "openFileStream") == 0) {
+    response = handle_open_file_stream(arguments, self);
+  } else if (strcmp(method, "ackFileStream") == 0) {
+    response = handle_ack_file_stream(arguments, self);
   } else {
     response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
   }
@@ -89,6 +281,41 @@ static void image_picker_master_plugin_handle_method_call(
   fl_method_call_respond(method_call, response, nullptr);
 }
 
+// ─── Worker pool plumbing ──────────────────────────────────────────────────
+// Flutter's Linux embedder requires every fl_method_call_respond() to happen
+// on the GTK main context, so worker jobs hand their response back through
+// g_idle_add_full(), which is safe to call from any thread.
+
+static void post_to_main_context(std::function<void()> fn) {
+  auto* task = new std::function<void()>(std::move(fn));
+  g_idle_add_full(
+      G_PRIORITY_DEFAULT,
+      [](gpointer data) -> gboolean {
+        (*static_cast<std::function<void()>*>(data))();
+        return G_SOURCE_REMOVE;
+      },
+      task,
+      [](gpointer data) { delete static_cast<std::function<void()>*>(data); });
+}
+
+static void respond_on_worker(ImagePickerMasterPlugin* self,
+                              FlMethodCall* method_call,
+                              std::function<FlMethodResponse*()> job) {
+  // Both refs are dropped on the main context after responding, so the
+  // plugin cannot be disposed while a job still touches it.
+  g_object_ref(self);
+  g_object_ref(method_call);
+  WorkerPool::Shared().Submit([self, method_call, job = std::move(job)]() {
+    FlMethodResponse* response = job();
+    post_to_main_context([self, method_call, response]() {
+      fl_method_call_respond(method_call, response, nullptr);
+      g_object_unref(response);
+      g_object_unref(method_call);
+      g_object_unref(self);
+    });
+  });
+}
+
 // ─── getPlatformVersion ────────────────────────────────────────────────────
 
 FlMethodResponse* get_platform_version() {
@@ -107,10 +334,64 @@ static FlMethodResponse* handle_clear_temporary_files(ImagePickerMasterPlugin* s
   return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
 }
 
+// maxBytes, maxWidth, maxHeight and maxPixels, shared by pickFiles and
+// capturePhoto. Missing or negative values mean no limit.
+static void parse_size_limits(FlValue* arguments, FileMapOptions* options) {
+  auto get = [arguments](const char* key) -> int64_t {
+    FlValue* value = fl_value_lookup_string(arguments, key);
+    if (!value || fl_value_get_type(value) != FL_VALUE_TYPE_INT) return 0;
+    return std::max<int64_t>(0, fl_value_get_int(value));
+  };
+  options->max_bytes  = get("maxBytes");
+  options->max_width =
+      static_cast<int>(std::min<int64_t>(get("maxWidth"), G_MAXINT));
+  options->max_height =
+      static_cast<int>(std::min<int64_t>(get("maxHeight"), G_MAXINT));
+  options->max_pixels = get("maxPixels");
+}
+
+// The jpegOptions map of pickFiles, capturePhoto and cropImageNative:
+// progressive, optimizeHuffman and chromaSubsampling ("yuv420", "yuv422"
+// or "yuv444"). Returns whether a subsampling was given; without one the
+// encoder's 4:2:0 applies, except that a JPEG transcoded in YCbCr or
+// cropped losslessly keeps its own.
+static bool parse_jpeg_options(FlValue* arguments, JpegEncodeOptions* jpeg) {
+  FlValue* map = fl_value_lookup_string(arguments, "jpegOptions");
+  if (!map || fl_value_get_type(map) != FL_VALUE_TYPE_MAP) return false;
+  auto get_bool = [map](const char* key) {
+    FlValue* value = fl_value_lookup_string(map, key);
+    return value && fl_value_get_type(value) == FL_VALUE_TYPE_BOOL &&
+           fl_value_get_bool(value);
+  };
+  jpeg->progressive     = get_bool("progressive");
+  jpeg->optimize_coding = get_bool("optimizeHuffman");
+
+  FlValue* subsampling = fl_value_lookup_string(map, "chromaSubsampling");
+  if (!subsampling || fl_value_get_type(subsampling) != FL_VALUE_TYPE_STRING) {
+    return false;
+  }
+  const std::string name = fl_value_get_string(subsampling);
+  if (name == "yuv444") {
+    jpeg->subsampling = ChromaSubsampling::k444;
+  } else if (name == "yuv422") {
+    jpeg->subsampling = ChromaSubsampling::k422;
+  } else if (name == "yuv420") {
+    jpeg->subsampling = ChromaSubsampling::k420;
+  } else {
+    return false;
+  }
+  return true;
+}
+
 // ─── pickFiles ─────────────────────────────────────────────────────────────
+// Parses the FilePickerOptions map and runs the GTK chooser on the main
+// context. Returns an error response for invalid arguments, nullptr
+// otherwise; |file_paths| stays empty when the user cancels.
 
-static FlMethodResponse* handle_pick_files(FlValue* arguments,
-                                           ImagePickerMasterPlugin* self) {
+static FlMethodResponse* run_pick_files_dialog(
+    FlValue* arguments,
+    std::vector<std::string>* file_paths,
+    FileMapOptions* options) {
   if (fl_value_get_type(arguments) != FL_VALUE_TYPE_MAP) {
     return create_error_response("INVALID_ARGUMENTS", "Arguments must be a map");
   }
@@ -122,6 +403,8 @@ static FlMethodResponse* handle_pick_files(FlValue* arguments,
   FlValue* with_data_value        = fl_value_lookup_string(arguments, "withData");
   FlValue* allow_comp_value       = fl_value_lookup_string(arguments, "allowCompression");
   FlValue* comp_quality_value     = fl_value_lookup_string(arguments, "compressionQuality");
+  FlValue* comp_format_value      = fl_value_lookup_string(arguments, "compressionFormat");
+  FlValue* lazy_metadata_value    = fl_value_lookup_string(arguments, "lazyMetadata");
 
   std::string file_type = "all";
   if (file_type_value &&
@@ -147,25 +430,40 @@ static FlMethodResponse* handle_pick_files(FlValue* arguments,
     }
   }
 
-  bool with_data = false;
   if (with_data_value &&
       fl_value_get_type(with_data_value) == FL_VALUE_TYPE_BOOL) {
-    with_data = fl_value_get_bool(with_data_value);
+    options->with_data = fl_value_get_bool(with_data_value);
   }
 
-  bool allow_compression = false;
   if (allow_comp_value &&
       fl_value_get_type(allow_comp_value) == FL_VALUE_TYPE_BOOL) {
-    allow_compression = fl_value_get_bool(allow_comp_value);
+    options->allow_compression = fl_value_get_bool(allow_comp_value);
   }
 
   // Dart default is 80; align with that
-  int compression_quality = 80;
   if (comp_quality_value &&
       fl_value_get_type(comp_quality_value) == FL_VALUE_TYPE_INT) {
-    compression_quality = static_cast<int>(fl_value_get_int(comp_quality_value));
+    options->compression_quality =
+        static_cast<int>(fl_value_get_int(comp_quality_value));
+  }
+
+  // Compressed copies are JPEG or WebP; PNG is only offered for crops.
+  if (comp_format_value &&
+      fl_value_get_type(comp_format_value) == FL_VALUE_TYPE_STRING) {
+    OutputFormat format =
+        parse_output_format(fl_value_get_string(comp_format_value));
+    if (format != OutputFormat::kPng) options->compression_format = format;
   }
 
+  if (lazy_metadata_value &&
+      fl_value_get_type(lazy_metadata_value) == FL_VALUE_TYPE_BOOL) {
+    options->lazy_metadata = fl_value_get_bool(lazy_metadata_value);
+  }
+
+  parse_size_limits(arguments, options);
+  options->jpeg_subsampling_set =
+      parse_jpeg_options(arguments, &options->jpeg);
+
   // ── Build GTK file-chooser ──
   GtkWidget* dialog = gtk_file_chooser_dialog_new(
       "Select Files",
@@ -274,33 +572,347 @@ static FlMethodResponse* handle_pick_files(FlValue* arguments,
 
   if (run_result != GTK_RESPONSE_ACCEPT) {
     gtk_widget_destroy(dialog);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+    return nullptr;
   }
 
   GSList* filenames = gtk_file_chooser_get_filenames(GTK_FILE_CHOOSER(dialog));
   gtk_widget_destroy(dialog);
 
-  g_autoptr(FlValue) files_list = fl_value_new_list();
-
   for (GSList* l = filenames; l != nullptr; l = l->next) {
     gchar* filename = static_cast<gchar*>(l->data);
-    std::string file_path(filename);
+    file_paths->emplace_back(filename);
     g_free(filename);
+  }
+  g_slist_free(filenames);
+  return nullptr;
+}
 
-    FlValue* file_map = build_file_map(
-        file_path, with_data, allow_compression, compression_quality, self);
-    if (file_map) {
-      fl_value_append_take(files_list, file_map);
+static void handle_pick_files(FlMethodCall* method_call,
+                              ImagePickerMasterPlugin* self) {
+  std::vector<std::string> file_paths;
+  FileMapOptions options;
+  g_autoptr(FlMethodResponse) error = run_pick_files_dialog(
+      fl_method_call_get_args(method_call), &file_paths, &options);
+  if (error) {
+    fl_method_call_respond(method_call, error, nullptr);
+    return;
+  }
+  if (file_paths.empty()) {
+    g_autoptr(FlMethodResponse) response = FL_METHOD_RESPONSE(
+        fl_method_success_response_new(fl_value_new_null()));
+    fl_method_call_respond(method_call, response, nullptr);
+    return;
+  }
+
+  // Lazy selections need no I/O at all (path and name only), so they are
+  // answered right away instead of queueing behind other pool jobs.
+  if (options.lazy_metadata) {
+    g_autoptr(FlValue) files_list = fl_value_new_list();
+    for (const std::string& file_path : file_paths) {
+      fl_value_append_take(files_list,
+                           build_file_map(file_path, options, self));
     }
+    g_autoptr(FlMethodResponse) response = FL_METHOD_RESPONSE(
+        fl_method_success_response_new(files_list));
+    fl_method_call_respond(method_call, response, nullptr);
+    return;
   }
-  g_slist_free(filenames);
 
-  // Return null if nothing was collected (e.g. all files failed to process)
-  if (fl_value_get_length(files_list) == 0) {
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+  // ── Process selection off the main loop, one file per core ──
+  respond_on_worker(self, method_call,
+      [self, file_paths = std::move(file_paths),
+       options]() -> FlMethodResponse* {
+    g_autoptr(FlValue) files_list =
+        build_file_list(file_paths, options, WorkerPool::Shared(), self);
+
+    // Return null if nothing was collected (e.g. all files failed to process)
+    if (fl_value_get_length(files_list) == 0) {
+      return FL_METHOD_RESPONSE(
+          fl_method_success_response_new(fl_value_new_null()));
+    }
+
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(files_list));
+  });
+}
+
+// ─── pickFilesStream ───────────────────────────────────────────────────────
+// EventChannel variant of pickFiles. Each file is its own worker-pool job
+// and is sent as soon as it is ready, so time-to-first-result no longer
+// depends on the slowest file in the selection. Events:
+//   {type: "file", index: <selection index>, file: <PickedFile map>}
+//   {type: "done", count: <files sent>}   followed by end-of-stream.
+// Files arrive in completion order; |index| gives the selection order.
+
+static FlMethodErrorResponse* pick_files_stream_listen_cb(
+    FlEventChannel* channel, FlValue* args, gpointer user_data) {
+  ImagePickerMasterPlugin* self = IMAGE_PICKER_MASTER_PLUGIN(user_data);
+  guint64 generation = ++self->pick_files_stream_generation;
+  FlValue* arguments = args ? fl_value_ref(args) : fl_value_new_null();
+
+  // Defer the dialog so the listen call is acknowledged before GTK spins
+  // its nested loop.
+  g_object_ref(self);
+  post_to_main_context([self, generation, arguments]() {
+    std::vector<std::string> file_paths;
+    FileMapOptions options;
+    g_autoptr(FlMethodResponse) error =
+        run_pick_files_dialog(arguments, &file_paths, &options);
+    fl_value_unref(arguments);
+
+    if (generation == self->pick_files_stream_generation) {
+      if (error) {
+        fl_event_channel_send_error(self->pick_files_stream_channel,
+                                    "INVALID_ARGUMENTS",
+                                    "Invalid pickFilesStream arguments",
+                                    nullptr, nullptr, nullptr);
+        fl_event_channel_send_end_of_stream(self->pick_files_stream_channel,
+                                            nullptr, nullptr);
+      } else {
+        stream_picked_files(self, generation, std::move(file_paths), options);
+      }
+    }
+    g_object_unref(self);
+  });
+  return nullptr;
+}
+
+static FlMethodErrorResponse* pick_files_stream_cancel_cb(
+    FlEventChannel* channel, FlValue* args, gpointer user_data) {
+  ImagePickerMasterPlugin* self = IMAGE_PICKER_MASTER_PLUGIN(user_data);
+  // In-flight jobs still finish (their temp files stay tracked); only the
+  // events are dropped.
+  self->pick_files_stream_generation++;
+  return nullptr;
+}
+
+static void stream_picked_files(ImagePickerMasterPlugin* self,
+                                guint64 generation,
+                                std::vector<std::string> file_paths,
+                                const FileMapOptions& options) {
+  struct StreamState {
+    size_t remaining;
+    size_t sent = 0;
+  };
+  auto state = std::make_shared<StreamState>(StreamState{file_paths.size()});
+
+  auto finish = [self, generation, state]() {
+    if (generation != self->pick_files_stream_generation) return;
+    g_autoptr(FlValue) done = fl_value_new_map();
+    fl_value_set_string_take(done, "type", fl_value_new_string("done"));
+    fl_value_set_string_take(done, "count",
+        fl_value_new_int(static_cast<int64_t>(state->sent)));
+    fl_event_channel_send(self->pick_files_stream_channel, done,
+                          nullptr, nullptr);
+    fl_event_channel_send_end_of_stream(self->pick_files_stream_channel,
+                                        nullptr, nullptr);
+  };
+
+  if (file_paths.empty()) {
+    finish();
+    return;
+  }
+
+  for (size_t i = 0; i < file_paths.size(); i++) {
+    g_object_ref(self);
+    WorkerPool::Shared().Submit(
+        [self, generation, state, finish, i, options,
+         file_path = std::move(file_paths[i])]() {
+      FlValue* file_map = build_file_map(file_path, options, self);
+      post_to_main_context([self, generation, state, finish, i, file_map]() {
+        if (file_map && generation == self->pick_files_stream_generation) {
+          g_autoptr(FlValue) event = fl_value_new_map();
+          fl_value_set_string_take(event, "type", fl_value_new_string("file"));
+          fl_value_set_string_take(event, "index",
+              fl_value_new_int(static_cast<int64_t>(i)));
+          fl_value_set_string(event, "file", file_map);
+          fl_event_channel_send(self->pick_files_stream_channel, event,
+                                nullptr, nullptr);
+          state->sent++;
+        }
+        if (file_map) fl_value_unref(file_map);
+        if (--state->remaining == 0) finish();
+        g_object_unref(self);
+      });
+    });
+  }
+}
+
+// ─── readFileStream ────────────────────────────────────────────────────────
+// Streams a file to Dart in fixed-size chunks instead of one `bytes` value.
+// openFileStream opens the file and creates a dedicated event channel,
+// "image_picker_master/file_stream/<id>"; listening starts the reads. Each
+// event is one chunk (Uint8List) in file order, then end-of-stream.
+//
+// Flow control is credit based: at most kStreamWindowChunks chunks are read
+// ahead of what Dart has acknowledged with ackFileStream, so memory stays at
+// a few chunks whatever the file size, and a paused Dart listener stops the
+// disk reads. Chunks are read on the worker pool while earlier ones are in
+// flight to Dart.
+
+static std::shared_ptr<FileStream> find_file_stream(
+    ImagePickerMasterPlugin* self, FlEventChannel* channel) {
+  for (const auto& [id, stream] : *self->file_streams) {
+    if (stream->channel == channel) return stream;
+  }
+  return nullptr;
+}
+
+static FlMethodErrorResponse* file_stream_listen_cb(
+    FlEventChannel* channel, FlValue* args, gpointer user_data) {
+  ImagePickerMasterPlugin* self = IMAGE_PICKER_MASTER_PLUGIN(user_data);
+  std::shared_ptr<FileStream> stream = find_file_stream(self, channel);
+  if (!stream) {
+    return fl_method_error_response_new("NO_STREAM", "File stream is closed",
+                                        nullptr);
+  }
+  stream->listening = true;
+  pump_file_stream(self, stream);
+  return nullptr;
+}
+
+static FlMethodErrorResponse* file_stream_cancel_cb(
+    FlEventChannel* channel, FlValue* args, gpointer user_data) {
+  ImagePickerMasterPlugin* self = IMAGE_PICKER_MASTER_PLUGIN(user_data);
+  std::shared_ptr<FileStream> stream = find_file_stream(self, channel);
+  if (!stream) return nullptr;
+
+  // Dart cancels after end-of-stream too, so this is where every stream is
+  // forgotten. The channel is released from a later idle callback rather
+  // than inside its own handler.
+  finish_file_stream(stream);
+  self->file_streams->erase(stream->id);
+  FlEventChannel* stream_channel = stream->channel;
+  post_to_main_context([stream_channel]() { g_object_unref(stream_channel); });
+  return nullptr;
+}
+
+static FlMethodResponse* handle_open_file_stream(FlValue* arguments,
+                                                 ImagePickerMasterPlugin* self) {
+  if (fl_value_get_type(arguments) != FL_VALUE_TYPE_MAP) {
+    return create_error_response("INVALID_ARGUMENTS", "Expected a map");
+  }
+  FlValue* path_value = fl_value_lookup_string(arguments, "path");
+  if (!path_value || fl_value_get_type(path_value) != FL_VALUE_TYPE_STRING) {
+    return create_error_response("INVALID_ARGUMENTS", "path is required");
+  }
+
+  size_t chunk_size = kDefaultStreamChunkBytes;
+  FlValue* chunk_value = fl_value_lookup_string(arguments, "chunkSize");
+  if (chunk_value && fl_value_get_type(chunk_value) == FL_VALUE_TYPE_INT) {
+    chunk_size = static_cast<size_t>(std::clamp<int64_t>(
+        fl_value_get_int(chunk_value),
+        static_cast<int64_t>(kMinStreamChunkBytes),
+        static_cast<int64_t>(kMaxStreamChunkBytes)));
+  }
+
+  const gchar* path = fl_value_get_string(path_value);
+  auto stream = std::make_shared<FileStream>();
+  stream->reader = ChunkedFileReader::Open(path, chunk_size);
+  if (!stream->reader) {
+    return create_error_response("OPEN_FAILED",
+                                 std::string("Cannot open file: ") + path);
+  }
+
+  stream->id = ++self->next_file_stream_id;
+  g_autofree gchar* name = g_strdup_printf(
+      "image_picker_master/file_stream/%" G_GUINT64_FORMAT, stream->id);
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  stream->channel =
+      fl_event_channel_new(self->messenger, name, FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(stream->channel, file_stream_listen_cb,
+                                       file_stream_cancel_cb, self, nullptr);
+  self->file_streams->emplace(stream->id, stream);
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "id",
+      fl_value_new_int(static_cast<int64_t>(stream->id)));
+  fl_value_set_string_take(result, "size",
+      fl_value_new_int(stream->reader->size()));
+  fl_value_set_string_take(result, "chunkSize",
+      fl_value_new_int(static_cast<int64_t>(chunk_size)));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* handle_ack_file_stream(FlValue* arguments,
+                                                ImagePickerMasterPlugin* self) {
+  FlValue* id_value = fl_value_get_type(arguments) == FL_VALUE_TYPE_MAP
+      ? fl_value_lookup_string(arguments, "id")
+      : nullptr;
+  if (!id_value || fl_value_get_type(id_value) != FL_VALUE_TYPE_INT) {
+    return create_error_response("INVALID_ARGUMENTS", "id is required");
+  }
+  FlValue* count_value = fl_value_lookup_string(arguments, "count");
+  int64_t count = count_value &&
+                          fl_value_get_type(count_value) == FL_VALUE_TYPE_INT
+      ? fl_value_get_int(count_value)
+      : 1;
+
+  // Acks racing a finished or cancelled stream are ignored.
+  auto it = self->file_streams->find(
+      static_cast<guint64>(fl_value_get_int(id_value)));
+  if (it != self->file_streams->end() && count > 0) {
+    std::shared_ptr<FileStream> stream = it->second;
+    stream->acked = std::min(stream->next_send,
+                             stream->acked + static_cast<size_t>(count));
+    pump_file_stream(self, stream);
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(nullptr));
+}
+
+// Sends every chunk that is next in file order, then tops the read-ahead
+// back up to the window.
+static void pump_file_stream(ImagePickerMasterPlugin* self,
+                             const std::shared_ptr<FileStream>& stream) {
+  if (stream->closed || !stream->listening) return;
+  const size_t count = stream->reader->chunk_count();
+
+  while (!stream->ready.empty() &&
+         stream->ready.begin()->first == stream->next_send) {
+    std::vector<uint8_t>& chunk = stream->ready.begin()->second;
+    g_autoptr(FlValue) event = fl_value_new_uint8_list(chunk.data(),
+                                                       chunk.size());
+    fl_event_channel_send(stream->channel, event, nullptr, nullptr);
+    stream->ready.erase(stream->ready.begin());
+    stream->next_send++;
   }
+  if (stream->next_send == count) {
+    fl_event_channel_send_end_of_stream(stream->channel, nullptr, nullptr);
+    finish_file_stream(stream);
+    return;
+  }
+
+  while (stream->next_read < count &&
+         stream->next_read - stream->acked < kStreamWindowChunks) {
+    size_t index = stream->next_read++;
+    g_object_ref(self);
+    WorkerPool::Shared().Submit([self, stream, index]() {
+      auto chunk = std::make_shared<std::vector<uint8_t>>();
+      bool ok = stream->reader->ReadChunk(index, chunk.get());
+      post_to_main_context([self, stream, index, chunk, ok]() {
+        if (stream->closed) {
+          // Finished or cancelled while this read was in flight.
+        } else if (!ok) {
+          fl_event_channel_send_error(stream->channel, "READ_FAILED",
+                                      "Failed to read file chunk", nullptr,
+                                      nullptr, nullptr);
+          fl_event_channel_send_end_of_stream(stream->channel, nullptr,
+                                              nullptr);
+          finish_file_stream(stream);
+        } else {
+          stream->ready.emplace(index, std::move(*chunk));
+          pump_file_stream(self, stream);
+        }
+        g_object_unref(self);
+      });
+    });
+  }
+}
 
-  return FL_METHOD_RESPONSE(fl_method_success_response_new(files_list));
+// Stops reading and drops buffered chunks. The stream stays registered
+// (with its channel) until Dart cancels it.
+static void finish_file_stream(const std::shared_ptr<FileStream>& stream) {
+  stream->closed = true;
+  stream->ready.clear();
 }
 
 // ─── capturePhoto ──────────────────────────────────────────────────────────
@@ -309,34 +921,41 @@ static FlMethodResponse* handle_pick_files(FlValue* arguments,
 // capturePhoto() contract. This mirrors the macOS/Windows behaviour where
 // camera capture is not always available.
 
-static FlMethodResponse* handle_capture_photo(FlValue* arguments,
-                                              ImagePickerMasterPlugin* self) {
+static void handle_capture_photo(FlMethodCall* method_call,
+                                 ImagePickerMasterPlugin* self) {
+  FlValue* arguments = fl_method_call_get_args(method_call);
   if (fl_value_get_type(arguments) != FL_VALUE_TYPE_MAP) {
-    return create_error_response("INVALID_ARGUMENTS", "Arguments must be a map");
+    g_autoptr(FlMethodResponse) response = create_error_response(
+        "INVALID_ARGUMENTS", "Arguments must be a map");
+    fl_method_call_respond(method_call, response, nullptr);
+    return;
   }
 
   FlValue* allow_comp_value   = fl_value_lookup_string(arguments, "allowCompression");
   FlValue* comp_quality_value = fl_value_lookup_string(arguments, "compressionQuality");
   FlValue* with_data_value    = fl_value_lookup_string(arguments, "withData");
 
-  bool allow_compression = true;
+  FileMapOptions options;
+  options.allow_compression = true;
   if (allow_comp_value &&
       fl_value_get_type(allow_comp_value) == FL_VALUE_TYPE_BOOL) {
-    allow_compression = fl_value_get_bool(allow_comp_value);
+    options.allow_compression = fl_value_get_bool(allow_comp_value);
   }
 
-  int compression_quality = 80;
   if (comp_quality_value &&
       fl_value_get_type(comp_quality_value) == FL_VALUE_TYPE_INT) {
-    compression_quality = static_cast<int>(fl_value_get_int(comp_quality_value));
+    options.compression_quality =
+        static_cast<int>(fl_value_get_int(comp_quality_value));
   }
 
-  bool with_data = false;
   if (with_data_value &&
       fl_value_get_type(with_data_value) == FL_VALUE_TYPE_BOOL) {
-    with_data = fl_value_get_bool(with_data_value);
+    options.with_data = fl_value_get_bool(with_data_value);
   }
 
+  parse_size_limits(arguments, &options);
+  options.jpeg_subsampling_set = parse_jpeg_options(arguments, &options.jpeg);
+
   // Open image-only file picker as camera fallback
   GtkWidget* dialog = gtk_file_chooser_dialog_new(
       "Select a Photo",
@@ -355,50 +974,115 @@ static FlMethodResponse* handle_capture_photo(FlValue* arguments,
 
   gint run_result = gtk_dialog_run(GTK_DIALOG(dialog));
 
-  if (run_result != GTK_RESPONSE_ACCEPT) {
-    gtk_widget_destroy(dialog);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+  gchar* filename = nullptr;
+  if (run_result == GTK_RESPONSE_ACCEPT) {
+    filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
   }
-
-  gchar* filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
   gtk_widget_destroy(dialog);
 
   if (!filename) {
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+    g_autoptr(FlMethodResponse) response = FL_METHOD_RESPONSE(
+        fl_method_success_response_new(fl_value_new_null()));
+    fl_method_call_respond(method_call, response, nullptr);
+    return;
   }
 
   std::string file_path(filename);
   g_free(filename);
 
-  // Build single map — capturePhoto returns Map, not List
-  FlValue* file_map = build_file_map(
-      file_path, with_data, allow_compression, compression_quality, self);
-  if (!file_map) {
-    return create_error_response("FILE_PROCESSING_ERROR",
-                                 "Failed to process the selected file");
-  }
+  respond_on_worker(self, method_call,
+      [self, file_path, options]() -> FlMethodResponse* {
+    // Build single map — capturePhoto returns Map, not List
+    FlValue* file_map = build_file_map(file_path, options, self);
+    if (!file_map) {
+      return create_error_response("FILE_PROCESSING_ERROR",
+                                   "Failed to process the selected file");
+    }
 
-  return FL_METHOD_RESPONSE(fl_method_success_response_new(file_map));
+    g_autoptr(FlValue) result = file_map;
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  });
+}
+
+// ─── build_file_list ───────────────────────────────────────────────────────
+// Every file is independent (stat, MIME guess, optional recompress, optional
+// read), so the selection is fanned out with ParallelFor. Maps land in a
+// slot per index and are appended afterwards to keep selection order.
+
+FlValue* build_file_list(const std::vector<std::string>& file_paths,
+                         const FileMapOptions& options,
+                         WorkerPool& pool,
+                         ImagePickerMasterPlugin* self) {
+  std::vector<FlValue*> file_maps(file_paths.size(), nullptr);
+  pool.ParallelFor(file_paths.size(), [&](size_t i) {
+    file_maps[i] = build_file_map(file_paths[i], options, self);
+  });
+
+  FlValue* files_list = fl_value_new_list();
+  for (FlValue* file_map : file_maps) {
+    if (file_map) {
+      fl_value_append_take(files_list, file_map);
+    }
+  }
+  return files_list;
 }
 
 // ─── build_file_map ────────────────────────────────────────────────────────
 // Constructs the map returned to Dart's PickedFile.fromMap().
-// Keys: path, name, size, mimeType, bytes (Uint8List when withData=true).
+// Keys: path, name, size, mimeType, bytes (Uint8List when withData=true),
+// and for images width, height, format and hasAlpha from a header probe.
+// With lazyMetadata only path and name are filled in, without touching the
+// file; size, mimeType and bytes are null until getFileDetails.
+// A compressed image is encoded in memory: the copy is written to its temp
+// path once, and size / mimeType / bytes come from that buffer rather than
+// from a stat and a read-back of the file.
+// Thread-safe: called concurrently from build_file_list.
 
 static FlValue* build_file_map(const std::string& file_path,
-                               bool with_data,
-                               bool allow_compression,
-                               int compression_quality,
+                               const FileMapOptions& options,
                                ImagePickerMasterPlugin* self) {
+  if (options.lazy_metadata) {
+    FlValue* file_map = fl_value_new_map();
+    fl_value_set_string_take(file_map, "path",
+        fl_value_new_string(file_path.c_str()));
+    fl_value_set_string_take(file_map, "name",
+        fl_value_new_string(
+            std::filesystem::path(file_path).filename().string().c_str()));
+    fl_value_set_string_take(file_map, "size", fl_value_new_null());
+    fl_value_set_string_take(file_map, "mimeType", fl_value_new_null());
+    fl_value_set_string_take(file_map, "bytes", fl_value_new_null());
+    return file_map;
+  }
+
   // Resolve the actual path to read from (may be a compressed copy)
   std::string read_path = file_path;
+  g_autoptr(GBytes) compressed = nullptr;
 
-  if (allow_compression && is_image_file(file_path)) {
-    std::string temp_path = create_temp_file_path("jpg");
-    if (compress_image(file_path, temp_path, compression_quality)) {
-      // Track the temp file for later cleanup
-      self->temporary_files->push_back(temp_path);
-      read_path = temp_path;
+  bool keep_if_larger = false;
+  if (needs_compression(file_path, options, &keep_if_larger)) {
+    compressed = compress_image(file_path, options);
+    // A copy larger than the original saves nothing, and is dropped
+    // unless it had to be made.
+    std::error_code ec;
+    const uintmax_t original_size = std::filesystem::file_size(file_path, ec);
+    if (compressed && !keep_if_larger && !ec &&
+        g_bytes_get_size(compressed) >= original_size) {
+      g_clear_pointer(&compressed, g_bytes_unref);
+    }
+    if (compressed) {
+      std::string temp_path =
+          create_temp_file_path(output_extension(options.compression_format));
+      gsize length = 0;
+      const gchar* data =
+          static_cast<const gchar*>(g_bytes_get_data(compressed, &length));
+      if (g_file_set_contents(temp_path.c_str(), data,
+                              static_cast<gssize>(length), nullptr)) {
+        // Track the temp file for later cleanup
+        track_temp_file(self, temp_path);
+        read_path = temp_path;
+      } else {
+        g_clear_pointer(&compressed, g_bytes_unref);
+      }
     }
   }
 
@@ -408,14 +1092,46 @@ static FlValue* build_file_map(const std::string& file_path,
 
   // File size
   int64_t file_size = 0;
-  try {
-    file_size = static_cast<int64_t>(std::filesystem::file_size(read_path));
-  } catch (...) {
-    file_size = 0;
+  if (compressed) {
+    file_size = static_cast<int64_t>(g_bytes_get_size(compressed));
+  } else {
+    try {
+      file_size = static_cast<int64_t>(std::filesystem::file_size(read_path));
+    } catch (...) {
+      file_size = 0;
+    }
   }
 
   // MIME type via GLib content-type detection
-  std::string mime_type = get_mime_type(read_path);
+  std::string mime_type = compressed
+      ? output_mime_type(options.compression_format)
+      : get_mime_type(read_path);
+
+  // Image header — a few KB at most, never a decode
+  ImageProbe probe;
+  bool probed = false;
+  if (compressed) {
+    gsize length = 0;
+    const uint8_t* data =
+        static_cast<const uint8_t*>(g_bytes_get_data(compressed, &length));
+    probed = image_picker_master::ProbeImageData(data, length, &probe);
+  } else if (is_image_file(read_path)) {
+    probed = probe_image(read_path, &probe);
+  }
+
+  // EXIF of the picked file. A compressed copy has no EXIF of its own, but
+  // compress_image already turned its pixels upright, and its thumbnail
+  // offset would point into the original.
+  ExifInfo exif;
+  bool has_exif = false;
+  if (compressed) {
+    has_exif = image_picker_master::ReadExif(file_path, &exif);
+    exif.orientation      = 1;
+    exif.thumbnail_offset = 0;
+    exif.thumbnail_length = 0;
+  } else if (probed) {
+    has_exif = read_exif(read_path, probe, &exif);
+  }
 
   FlValue* file_map = fl_value_new_map();
   fl_value_set_string_take(file_map, "path",
@@ -428,17 +1144,19 @@ static FlValue* build_file_map(const std::string& file_path,
       mime_type.empty()
           ? fl_value_new_null()
           : fl_value_new_string(mime_type.c_str()));
-
-  if (with_data) {
-    try {
-      std::vector<uint8_t> bytes = read_file_bytes(read_path);
-      // Send as Uint8List — Flutter StandardMethodCodec deserialises this
-      // directly to Dart Uint8List, matching PickedFile.bytes type.
-      fl_value_set_string_take(file_map, "bytes",
-          fl_value_new_uint8_list(bytes.data(), bytes.size()));
-    } catch (...) {
-      fl_value_set_string_take(file_map, "bytes", fl_value_new_null());
-    }
+  set_probe_fields(file_map, probed ? &probe : nullptr);
+  set_exif_fields(file_map, has_exif ? &exif : nullptr);
+
+  if (options.with_data) {
+    // Send as Uint8List — Flutter StandardMethodCodec deserialises this
+    // directly to Dart Uint8List, matching PickedFile.bytes type. The
+    // FlValue takes the only heap copy: the source is either the encode
+    // buffer or a page-cache mapping that is unmapped right after.
+    g_autoptr(GBytes) bytes =
+        compressed ? g_bytes_ref(compressed) : map_file_bytes(read_path);
+    fl_value_set_string_take(file_map, "bytes",
+        bytes ? fl_value_new_uint8_list_from_bytes(bytes)
+              : fl_value_new_null());
   } else {
     fl_value_set_string_take(file_map, "bytes", fl_value_new_null());
   }
@@ -446,8 +1164,214 @@ static FlValue* build_file_map(const std::string& file_path,
   return file_map;
 }
 
+// ─── getFileDetails ────────────────────────────────────────────────────────
+// Batched, on-demand counterpart of build_file_map for lazy selections.
+// Only the requested fields are computed, so asking for mimeType alone
+// does no I/O at all (the guess is by file name), and size is one stat.
+// Dimensions (with format, hasAlpha and the EXIF fields) come from the
+// image header probe.
+
+static FlValue* build_file_detail_map(const std::string& file_path,
+                                      const FileDetailFields& fields) {
+  FlValue* details = fl_value_new_map();
+  fl_value_set_string_take(details, "path",
+      fl_value_new_string(file_path.c_str()));
+  fl_value_set_string_take(details, "name",
+      fl_value_new_string(
+          std::filesystem::path(file_path).filename().string().c_str()));
+
+  if (fields.size) {
+    GStatBuf st;
+    fl_value_set_string_take(details, "size",
+        g_stat(file_path.c_str(), &st) == 0
+            ? fl_value_new_int(static_cast<int64_t>(st.st_size))
+            : fl_value_new_null());
+  }
+  if (fields.mime_type) {
+    std::string mime_type = get_mime_type(file_path);
+    fl_value_set_string_take(details, "mimeType",
+        mime_type.empty() ? fl_value_new_null()
+                          : fl_value_new_string(mime_type.c_str()));
+  }
+  if (fields.dimensions) {
+    ImageProbe probe;
+    bool known = is_image_file(file_path) && probe_image(file_path, &probe);
+    set_probe_fields(details, known ? &probe : nullptr);
+    ExifInfo exif;
+    bool has_exif = known && read_exif(file_path, probe, &exif);
+    set_exif_fields(details, has_exif ? &exif : nullptr);
+  }
+  if (fields.bytes) {
+    g_autoptr(GBytes) bytes = map_file_bytes(file_path);
+    fl_value_set_string_take(details, "bytes",
+        bytes ? fl_value_new_uint8_list_from_bytes(bytes)
+              : fl_value_new_null());
+  }
+  return details;
+}
+
+FlValue* build_file_details(const std::vector<std::string>& file_paths,
+                            const FileDetailFields& fields,
+                            WorkerPool& pool) {
+  std::vector<FlValue*> maps(file_paths.size(), nullptr);
+  pool.ParallelFor(file_paths.size(), [&](size_t i) {
+    maps[i] = build_file_detail_map(file_paths[i], fields);
+  });
+
+  FlValue* list = fl_value_new_list();
+  for (FlValue* details : maps) fl_value_append_take(list, details);
+  return list;
+}
+
+// Returns an error response for bad arguments, or nullptr once the work
+// has been handed to the pool (which responds to |method_call| itself).
+static FlMethodResponse* handle_get_file_details(FlValue* arguments,
+                                                 ImagePickerMasterPlugin* self,
+                                                 FlMethodCall* method_call) {
+  FlValue* paths_value = fl_value_get_type(arguments) == FL_VALUE_TYPE_MAP
+      ? fl_value_lookup_string(arguments, "paths")
+      : nullptr;
+  if (!paths_value || fl_value_get_type(paths_value) != FL_VALUE_TYPE_LIST) {
+    return create_error_response("INVALID_ARGUMENTS", "paths is required");
+  }
+
+  std::vector<std::string> file_paths;
+  for (size_t i = 0; i < fl_value_get_length(paths_value); i++) {
+    FlValue* path = fl_value_get_list_value(paths_value, i);
+    if (fl_value_get_type(path) != FL_VALUE_TYPE_STRING) {
+      return create_error_response("INVALID_ARGUMENTS",
+                                   "paths must be strings");
+    }
+    file_paths.emplace_back(fl_value_get_string(path));
+  }
+
+  FileDetailFields fields;
+  FlValue* fields_value = fl_value_lookup_string(arguments, "fields");
+  if (fields_value && fl_value_get_type(fields_value) == FL_VALUE_TYPE_LIST) {
+    for (size_t i = 0; i < fl_value_get_length(fields_value); i++) {
+      FlValue* field = fl_value_get_list_value(fields_value, i);
+      if (fl_value_get_type(field) != FL_VALUE_TYPE_STRING) continue;
+      const gchar* name = fl_value_get_string(field);
+      if (strcmp(name, "size") == 0)            fields.size = true;
+      else if (strcmp(name, "mimeType") == 0)   fields.mime_type = true;
+      else if (strcmp(name, "dimensions") == 0) fields.dimensions = true;
+      else if (strcmp(name, "bytes") == 0)      fields.bytes = true;
+    }
+  }
+
+  respond_on_worker(self, method_call,
+      [file_paths = std::move(file_paths), fields]() -> FlMethodResponse* {
+    g_autoptr(FlValue) list =
+        build_file_details(file_paths, fields, WorkerPool::Shared());
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(list));
+  });
+  return nullptr;
+}
+
+// ─── probeImages ───────────────────────────────────────────────────────────
+// Header-only width / height / format / hasAlpha for a batch of paths. The
+// file's content decides, not its extension; non-images get nulls.
+
+static FlMethodResponse* handle_probe_images(FlValue* arguments,
+                                             ImagePickerMasterPlugin* self,
+                                             FlMethodCall* method_call) {
+  FlValue* paths_value = fl_value_get_type(arguments) == FL_VALUE_TYPE_MAP
+      ? fl_value_lookup_string(arguments, "paths")
+      : nullptr;
+  if (!paths_value || fl_value_get_type(paths_value) != FL_VALUE_TYPE_LIST) {
+    return create_error_response("INVALID_ARGUMENTS", "paths is required");
+  }
+
+  std::vector<std::string> file_paths;
+  for (size_t i = 0; i < fl_value_get_length(paths_value); i++) {
+    FlValue* path = fl_value_get_list_value(paths_value, i);
+    if (fl_value_get_type(path) != FL_VALUE_TYPE_STRING) {
+      return create_error_response("INVALID_ARGUMENTS",
+                                   "paths must be strings");
+    }
+    file_paths.emplace_back(fl_value_get_string(path));
+  }
+
+  respond_on_worker(self, method_call,
+      [file_paths = std::move(file_paths)]() -> FlMethodResponse* {
+    std::vector<FlValue*> maps(file_paths.size(), nullptr);
+    WorkerPool::Shared().ParallelFor(file_paths.size(), [&](size_t i) {
+      ImageProbe probe;
+      bool known = probe_image(file_paths[i], &probe);
+      maps[i] = fl_value_new_map();
+      fl_value_set_string_take(maps[i], "path",
+          fl_value_new_string(file_paths[i].c_str()));
+      set_probe_fields(maps[i], known ? &probe : nullptr);
+    });
+
+    g_autoptr(FlValue) list = fl_value_new_list();
+    for (FlValue* map : maps) fl_value_append_take(list, map);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(list));
+  });
+  return nullptr;
+}
+
 // ─── Helpers ───────────────────────────────────────────────────────────────
 
+// Reads |file_path|'s header with the built-in parsers, falling back to
+// gdk-pixbuf's loaders (which also only read the header) for formats they
+// do not know. The fallback cannot tell whether there is alpha.
+static bool probe_image(const std::string& file_path, ImageProbe* probe) {
+  if (image_picker_master::ProbeImage(file_path, probe)) return true;
+  if (image_picker_master::ProbeHeif(file_path, probe)) return true;
+
+  int width = 0, height = 0;
+  GdkPixbufFormat* format =
+      gdk_pixbuf_get_file_info(file_path.c_str(), &width, &height);
+  if (!format || width <= 0 || height <= 0) return false;
+  g_autofree gchar* name = gdk_pixbuf_format_get_name(format);
+  probe->format = name ? name : "";
+  probe->width = width;
+  probe->height = height;
+  probe->has_alpha = false;
+  return true;
+}
+
+// Sets width, height, format and hasAlpha on |map|, or nulls when |probe|
+// is nullptr.
+static void set_probe_fields(FlValue* map, const ImageProbe* probe) {
+  fl_value_set_string_take(map, "width",
+      probe ? fl_value_new_int(probe->width) : fl_value_new_null());
+  fl_value_set_string_take(map, "height",
+      probe ? fl_value_new_int(probe->height) : fl_value_new_null());
+  fl_value_set_string_take(map, "format",
+      probe ? fl_value_new_string(probe->format.c_str()) : fl_value_new_null());
+  fl_value_set_string_take(map, "hasAlpha",
+      probe ? fl_value_new_bool(probe->has_alpha) : fl_value_new_null());
+}
+
+// EXIF lives in JPEG APP1 segments and TIFF IFDs; other formats are not
+// looked at.
+static bool read_exif(const std::string& file_path, const ImageProbe& probe,
+                      ExifInfo* exif) {
+  if (probe.format != "jpeg" && probe.format != "tiff") return false;
+  return image_picker_master::ReadExif(file_path, exif);
+}
+
+// Sets orientation, dateTimeOriginal, exifThumbnailOffset and
+// exifThumbnailLength on |map|, or nulls when |exif| is nullptr. Absent
+// tags are null too, except orientation, which defaults to 1.
+static void set_exif_fields(FlValue* map, const ExifInfo* exif) {
+  fl_value_set_string_take(map, "orientation",
+      exif ? fl_value_new_int(exif->orientation) : fl_value_new_null());
+  fl_value_set_string_take(map, "dateTimeOriginal",
+      exif && exif->date_time_original[0]
+          ? fl_value_new_string(exif->date_time_original)
+          : fl_value_new_null());
+  bool has_thumbnail = exif && exif->thumbnail_length > 0;
+  fl_value_set_string_take(map, "exifThumbnailOffset",
+      has_thumbnail ? fl_value_new_int(static_cast<int64_t>(exif->thumbnail_offset))
+                    : fl_value_new_null());
+  fl_value_set_string_take(map, "exifThumbnailLength",
+      has_thumbnail ? fl_value_new_int(exif->thumbnail_length)
+                    : fl_value_new_null());
+}
+
 static std::string get_mime_type(const std::string& file_path) {
   gboolean uncertain = FALSE;
   gchar* content_type =
@@ -464,17 +1388,17 @@ static std::string get_mime_type(const std::string& file_path) {
   return result;
 }
 
-static std::vector<uint8_t> read_file_bytes(const std::string& file_path) {
-  std::ifstream file(file_path, std::ios::binary);
-  if (!file) throw std::runtime_error("Cannot open file: " + file_path);
-
-  file.seekg(0, std::ios::end);
-  auto size = static_cast<size_t>(file.tellg());
-  file.seekg(0, std::ios::beg);
-
-  std::vector<uint8_t> data(size);
-  file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size));
-  return data;
+// Maps |file_path| read-only and wraps the mapping in GBytes without
+// copying; the last unref unmaps it. Returns nullptr on failure.
+static GBytes* map_file_bytes(const std::string& file_path) {
+  std::unique_ptr<MappedFile> file = MappedFile::Open(file_path);
+  if (!file) return nullptr;
+  if (file->size() == 0) return g_bytes_new(nullptr, 0);
+
+  MappedFile* mapping = file.release();
+  return g_bytes_new_with_free_func(
+      mapping->data(), mapping->size(),
+      [](gpointer data) { delete static_cast<MappedFile*>(data); }, mapping);
 }
 
 static bool is_image_file(const std::string& file_path) {
@@ -494,10 +1418,316 @@ static std::string get_file_extension(const std::string& file_path) {
   return ext;
 }
 
+// ─── Pixel buffers ─────────────────────────────────────────────────────────
+
+// Wraps |buffer| in a GdkPixbuf without copying; the pixbuf keeps the
+// buffer's storage alive.
+static GdkPixbuf* pixbuf_from_buffer(const ImageBuffer& buffer) {
+  return gdk_pixbuf_new_from_data(
+      buffer.pixels, GDK_COLORSPACE_RGB, buffer.channels == 4, 8,
+      buffer.width, buffer.height, buffer.stride,
+      [](guchar*, gpointer data) {
+        delete static_cast<std::shared_ptr<uint8_t>*>(data);
+      },
+      new std::shared_ptr<uint8_t>(buffer.storage));
+}
+
+// Views |pixbuf|'s pixels as an ImageBuffer without copying, taking over the
+// caller's reference.
+static ImageBuffer buffer_from_pixbuf(GdkPixbuf* pixbuf) {
+  ImageBuffer buffer;
+  buffer.storage  = std::shared_ptr<uint8_t>(
+      gdk_pixbuf_get_pixels(pixbuf),
+      [pixbuf](uint8_t*) { g_object_unref(pixbuf); });
+  buffer.pixels   = buffer.storage.get();
+  buffer.width    = gdk_pixbuf_get_width(pixbuf);
+  buffer.height   = gdk_pixbuf_get_height(pixbuf);
+  buffer.stride   = gdk_pixbuf_get_rowstride(pixbuf);
+  buffer.channels = gdk_pixbuf_get_n_channels(pixbuf);
+  return buffer;
+}
+
+// |pixels| mirrored and turned as CropRotateScaleSpec describes; the
+// buffer itself when there is nothing to do.
+static ImageBuffer orient_pixels(const ImageBuffer& pixels, int rotation,
+                                 bool mirror) {
+  if (rotation == 0 && !mirror) return pixels;
+  bool quarter_turn = (rotation == 90 || rotation == 270);
+  CropRotateScaleSpec spec;
+  spec.rotation   = rotation;
+  spec.mirror     = mirror;
+  spec.out_width  = quarter_turn ? pixels.height : pixels.width;
+  spec.out_height = quarter_turn ? pixels.width : pixels.height;
+  return CropRotateScale(pixels, spec, &WorkerPool::Shared());
+}
+
+// Current mtime and size of |path|, to key decoded-image and preview caches.
+static bool stat_source(const std::string& path, SourceStamp* stamp) {
+  GStatBuf st;
+  if (g_stat(path.c_str(), &st) != 0) return false;
+  stamp->mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                    st.st_mtim.tv_nsec;
+  stamp->size     = static_cast<int64_t>(st.st_size);
+  return true;
+}
+
+// Whole-image decode for formats without a region decoder. HEIF and AVIF
+// go through libheif, which settles for the smallest embedded thumbnail
+// that still covers |min_width| × |min_height|; everything else — and HEIF
+// that libheif cannot decode — through gdk-pixbuf.
+static ImageBuffer decode_whole(const std::string& file_path,
+                                const char* format_name,
+                                int min_width, int min_height) {
+  ImageBuffer decoded;
+  if (format_name && image_picker_master::IsHeifFormat(format_name) &&
+      image_picker_master::DecodeHeif(file_path, min_width, min_height,
+                                      &decoded)) {
+    return decoded;
+  }
+  GError* err = nullptr;
+  GdkPixbuf* full = gdk_pixbuf_new_from_file(file_path.c_str(), &err);
+  if (!full) {
+    if (err) g_error_free(err);
+    return ImageBuffer();
+  }
+  return buffer_from_pixbuf(full);
+}
+
+// Area-resamples all of |decoded| to |width| × |height|, applying
+// |rotation| and |mirror| in the same pass (the result is |height| ×
+// |width| after a quarter turn). Returns |decoded| itself when there is
+// nothing to do.
+static ImageBuffer resample_to(const ImageBuffer& decoded,
+                               int width, int height,
+                               int rotation, bool mirror) {
+  if (decoded.width == width && decoded.height == height && rotation == 0 &&
+      !mirror) {
+    return decoded;
+  }
+  bool quarter_turn = (rotation == 90 || rotation == 270);
+  CropRotateScaleSpec spec;
+  spec.step_x     = static_cast<double>(decoded.width) / width;
+  spec.step_y     = static_cast<double>(decoded.height) / height;
+  spec.rotation   = rotation;
+  spec.mirror     = mirror;
+  spec.out_width  = quarter_turn ? height : width;
+  spec.out_height = quarter_turn ? width : height;
+  return ResampleRegion(decoded, spec, ResampleFilter::kArea,
+                        ResampleIsa::kAuto, &WorkerPool::Shared());
+}
+
+// Decodes the whole image at exactly |width| × |height|. JPEGs shrink
+// inside the IDCT to the smallest 1/2, 1/4 or 1/8 scale that still covers
+// the target, and HEIF / AVIF use an embedded thumbnail when one covers it;
+// other formats decode at full size. The remaining reduction is
+// an area-averaging resample instead of gdk-pixbuf's bilinear, which aliases
+// badly at large factors. |rotation| and |mirror| (see CropRotateScaleSpec)
+// are applied in that same pass, so the result is |height| × |width| after a
+// quarter turn. The intermediate decode goes into |cache| (when given) for
+// cropImageNative, and a cached one is used instead of decoding if it is
+// large enough.
+static ImageBuffer decode_at_size(const std::string& file_path,
+                                  const char* format_name,
+                                  int src_w, int src_h,
+                                  int width, int height,
+                                  int rotation, bool mirror,
+                                  DecodedImageCache* cache) {
+  SourceStamp stamp;
+  bool cacheable = cache && stat_source(file_path, &stamp);
+  DecodedImage cached;
+  ImageBuffer decoded;
+  if (cacheable &&
+      cache->Lookup(file_path, stamp, width, height, &cached)) {
+    decoded = cached.pixels;
+  } else if (format_name && strcmp(format_name, "jpeg") == 0 &&
+      JpegRegionDecodeAvailable()) {
+    int denom = 1;
+    while (denom < 8 && src_w / (denom * 2) >= width &&
+           src_h / (denom * 2) >= height) {
+      denom *= 2;
+    }
+    JpegRegion region;
+    if (DecodeJpegRegion(file_path, PixelRect{0, 0, src_w, src_h}, denom,
+                         &region)) {
+      decoded = std::move(region.pixels);
+    }
+  }
+
+  if (decoded.empty()) {
+    decoded = decode_whole(file_path, format_name, width, height);
+    if (decoded.empty()) return ImageBuffer();
+  }
+  if (cacheable && cached.pixels.empty()) {
+    cache->Insert(file_path, stamp, DecodedImage{decoded, src_w, src_h});
+  }
+  return resample_to(decoded, width, height, rotation, mirror);
+}
+
+// Builds the preview cache key for resizeImageForCropper |arguments| from
+// the source file's current mtime and size. False when the arguments are
+// malformed or the file cannot be stat'ed.
+static bool preview_key_for(FlValue* arguments, PreviewKey* key) {
+  if (fl_value_get_type(arguments) != FL_VALUE_TYPE_MAP) return false;
+  FlValue* path_value    = fl_value_lookup_string(arguments, "path");
+  FlValue* maxsize_value = fl_value_lookup_string(arguments, "maxSize");
+  if (!path_value || fl_value_get_type(path_value) != FL_VALUE_TYPE_STRING) {
+    return false;
+  }
+
+  SourceStamp stamp;
+  const gchar* path = fl_value_get_string(path_value);
+  if (!stat_source(path, &stamp)) return false;
+
+  key->path     = path;
+  key->mtime_ns = stamp.mtime_ns;
+  key->size     = stamp.size;
+  key->max_size = 1024;
+  if (maxsize_value && fl_value_get_type(maxsize_value) == FL_VALUE_TYPE_INT) {
+    key->max_size = static_cast<int>(fl_value_get_int(maxsize_value));
+  }
+  FlValue* tier_value = fl_value_lookup_string(arguments, "tier");
+  key->thumbnail = tier_value &&
+                   fl_value_get_type(tier_value) == FL_VALUE_TYPE_STRING &&
+                   strcmp(fl_value_get_string(tier_value), "thumbnail") == 0;
+  return true;
+}
+
 // ─── resizeImageForCropper ─────────────────────────────────────────────────
-// Uses gdk-pixbuf for fast native resize. gdk_pixbuf_scale_simple with
-// GDK_INTERP_BILINEAR is implemented in C and orders of magnitude faster
-// than pure-Dart decode. Result is written to /tmp/cropper_preview/.
+// Decodes straight to the preview size: the header is probed first, then
+// decode_at_size shrinks JPEGs while decoding (libjpeg DCT scaling at 1/2,
+// 1/4 or 1/8) before the final exact area resample, so a 50 MP photo is
+// never expanded to a full-size buffer. The EXIF orientation is applied in
+// that resample, since the re-encoded preview carries no EXIF of its own;
+// the original path is returned as-is when it already fits, as Flutter's
+// decoder honours the tag. Result is written to the preview cache in
+// /tmp/cropper_preview/ under a name derived from (path, mtime, size,
+// maxSize, tier), so the dispatcher can answer repeat requests directly.
+// Runs on the worker pool (see respond_on_worker).
+//
+// With `tier: "thumbnail"` only a quick first frame is made (see
+// thumbnail_tier_preview), and null is returned when there is none to be
+// had cheaply; resizeImageForCropperTiered then shows it while the full
+// preview is still decoding.
+
+// Long edge of the thumbnail tier when it has to be decoded.
+constexpr int kThumbnailTierSize = 256;
+
+// Reads |length| bytes at |offset| of |file_path| into |out| with pread,
+// touching nothing else in the file. False unless all of them were read.
+static bool read_file_range(const std::string& file_path, uint64_t offset,
+                            size_t length, std::vector<uint8_t>* out) {
+  int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  out->resize(length);
+  size_t done = 0;
+  while (done < length) {
+    ssize_t got = pread(fd, out->data() + done, length - done,
+                        static_cast<off_t>(offset + done));
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) break;
+    done += static_cast<size_t>(got);
+  }
+  close(fd);
+  return done == length;
+}
+
+// Encodes the JPEG |thumbnail| bytes, turned by |rotation| / |mirror|.
+static GBytes* orient_thumbnail(const uint8_t* thumbnail, size_t length,
+                                int rotation, bool mirror) {
+  ImageBuffer pixels;
+  if (!image_picker_master::DefaultJpegCodec().Decode(
+          thumbnail, length, JpegDecodeOptions(), &pixels)) {
+    return nullptr;
+  }
+  ImageBuffer upright = orient_pixels(pixels, rotation, mirror);
+  return upright.empty() ? nullptr : encode_jpeg(upright, 85);
+}
+
+// The quick first frame of a tiered preview. The embedded EXIF thumbnail
+// is used when it has the photo's aspect ratio (cameras letterbox it
+// otherwise), copied as-is for orientation 1 — no decode at all — and
+// decoded and turned upright for the rest. Without one, JPEGs decode at a
+// 1/8 DCT scale to kThumbnailTierSize, and HEIF / AVIF decode only their
+// thumbnail item. Other formats have no cheap path and return nullptr.
+static GBytes* thumbnail_tier_preview(const std::string& file_path,
+                                      const ImageProbe& probe,
+                                      const ExifInfo& exif,
+                                      int rotation, bool mirror,
+                                      DecodedImageCache* cache) {
+  if (exif.thumbnail_length > 0) {
+    // Just the thumbnail's bytes: mapping the file would read the photo.
+    std::vector<uint8_t> bytes;
+    ImageProbe thumb;
+    if (read_file_range(file_path, exif.thumbnail_offset,
+                        exif.thumbnail_length, &bytes)) {
+      const uint8_t* data = bytes.data();
+      int64_t cross_w = static_cast<int64_t>(probe.width);
+      int64_t cross_h = static_cast<int64_t>(probe.height);
+      if (image_picker_master::ProbeImageData(data, exif.thumbnail_length,
+                                              &thumb) &&
+          thumb.format == "jpeg" &&
+          std::abs(thumb.width * cross_h - thumb.height * cross_w) * 50 <=
+              thumb.width * cross_h) {  // within 2 %
+        if (rotation == 0 && !mirror) {
+          return bytes_from_vector(std::move(bytes));
+        }
+        GBytes* oriented =
+            orient_thumbnail(data, exif.thumbnail_length, rotation, mirror);
+        if (oriented) return oriented;
+      }
+    }
+  }
+
+  int larger = std::max(probe.width, probe.height);
+  int w = std::max(1, static_cast<int>(
+      probe.width * static_cast<double>(kThumbnailTierSize) / larger));
+  int h = std::max(1, static_cast<int>(
+      probe.height * static_cast<double>(kThumbnailTierSize) / larger));
+
+  // HEIF / AVIF: the thumbnail item the camera stored next to the image.
+  ImageBuffer thumbnail;
+  if (image_picker_master::IsHeifFormat(probe.format) &&
+      image_picker_master::DecodeHeifThumbnail(file_path, &thumbnail)) {
+    if (thumbnail.width > w) {
+      thumbnail = resample_to(thumbnail, w, h, rotation, mirror);
+    } else {
+      thumbnail = orient_pixels(thumbnail, rotation, mirror);
+    }
+    return thumbnail.empty() ? nullptr : encode_jpeg(thumbnail, 85);
+  }
+
+  if (probe.format != "jpeg" || !JpegRegionDecodeAvailable()) return nullptr;
+  ImageBuffer pixels = decode_at_size(file_path, probe.format.c_str(),
+                                      probe.width, probe.height, w, h,
+                                      rotation, mirror, cache);
+  return pixels.empty() ? nullptr : encode_jpeg(pixels, 85);
+}
+
+// Writes |encoded| to the preview cache under the key for |arguments| and
+// sets |out_path|. Encoded in memory, then written with g_file_set_contents,
+// which goes through a temporary name and a rename — a concurrent lookup
+// never sees a half-written preview, and the size needs no stat afterwards.
+static bool store_preview(ImagePickerMasterPlugin* self, FlValue* arguments,
+                          GBytes* encoded, std::string* out_path) {
+  PreviewKey key;
+  if (!encoded || !preview_key_for(arguments, &key)) return false;
+  const gchar* tmp_dir = g_get_tmp_dir();
+  g_autofree gchar* out_dir = g_strdup_printf("%s/cropper_preview", tmp_dir);
+  g_mkdir_with_parents(out_dir, 0700);
+
+  *out_path = self->preview_cache->PathFor(key);
+  gsize length = 0;
+  const gchar* data =
+      static_cast<const gchar*>(g_bytes_get_data(encoded, &length));
+  if (!data || !g_file_set_contents(out_path->c_str(), data,
+                                    static_cast<gssize>(length), nullptr)) {
+    return false;
+  }
+
+  // The cache owns the file from here on (LRU eviction, clearTemporaryFiles).
+  self->preview_cache->Insert(key, length);
+  return true;
+}
 
 static FlMethodResponse* handle_resize_image_for_cropper(
     FlValue* arguments,
@@ -509,6 +1739,7 @@ static FlMethodResponse* handle_resize_image_for_cropper(
 
   FlValue* path_value    = fl_value_lookup_string(arguments, "path");
   FlValue* maxsize_value = fl_value_lookup_string(arguments, "maxSize");
+  FlValue* tier_value    = fl_value_lookup_string(arguments, "tier");
 
   if (!path_value || fl_value_get_type(path_value) != FL_VALUE_TYPE_STRING) {
     return create_error_response("INVALID_ARGUMENTS", "path is required");
@@ -519,75 +1750,210 @@ static FlMethodResponse* handle_resize_image_for_cropper(
   if (maxsize_value && fl_value_get_type(maxsize_value) == FL_VALUE_TYPE_INT) {
     max_size = static_cast<int>(fl_value_get_int(maxsize_value));
   }
+  bool thumbnail_tier =
+      tier_value && fl_value_get_type(tier_value) == FL_VALUE_TYPE_STRING &&
+      strcmp(fl_value_get_string(tier_value), "thumbnail") == 0;
 
-  // ── Step 1: load source via gdk-pixbuf ────────────────────────────────
-  GError* error = nullptr;
-  GdkPixbuf* src = gdk_pixbuf_new_from_file(file_path.c_str(), &error);
-  if (!src) {
-    if (error) g_error_free(error);
+  // ── Step 1: read dimensions from the header only ──────────────────────
+  ImageProbe src_probe;
+  if (!probe_image(file_path, &src_probe)) {
     // Fallback — return original path so the cropper still works
-    return FL_METHOD_RESPONSE(
-        fl_method_success_response_new(fl_value_new_string(file_path.c_str())));
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(
+        thumbnail_tier ? fl_value_new_null()
+                       : fl_value_new_string(file_path.c_str())));
   }
 
-  int orig_w = gdk_pixbuf_get_width(src);
-  int orig_h = gdk_pixbuf_get_height(src);
+  const int orig_w = src_probe.width;
+  const int orig_h = src_probe.height;
 
-  // Already fits — return original path immediately
-  if (orig_w <= max_size && orig_h <= max_size) {
-    g_object_unref(src);
+  // Already fits — return original path immediately. Flutter cannot decode
+  // HEIF / AVIF itself, so those always get a JPEG preview.
+  const bool needs_preview = image_picker_master::IsHeifFormat(src_probe.format);
+  if (orig_w <= max_size && orig_h <= max_size && !needs_preview) {
     return FL_METHOD_RESPONSE(
         fl_method_success_response_new(fl_value_new_string(file_path.c_str())));
   }
 
-  // ── Step 2: compute target size (preserve aspect ratio) ───────────────
-  int larger = std::max(orig_w, orig_h);
-  int new_w  = static_cast<int>(orig_w * static_cast<double>(max_size) / larger);
-  int new_h  = static_cast<int>(orig_h * static_cast<double>(max_size) / larger);
+  ExifInfo exif;
+  int orient_rotation = 0;
+  bool orient_mirror = false;
+  if (read_exif(file_path, src_probe, &exif)) {
+    image_picker_master::ExifOrientationTransform(
+        exif.orientation, &orient_rotation, &orient_mirror);
+  }
 
-  // ── Step 3: scale with bilinear interpolation (native C, fast) ────────
-  GdkPixbuf* scaled = gdk_pixbuf_scale_simple(
-      src, new_w, new_h, GDK_INTERP_BILINEAR);
-  g_object_unref(src);
+  if (thumbnail_tier) {
+    // Not worth a tier of its own when the full preview is that small.
+    g_autoptr(GBytes) quick = max_size > kThumbnailTierSize
+        ? thumbnail_tier_preview(file_path, src_probe, exif, orient_rotation,
+                                 orient_mirror, self->decoded_cache)
+        : nullptr;
+    std::string out_path;
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(
+        store_preview(self, arguments, quick, &out_path)
+            ? fl_value_new_string(out_path.c_str())
+            : fl_value_new_null()));
+  }
 
-  if (!scaled) {
+  // ── Step 2: compute target size (preserve aspect ratio, never enlarge) ─
+  int larger = std::max(orig_w, orig_h);
+  double scale = std::min(1.0, static_cast<double>(max_size) / larger);
+  int new_w  = std::max(1, static_cast<int>(orig_w * scale));
+  int new_h  = std::max(1, static_cast<int>(orig_h * scale));
+
+  // ── Step 3: scaled decode to exactly new_w × new_h, turned upright ───
+  ImageBuffer scaled_pixels = decode_at_size(
+      file_path, src_probe.format.c_str(), orig_w, orig_h, new_w, new_h,
+      orient_rotation, orient_mirror, self->decoded_cache);
+  if (scaled_pixels.empty()) {
     return FL_METHOD_RESPONSE(
         fl_method_success_response_new(fl_value_new_string(file_path.c_str())));
   }
 
-  // ── Step 4: write to /tmp/cropper_preview/ ────────────────────────────
-  const gchar* tmp_dir = g_get_tmp_dir();
-  g_autofree gchar* out_dir = g_strdup_printf("%s/cropper_preview", tmp_dir);
-  g_mkdir_with_parents(out_dir, 0700);
-
-  g_autofree gchar* out_path = g_strdup_printf(
-      "%s/preview_%" G_GUINT32_FORMAT ".jpg", out_dir, g_random_int());
-
-  g_autofree gchar* quality_str = g_strdup_printf("85");
-  gboolean ok = gdk_pixbuf_save(
-      scaled, out_path, "jpeg", &error, "quality", quality_str, nullptr);
-  g_object_unref(scaled);
+  // ── Step 4: write into the preview cache (/tmp/cropper_preview/) ────
+  g_autoptr(GBytes) encoded = encode_jpeg(scaled_pixels, 85);
 
-  if (!ok || error) {
-    if (error) g_error_free(error);
+  std::string out_path;
+  if (!store_preview(self, arguments, encoded, &out_path)) {
     return FL_METHOD_RESPONSE(
         fl_method_success_response_new(fl_value_new_string(file_path.c_str())));
   }
+  return FL_METHOD_RESPONSE(
+      fl_method_success_response_new(fl_value_new_string(out_path.c_str())));
+}
 
-  // Track for cleanup
-  self->temporary_files->push_back(std::string(out_path));
+// ─── Region decode ─────────────────────────────────────────────────────────
+
+// Returns |work_rect| of the source image scaled to work_w × work_h,
+// mirrored when |mirror| is set and turned by |rotation|, ready to encode.
+// JPEGs decode only the rectangle's iMCU rows and columns, at the largest
+// DCT scale (1/2, 1/4, 1/8) that still has at least the working
+// resolution. Other formats decode whole (see decode_whole). Either way,
+// crop, resample and rotation then happen in a single CropRotateScale pass
+// into the one output buffer (which hands large reductions on to the
+// separable resampler). A photo resizeImageForCropper already decoded at
+// the working resolution or better is taken from |cache| with no decode.
+static ImageBuffer render_crop(const std::string& file_path,
+                               const char* format_name,
+                               int src_w, int src_h,
+                               int work_w, int work_h,
+                               const PixelRect& work_rect,
+                               int rotation, bool mirror,
+                               DecodedImageCache* cache) {
+  bool quarter_turn = (rotation == 90 || rotation == 270);
+  CropRotateScaleSpec spec;
+  spec.rotation   = rotation;
+  spec.mirror     = mirror;
+  spec.out_width  = quarter_turn ? work_rect.height : work_rect.width;
+  spec.out_height = quarter_turn ? work_rect.width : work_rect.height;
+
+  double kx = static_cast<double>(src_w) / work_w;
+  double ky = static_cast<double>(src_h) / work_h;
+
+  SourceStamp stamp;
+  bool cacheable = stat_source(file_path, &stamp);
+  DecodedImage cached;
+  if (cacheable &&
+      cache->Lookup(file_path, stamp, work_w, work_h, &cached)) {
+    // Decoded pixels per source pixel.
+    double dx = static_cast<double>(cached.pixels.width) / cached.source_width;
+    double dy = static_cast<double>(cached.pixels.height) / cached.source_height;
+    spec.origin_x = work_rect.x * kx * dx;
+    spec.origin_y = work_rect.y * ky * dy;
+    spec.step_x   = kx * dx;
+    spec.step_y   = ky * dy;
+    return CropRotateScale(cached.pixels, spec, &WorkerPool::Shared());
+  }
 
-  return FL_METHOD_RESPONSE(
-      fl_method_success_response_new(fl_value_new_string(out_path)));
+  if (format_name && strcmp(format_name, "jpeg") == 0 &&
+      JpegRegionDecodeAvailable()) {
+    int denom = 1;
+    while (denom < 8 && denom * 2 <= std::min(kx, ky)) denom *= 2;
+
+    PixelRect src_rect{
+        static_cast<int>(work_rect.x * kx),
+        static_cast<int>(work_rect.y * ky),
+        static_cast<int>(std::ceil(work_rect.width * kx)) + 1,
+        static_cast<int>(std::ceil(work_rect.height * ky)) + 1};
+
+    JpegRegion region;
+    if (DecodeJpegRegion(file_path, src_rect, denom, &region)) {
+      // Working pixel (work_rect.x + u) covers decoded pixels from
+      // ((work_rect.x + u) * kx - region.source_rect.x) / denom.
+      spec.origin_x = (work_rect.x * kx - region.source_rect.x) / denom;
+      spec.origin_y = (work_rect.y * ky - region.source_rect.y) / denom;
+      spec.step_x   = kx / denom;
+      spec.step_y   = ky / denom;
+      return CropRotateScale(region.pixels, spec, &WorkerPool::Shared());
+    }
+  }
+
+  // Fallback: whole-image decode (at least the working size); the crop is
+  // resampled straight from the decoded pixels.
+  ImageBuffer decoded = decode_whole(file_path, format_name, work_w, work_h);
+  if (decoded.empty()) return ImageBuffer();
+  if (cacheable) {
+    cache->Insert(file_path, stamp, DecodedImage{decoded, src_w, src_h});
+  }
+  double dx = static_cast<double>(decoded.width) / src_w;
+  double dy = static_cast<double>(decoded.height) / src_h;
+  spec.origin_x = work_rect.x * kx * dx;
+  spec.origin_y = work_rect.y * ky * dy;
+  spec.step_x   = kx * dx;
+  spec.step_y   = ky * dy;
+  return CropRotateScale(decoded, spec, &WorkerPool::Shared());
+}
+
+// ─── Lossless JPEG crop ────────────────────────────────────────────────────
+
+static bool same_rect(const PixelRect& a, const PixelRect& b) {
+  return a.x == b.x && a.y == b.y && a.width == b.width &&
+         a.height == b.height;
+}
+
+// |work_rect| of the JPEG at |path| (in source pixels), mirrored and turned
+// by moving its DCT blocks rather than its pixels (see
+// TransformJpegLossless), so nothing is requantized and there is no IDCT or
+// colour conversion. Returns nullptr when the crop cannot be done that way,
+// leaving it to render_crop — including when the edges that end up top and
+// left are off the 8 or 16 px block grid, which would grow the crop.
+static GBytes* crop_jpeg_lossless(const std::string& path,
+                                  const PixelRect& work_rect,
+                                  int rotation, bool mirror,
+                                  const JpegEncodeOptions& jpeg) {
+  if (!image_picker_master::LosslessJpegAvailable() || rotation % 90 != 0) {
+    return nullptr;
+  }
+  std::unique_ptr<MappedFile> file = MappedFile::Open(path);
+  if (!file) return nullptr;
+  std::vector<uint8_t> out;
+  PixelRect applied;
+  if (!image_picker_master::TransformJpegLossless(
+          file->data(), file->size(), work_rect, rotation, mirror, jpeg,
+          &out, &applied) ||
+      !same_rect(applied, work_rect)) {
+    return nullptr;
+  }
+  return bytes_from_vector(std::move(out));
 }
 
 // ─── cropImageNative ──────────────────────────────────────────────────────
-// Full native crop+encode using gdk-pixbuf.
+// Full native crop+encode, run on the worker pool. The crop rectangle is
+// computed on the image as the cropper showed it (downscaled to maxSize,
+// turned upright per its EXIF orientation and then rotated), then mapped
+// back into source pixels so only that region is
+// decoded (see render_crop). When maxSize leaves a JPEG at full resolution,
+// the output is JPEG too and the crop lines up with the source's blocks,
+// it skips decoding altogether (see crop_jpeg_lossless); |quality| then
+// does not apply, and neither does the source's subsampling change unless
+// jpegOptions names one.
 // format: "jpeg" | "png" | "webp_lossy" | "webp_lossless"
-// gdk-pixbuf has no WebP saver — webp_* fall back to JPEG.
+// WebP is encoded with libwebp (effort = its 0-6 method); builds without
+// it fall back to JPEG. maxBytes caps the output size (see
+// encode_image_within).
 
-static FlMethodResponse* handle_crop_image_native(FlValue* arguments,
-                                                   ImagePickerMasterPlugin* self) {
+FlMethodResponse* handle_crop_image_native(FlValue* arguments,
+                                           ImagePickerMasterPlugin* self) {
   if (fl_value_get_type(arguments) != FL_VALUE_TYPE_MAP) {
     return create_error_response("INVALID_ARGUMENTS", "Arguments must be a map");
   }
@@ -614,7 +1980,7 @@ static FlMethodResponse* handle_crop_image_native(FlValue* arguments,
   if (file_path.empty())
     return create_error_response("INVALID_ARGUMENTS", "path is required");
 
-  std::string format   = get_str("format", "jpeg");
+  OutputFormat format  = parse_output_format(get_str("format", "jpeg"));
   double crop_x        = get_dbl("cropX");
   double crop_y        = get_dbl("cropY");
   double crop_w        = get_dbl("cropW",  1);
@@ -623,43 +1989,51 @@ static FlMethodResponse* handle_crop_image_native(FlValue* arguments,
   double container_h   = get_dbl("containerH", 1);
   int    rotation      = get_int("rotation");
   int    quality       = get_int("quality", 85);
+  int    effort        = get_int("effort", kDefaultWebpEffort);
   int    max_size      = get_int("maxSize",  1200);
-
-  // ── Step 1: load source ──────────────────────────────────────────────
-  GError* err = nullptr;
-  GdkPixbuf* src = gdk_pixbuf_new_from_file(file_path.c_str(), &err);
-  if (!src) {
-    if (err) g_error_free(err);
-    return create_error_response("DECODE_FAILED", "Cannot decode image");
+  int64_t max_bytes    = 0;
+  FlValue* max_bytes_value = fl_value_lookup_string(arguments, "maxBytes");
+  if (max_bytes_value &&
+      fl_value_get_type(max_bytes_value) == FL_VALUE_TYPE_INT) {
+    max_bytes = std::max<int64_t>(0, fl_value_get_int(max_bytes_value));
   }
+  JpegEncodeOptions jpeg;
+  const bool subsampling_set = parse_jpeg_options(arguments, &jpeg);
 
-  int origW = gdk_pixbuf_get_width(src);
-  int origH = gdk_pixbuf_get_height(src);
-
-  // ── Step 2: downscale to maxSize ────────────────────────────────────
-  int larger = std::max(origW, origH);
+  // ── Step 1: read dimensions from the header only ─────────────────────
+  ImageProbe src_probe;
+  if (!probe_image(file_path, &src_probe))
+    return create_error_response("DECODE_FAILED", "Cannot decode image");
+  const int srcW = src_probe.width;
+  const int srcH = src_probe.height;
+  const char* src_format_name = src_probe.format.c_str();
+
+  // ── Step 2: working size — the source downscaled to maxSize ─────────
+  int workW = srcW;
+  int workH = srcH;
+  int larger = std::max(workW, workH);
   if (larger > max_size) {
     double scale = static_cast<double>(max_size) / larger;
-    int nw = static_cast<int>(origW * scale);
-    int nh = static_cast<int>(origH * scale);
-    GdkPixbuf* scaled = gdk_pixbuf_scale_simple(src, nw, nh, GDK_INTERP_BILINEAR);
-    g_object_unref(src);
-    src   = scaled;
-    origW = nw; origH = nh;
-  }
-
-  // ── Step 3: rotation ────────────────────────────────────────────────
-  if (rotation != 0) {
-    GdkPixbufRotation rot = GDK_PIXBUF_ROTATE_NONE;
-    if (rotation == 90)  rot = GDK_PIXBUF_ROTATE_COUNTERCLOCKWISE; // gdk is CCW
-    if (rotation == 180) rot = GDK_PIXBUF_ROTATE_UPSIDEDOWN;
-    if (rotation == 270) rot = GDK_PIXBUF_ROTATE_CLOCKWISE;
-    GdkPixbuf* rotated = gdk_pixbuf_rotate_simple(src, rot);
-    g_object_unref(src);
-    src   = rotated;
-    origW = gdk_pixbuf_get_width(src);
-    origH = gdk_pixbuf_get_height(src);
+    workW = std::max(1, static_cast<int>(workW * scale));
+    workH = std::max(1, static_cast<int>(workH * scale));
+  }
+
+  // ── Step 3: rotation (dimensions only — pixels are rotated in Step 6) ─
+  // The cropper shows the image upright, so the EXIF orientation comes
+  // first: a mirror, then a turn that adds to the requested one.
+  ExifInfo exif;
+  int orient_rotation = 0;
+  bool mirror = false;
+  if (read_exif(file_path, src_probe, &exif)) {
+    image_picker_master::ExifOrientationTransform(exif.orientation,
+                                                  &orient_rotation, &mirror);
   }
+  if (rotation == 0 || rotation == 90 || rotation == 180 || rotation == 270) {
+    rotation = (rotation + orient_rotation) % 360;
+  }
+  bool quarter_turn = (rotation == 90 || rotation == 270);
+  int origW = quarter_turn ? workH : workW;
+  int origH = quarter_turn ? workW : workH;
 
   // ── Step 4: map crop rect → pixel coords ────────────────────────────
   double img_a = static_cast<double>(origW) / origH;
@@ -676,42 +2050,90 @@ static FlMethodResponse* handle_crop_image_native(FlValue* arguments,
   sw = std::max(1, std::min(sw, origW - sx));
   sh = std::max(1, std::min(sh, origH - sy));
 
-  // ── Step 5: crop ────────────────────────────────────────────────────
-  GdkPixbuf* cropped = gdk_pixbuf_new_subpixbuf(src, sx, sy, sw, sh);
-  g_object_unref(src);
-  if (!cropped)
-    return create_error_response("CROP_FAILED", "Subpixbuf failed");
+  // ── Step 5: undo the rotation on the rect ───────────────────────────
+  // Same pixel mapping as gdk_pixbuf_rotate_simple, so rotating the crop
+  // yields exactly the crop of the rotated image.
+  PixelRect work_rect{sx, sy, sw, sh};
+  if (rotation == 90) {         // gdk COUNTERCLOCKWISE
+    work_rect = PixelRect{workW - sy - sh, sx, sh, sw};
+  } else if (rotation == 180) {
+    work_rect = PixelRect{workW - sx - sw, workH - sy - sh, sw, sh};
+  } else if (rotation == 270) { // gdk CLOCKWISE
+    work_rect = PixelRect{sy, workH - sx - sw, sh, sw};
+  }
+  if (mirror) work_rect.x = workW - work_rect.x - work_rect.width;
+
+  // ── Step 6: a full-resolution JPEG crop moves DCT blocks, no decode ──
+  g_autoptr(GBytes) encoded = nullptr;
+  if (format == OutputFormat::kJpeg && workW == srcW && workH == srcH &&
+      !subsampling_set && strcmp(src_format_name, "jpeg") == 0) {
+    encoded = crop_jpeg_lossless(file_path, work_rect, rotation, mirror, jpeg);
+    if (encoded && max_bytes > 0 &&
+        g_bytes_get_size(encoded) > static_cast<gsize>(max_bytes)) {
+      g_clear_pointer(&encoded, g_bytes_unref);
+    }
+  }
 
-  // ── Step 6: encode ───────────────────────────────────────────────────
-  bool use_png = (format == "png");
-  const gchar* saver = use_png ? "png" : "jpeg";
-  std::string ext    = use_png ? "png" : "jpg";
+  // ── Step 7: otherwise decode only the crop, then crop + scale + rotate
+  // in one pass and encode in memory ──────────────────────────────────
+  if (!encoded) {
+    ImageBuffer cropped_pixels = render_crop(
+        file_path, src_format_name, srcW, srcH, workW, workH, work_rect,
+        rotation, mirror, self->decoded_cache);
+    if (cropped_pixels.empty())
+      return create_error_response("DECODE_FAILED", "Cannot decode image");
+    bool over_budget = false;
+    encoded = encode_image_within(cropped_pixels, format, quality, effort,
+                                  jpeg, max_bytes, &over_budget);
+    if (over_budget) {
+      return create_error_response("OVER_BUDGET",
+                                   "Cannot encode the crop within maxBytes");
+    }
+  }
 
+  // ── Step 8: write once ───────────────────────────────────────────────
+  GError* err = nullptr;
   const gchar* tmp_dir = g_get_tmp_dir();
   g_autofree gchar* out_dir = g_strdup_printf("%s/cropper_output", tmp_dir);
   g_mkdir_with_parents(out_dir, 0700);
   g_autofree gchar* out_path = g_strdup_printf(
-      "%s/crop_%" G_GUINT32_FORMAT ".%s", out_dir, g_random_int(), ext.c_str());
+      "%s/crop_%" G_GUINT32_FORMAT ".%s", out_dir, g_random_int(),
+      output_extension(format));
 
-  gboolean ok;
-  if (use_png) {
-    ok = gdk_pixbuf_save(cropped, out_path, saver, &err, nullptr);
-  } else {
-    g_autofree gchar* q_str = g_strdup_printf("%d", quality);
-    ok = gdk_pixbuf_save(cropped, out_path, saver, &err, "quality", q_str, nullptr);
-  }
-  g_object_unref(cropped);
+  gsize length = 0;
+  const gchar* data = encoded
+      ? static_cast<const gchar*>(g_bytes_get_data(encoded, &length))
+      : nullptr;
+  gboolean ok = data && g_file_set_contents(out_path, data,
+                                            static_cast<gssize>(length), &err);
 
   if (!ok || err) {
     if (err) g_error_free(err);
     return create_error_response("ENCODE_FAILED", "Failed to save cropped image");
   }
 
-  self->temporary_files->push_back(std::string(out_path));
+  track_temp_file(self, out_path);
   return FL_METHOD_RESPONSE(
       fl_method_success_response_new(fl_value_new_string(out_path)));
 }
 
+// ─── releaseImageSession ──────────────────────────────────────────────────
+// Drops the decoded pixels kept for |path| once the caller is done cropping
+// it. Returns whether anything was cached.
+
+static FlMethodResponse* handle_release_image_session(FlValue* arguments,
+                                                      ImagePickerMasterPlugin* self) {
+  FlValue* path_value = fl_value_get_type(arguments) == FL_VALUE_TYPE_MAP
+      ? fl_value_lookup_string(arguments, "path")
+      : nullptr;
+  if (!path_value || fl_value_get_type(path_value) != FL_VALUE_TYPE_STRING) {
+    return create_error_response("INVALID_ARGUMENTS", "path is required");
+  }
+  bool released = self->decoded_cache->Release(fl_value_get_string(path_value));
+  return FL_METHOD_RESPONSE(
+      fl_method_success_response_new(fl_value_new_bool(released)));
+}
+
 static std::string create_temp_file_path(const std::string& extension) {
   const gchar* temp_dir = g_get_tmp_dir();
   g_autofree gchar* temp_file = g_strdup_printf(
@@ -720,28 +2142,356 @@ static std::string create_temp_file_path(const std::string& extension) {
   return std::string(temp_file);
 }
 
-static bool compress_image(const std::string& input_path,
-                           const std::string& output_path,
-                           int quality) {
+// Hands |data| to a GBytes without copying it.
+static GBytes* bytes_from_vector(std::vector<uint8_t>&& data) {
+  auto* owned = new std::vector<uint8_t>(std::move(data));
+  return g_bytes_new_with_free_func(
+      owned->data(), owned->size(),
+      [](gpointer p) { delete static_cast<std::vector<uint8_t>*>(p); }, owned);
+}
+
+// Encodes |pixels| as a JPEG in memory with the default codec (libjpeg-turbo
+// when built in, gdk-pixbuf otherwise) at |quality|, taking the rest of the
+// settings from |tuning|. Returns nullptr on failure.
+static GBytes* encode_jpeg(const ImageBuffer& pixels, int quality,
+                           const JpegEncodeOptions& tuning) {
+  JpegEncodeOptions options = tuning;
+  options.quality = quality;
+  std::vector<uint8_t> encoded;
+  if (!image_picker_master::DefaultJpegCodec().Encode(pixels, options,
+                                                      &encoded)) {
+    return nullptr;
+  }
+  return bytes_from_vector(std::move(encoded));
+}
+
+// "jpeg" | "png" | "webp_lossy" | "webp_lossless". Unknown names are JPEG,
+// and so is WebP when the plugin is built without libwebp.
+static OutputFormat parse_output_format(const std::string& name) {
+  if (name == "png") return OutputFormat::kPng;
+  if (image_picker_master::WebpEncoderAvailable()) {
+    if (name == "webp_lossy")    return OutputFormat::kWebpLossy;
+    if (name == "webp_lossless") return OutputFormat::kWebpLossless;
+  }
+  return OutputFormat::kJpeg;
+}
+
+static const char* output_extension(OutputFormat format) {
+  switch (format) {
+    case OutputFormat::kPng:          return "png";
+    case OutputFormat::kWebpLossy:
+    case OutputFormat::kWebpLossless: return "webp";
+    case OutputFormat::kJpeg:         break;
+  }
+  return "jpg";
+}
+
+static const char* output_mime_type(OutputFormat format) {
+  switch (format) {
+    case OutputFormat::kPng:          return "image/png";
+    case OutputFormat::kWebpLossy:
+    case OutputFormat::kWebpLossless: return "image/webp";
+    case OutputFormat::kJpeg:         break;
+  }
+  return "image/jpeg";
+}
+
+// Encodes |pixels| in memory as |format|. |quality| is ignored for PNG,
+// |effort| (0-6) only applies to WebP and |jpeg| (all but its quality)
+// only to JPEG, which drops any alpha channel. Returns nullptr on failure.
+static GBytes* encode_image(const ImageBuffer& pixels, OutputFormat format,
+                            int quality, int effort,
+                            const JpegEncodeOptions& jpeg) {
+  switch (format) {
+    case OutputFormat::kJpeg:
+      return encode_jpeg(pixels, quality, jpeg);
+    case OutputFormat::kPng: {
+      GdkPixbuf* pixbuf = pixbuf_from_buffer(pixels);
+      gchar* data = nullptr;
+      gsize length = 0;
+      gboolean ok = gdk_pixbuf_save_to_buffer(pixbuf, &data, &length, "png",
+                                              nullptr, nullptr);
+      g_object_unref(pixbuf);
+      return ok ? g_bytes_new_take(data, length) : nullptr;
+    }
+    case OutputFormat::kWebpLossy:
+    case OutputFormat::kWebpLossless: {
+      WebpEncodeOptions options;
+      options.lossless = format == OutputFormat::kWebpLossless;
+      options.quality  = quality;
+      options.method   = effort;
+      std::vector<uint8_t> encoded;
+      if (!image_picker_master::EncodeWebp(pixels, options, &encoded)) {
+        return nullptr;
+      }
+      return bytes_from_vector(std::move(encoded));
+    }
+  }
+  return nullptr;
+}
+
+// Encodes |pixels| like encode_image. With a |max_bytes| budget, quality
+// (from |quality| down to kMinBudgetQuality) and then the dimensions are
+// searched for the largest encode that fits, entirely in memory and with
+// trial encodes spread over the shared pool (see EncodeWithinBudget). PNG
+// and lossless WebP only shrink. The budget is a hard cap: when nothing
+// fits, even at the smallest size tried, returns nullptr and sets
+// |over_budget| (optional), so callers can tell it from a failed encode.
+static GBytes* encode_image_within(const ImageBuffer& pixels,
+                                   OutputFormat format, int quality,
+                                   int effort, const JpegEncodeOptions& jpeg,
+                                   int64_t max_bytes, bool* over_budget) {
+  if (over_budget) *over_budget = false;
+  if (max_bytes <= 0) {
+    return encode_image(pixels, format, quality, effort, jpeg);
+  }
+
+  image_picker_master::SizeBudget budget;
+  budget.max_bytes   = static_cast<size_t>(max_bytes);
+  budget.max_quality = quality;
+  budget.min_quality = std::min(quality, kMinBudgetQuality);
+  budget.lossy = format == OutputFormat::kJpeg ||
+                 format == OutputFormat::kWebpLossy;
+  auto encode = [format, effort, jpeg](const ImageBuffer& trial,
+                                       int trial_quality,
+                                       std::vector<uint8_t>* out) {
+    g_autoptr(GBytes) bytes = encode_image(trial, format, trial_quality,
+                                           effort, jpeg);
+    if (!bytes) return false;
+    gsize length = 0;
+    const uint8_t* data =
+        static_cast<const uint8_t*>(g_bytes_get_data(bytes, &length));
+    out->assign(data, data + length);
+    return true;
+  };
+  std::vector<uint8_t> encoded;
+  if (!image_picker_master::EncodeWithinBudget(pixels, budget, encode,
+                                               &WorkerPool::Shared(),
+                                               &encoded)) {
+    if (over_budget) *over_budget = !encoded.empty();
+    return nullptr;
+  }
+  return bytes_from_vector(std::move(encoded));
+}
+
+// The largest size with the aspect ratio of |width| × |height| that fits
+// |options|' max_width, max_height and max_pixels. Returns false, leaving
+// the outputs alone, when the image already fits; never enlarges.
+static bool fit_dimensions(int width, int height,
+                           const FileMapOptions& options,
+                           int* fit_width, int* fit_height) {
+  double scale = 1.0;
+  if (options.max_width > 0) {
+    scale = std::min(scale, static_cast<double>(options.max_width) / width);
+  }
+  if (options.max_height > 0) {
+    scale = std::min(scale, static_cast<double>(options.max_height) / height);
+  }
+  const double pixels = static_cast<double>(width) * height;
+  if (options.max_pixels > 0 && pixels > options.max_pixels) {
+    scale = std::min(scale, std::sqrt(options.max_pixels / pixels));
+  }
+  if (scale >= 1.0) return false;
+  *fit_width  = std::max(1, static_cast<int>(width * scale));
+  *fit_height = std::max(1, static_cast<int>(height * scale));
+  return true;
+}
+
+// Whether |file_path| gets a compressed copy, and whether build_file_map
+// keeps that copy even if it comes out larger than the file.
+//
+// The maxBytes and dimension limits are caps, so they apply with or without
+// allowCompression; a copy scaled down to the dimensions is kept whatever
+// its size. So are HEIF / AVIF conversions, which exist to be readable, and
+// JPEGs written with an explicit chroma subsampling. Otherwise
+// allowCompression is skipped when the header shows it cannot pay off: a
+// JPEG whose tables put it at or below the requested quality would only
+// lose detail, and a file under kCompactBitsPerPixel would grow. Neither
+// applies when jpegOptions asks for progressive or optimized coding or a
+// subsampling, which the copy exists to have.
+static bool needs_compression(const std::string& file_path,
+                              const FileMapOptions& options,
+                              bool* keep_if_larger) {
+  *keep_if_larger = false;
+  // The common pick with nothing to do costs no I/O here.
+  if (!options.allow_compression && options.max_bytes <= 0 &&
+      options.max_width <= 0 && options.max_height <= 0 &&
+      options.max_pixels <= 0) {
+    return false;
+  }
+  if (!is_image_file(file_path)) return false;
+  std::error_code ec;
+  const uintmax_t file_size = std::filesystem::file_size(file_path, ec);
+  ImageProbe probe;
+  const bool probed = probe_image(file_path, &probe);
+
+  if (probed && (options.max_width > 0 || options.max_height > 0 ||
+                 options.max_pixels > 0)) {
+    // The limits apply to the image as displayed.
+    int width = probe.width, height = probe.height;
+    ExifInfo exif;
+    int rotation = 0;
+    bool mirror = false;
+    if (read_exif(file_path, probe, &exif)) {
+      image_picker_master::ExifOrientationTransform(exif.orientation,
+                                                    &rotation, &mirror);
+    }
+    if (rotation == 90 || rotation == 270) std::swap(width, height);
+    int fit_w = 0, fit_h = 0;
+    if (fit_dimensions(width, height, options, &fit_w, &fit_h)) {
+      *keep_if_larger = true;
+      return true;
+    }
+  }
+
+  const bool heif = probed && image_picker_master::IsHeifFormat(probe.format);
+  const bool jpeg_out = options.compression_format == OutputFormat::kJpeg;
+  *keep_if_larger = heif || (jpeg_out && options.jpeg_subsampling_set);
+  if (options.max_bytes > 0 && !ec &&
+      file_size > static_cast<uintmax_t>(options.max_bytes)) {
+    return true;
+  }
+  if (!options.allow_compression) return false;
+  if (heif || !probed || ec || !jpeg_out || options.jpeg.progressive ||
+      options.jpeg.optimize_coding || options.jpeg_subsampling_set) {
+    return true;
+  }
+  if (probe.quality > 0 && probe.quality <= options.compression_quality) {
+    return false;
+  }
+  const double pixels = static_cast<double>(probe.width) * probe.height;
+  return file_size * 8.0 >= kCompactBitsPerPixel * pixels;
+}
+
+// Re-encodes |input_path| in memory as |options.compression_format|, within
+// |options.max_bytes| when set (see encode_image_within). The copy carries
+// no EXIF, so its pixels are turned upright first. An image larger than
+// the maximum dimensions is decoded at reduced size where the format
+// allows (JPEG DCT scaling, HEIF thumbnails) and area-resampled down to
+// them, upright, in one pass (see decode_at_size). Otherwise a JPEG that
+// stays a JPEG and needs no turning is transcoded in YCbCr — no colour
+// conversion or chroma resampling either way — when the codec can; under a
+// budget that transcode is kept only if it fits. One already at or below
+// the requested quality that only wants progressive or optimized coding
+// gets it losslessly instead, its DCT blocks moved and turned rather than
+// re-quantized (a full-frame TransformJpegLossless). Other JPEGs decode
+// through the codec, HEIF / AVIF through libheif (already upright), and
+// everything else through gdk-pixbuf; alpha is kept for WebP. Returns
+// nullptr when nothing fits |options.max_bytes|, so there is no copy.
+static GBytes* compress_image(const std::string& input_path,
+                              const FileMapOptions& options) {
+  const JpegCodec& codec = image_picker_master::DefaultJpegCodec();
+  const OutputFormat format = options.compression_format;
+  const int quality = options.compression_quality;
+  const int64_t max_bytes = options.max_bytes;
+  // Set once a budgeted encode has failed to fit; the other decode paths
+  // would only fail again.
+  bool over_budget = false;
+
+  ImageProbe probe;
+  bool probed = probe_image(input_path, &probe);
+  ExifInfo exif;
+  int rotation = 0;
+  bool mirror = false;
+  if (probed && read_exif(input_path, probe, &exif)) {
+    image_picker_master::ExifOrientationTransform(exif.orientation,
+                                                  &rotation, &mirror);
+  }
+
+  if (probed) {
+    const bool quarter_turn = rotation == 90 || rotation == 270;
+    int fit_w = 0, fit_h = 0;
+    if (fit_dimensions(quarter_turn ? probe.height : probe.width,
+                       quarter_turn ? probe.width : probe.height, options,
+                       &fit_w, &fit_h)) {
+      ImageBuffer pixels = decode_at_size(
+          input_path, probe.format.c_str(), probe.width, probe.height,
+          quarter_turn ? fit_h : fit_w, quarter_turn ? fit_w : fit_h,
+          rotation, mirror, nullptr);
+      if (!pixels.empty()) {
+        GBytes* bytes = encode_image_within(pixels, format, quality,
+                                            kDefaultWebpEffort, options.jpeg,
+                                            max_bytes, &over_budget);
+        if (bytes || over_budget) return bytes;
+      }
+    }
+  }
+
+  if (probed && image_picker_master::IsHeifFormat(probe.format)) {
+    ImageBuffer pixels;
+    if (image_picker_master::DecodeHeif(input_path, probe.width, probe.height,
+                                        &pixels)) {
+      GBytes* bytes = encode_image_within(pixels, format, quality,
+                                          kDefaultWebpEffort, options.jpeg,
+                                          max_bytes, &over_budget);
+      if (bytes || over_budget) return bytes;
+    }
+  }
+  if (probed && probe.format == "jpeg") {
+    std::unique_ptr<MappedFile> file = MappedFile::Open(input_path);
+    JpegEncodeOptions jpeg_options = options.jpeg;
+    jpeg_options.quality = quality;
+    std::vector<uint8_t> encoded;
+    if (file && format == OutputFormat::kJpeg && probe.quality > 0 &&
+        probe.quality <= quality && !options.jpeg_subsampling_set &&
+        (options.jpeg.progressive || options.jpeg.optimize_coding) &&
+        image_picker_master::LosslessJpegAvailable()) {
+      // Fails when an EXIF turn would bring an unaligned border to the top
+      // or left, which then goes through the re-encode below.
+      const PixelRect frame{0, 0, probe.width, probe.height};
+      PixelRect applied;
+      if (image_picker_master::TransformJpegLossless(
+              file->data(), file->size(), frame, rotation, mirror,
+              options.jpeg, &encoded, &applied) &&
+          same_rect(applied, frame) &&
+          (max_bytes <= 0 ||
+           encoded.size() <= static_cast<size_t>(max_bytes))) {
+        return bytes_from_vector(std::move(encoded));
+      }
+      encoded.clear();
+    }
+    YuvImage yuv;
+    if (file && format == OutputFormat::kJpeg && rotation == 0 && !mirror &&
+        codec.DecodeYuv(file->data(), file->size(), &yuv) &&
+        (!options.jpeg_subsampling_set ||
+         yuv.subsampling == options.jpeg.subsampling) &&
+        codec.EncodeYuv(yuv, jpeg_options, &encoded) &&
+        (max_bytes <= 0 || encoded.size() <= static_cast<size_t>(max_bytes))) {
+      return bytes_from_vector(std::move(encoded));
+    }
+    ImageBuffer pixels;
+    if (file && codec.Decode(file->data(), file->size(), JpegDecodeOptions(),
+                             &pixels)) {
+      GBytes* bytes = encode_image_within(
+          orient_pixels(pixels, rotation, mirror), format, quality,
+          kDefaultWebpEffort, options.jpeg, max_bytes, &over_budget);
+      if (bytes || over_budget) return bytes;
+    }
+  }
+
   GError* error = nullptr;
   GdkPixbuf* pixbuf = gdk_pixbuf_new_from_file(input_path.c_str(), &error);
   if (!pixbuf) {
     if (error) g_error_free(error);
-    return false;
+    return nullptr;
   }
-
-  g_autofree gchar* quality_str = g_strdup_printf("%d", quality);
-  gboolean ok = gdk_pixbuf_save(
-      pixbuf, output_path.c_str(), "jpeg", &error,
-      "quality", quality_str, nullptr);
-
+  GdkPixbuf* upright = gdk_pixbuf_apply_embedded_orientation(pixbuf);
   g_object_unref(pixbuf);
-  if (error) g_error_free(error);
-  return ok == TRUE;
+  if (!upright) return nullptr;
+  return encode_image_within(buffer_from_pixbuf(upright), format, quality,
+                             kDefaultWebpEffort, options.jpeg, max_bytes);
+}
+
+static void track_temp_file(ImagePickerMasterPlugin* self,
+                            const std::string& path) {
+  std::lock_guard<std::mutex> lk(*self->temp_files_mutex);
+  self->temporary_files->push_back(path);
 }
 
 static void cleanup_temp_files(ImagePickerMasterPlugin* self) {
+  if (self->preview_cache) self->preview_cache->Clear();
   if (!self->temporary_files) return;
+  std::lock_guard<std::mutex> lk(*self->temp_files_mutex);
   for (const auto& path : *self->temporary_files) {
     std::error_code ec;
     std::filesystem::remove(path, ec);  // ignore errors
@@ -762,6 +2512,22 @@ static void image_picker_master_plugin_dispose(GObject* object) {
   cleanup_temp_files(self);
   delete self->temporary_files;
   self->temporary_files = nullptr;
+  delete self->temp_files_mutex;
+  self->temp_files_mutex = nullptr;
+  delete self->preview_cache;
+  self->preview_cache = nullptr;
+  delete self->decoded_cache;
+  self->decoded_cache = nullptr;
+  if (self->file_streams) {
+    for (auto& [id, stream] : *self->file_streams) {
+      finish_file_stream(stream);
+      g_clear_object(&stream->channel);
+    }
+    delete self->file_streams;
+    self->file_streams = nullptr;
+  }
+  g_clear_object(&self->messenger);
+  g_clear_object(&self->pick_files_stream_channel);
   G_OBJECT_CLASS(image_picker_master_plugin_parent_class)->dispose(object);
 }
 
@@ -772,6 +2538,15 @@ static void image_picker_master_plugin_class_init(
 
 static void image_picker_master_plugin_init(ImagePickerMasterPlugin* self) {
   self->temporary_files = new std::vector<std::string>();
+  self->temp_files_mutex = new std::mutex();
+  self->pick_files_stream_channel = nullptr;
+  self->pick_files_stream_generation = 0;
+  self->preview_cache = new PreviewCache(
+      std::string(g_get_tmp_dir()) + "/cropper_preview", kPreviewCacheBytes);
+  self->decoded_cache = new DecodedImageCache(kDecodedCacheBytes);
+  self->messenger = nullptr;
+  self->file_streams = new std::map<guint64, std::shared_ptr<FileStream>>();
+  self->next_file_stream_id = 0;
 }
 
 static void method_call_cb(FlMethodChannel* channel,
@@ -786,6 +2561,9 @@ void image_picker_master_plugin_register_with_registrar(
   ImagePickerMasterPlugin* plugin = IMAGE_PICKER_MASTER_PLUGIN(
       g_object_new(image_picker_master_plugin_get_type(), nullptr));
 
+  plugin->messenger =
+      FL_BINARY_MESSENGER(g_object_ref(fl_plugin_registrar_get_messenger(registrar)));
+
   g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
   g_autoptr(FlMethodChannel) channel = fl_method_channel_new(
       fl_plugin_registrar_get_messenger(registrar),
@@ -794,5 +2572,16 @@ void image_picker_master_plugin_register_with_registrar(
   fl_method_channel_set_method_call_handler(channel, method_call_cb,
                                             g_object_ref(plugin),
                                             g_object_unref);
+
+  // The plugin owns the event channel, so the handlers borrow |plugin|
+  // rather than holding a reference back to it.
+  plugin->pick_files_stream_channel = fl_event_channel_new(
+      fl_plugin_registrar_get_messenger(registrar),
+      "image_picker_master/pick_files_stream",
+      FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(plugin->pick_files_stream_channel,
+                                       pick_files_stream_listen_cb,
+                                       pick_files_stream_cancel_cb,
+                                       plugin, nullptr);
   g_object_unref(plugin);
 }
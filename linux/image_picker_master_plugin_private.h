@@ -3,7 +3,13 @@
 
 #include <flutter_linux/flutter_linux.h>
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "image_codec.h"
 #include "include/image_picker_master/image_picker_master_plugin.h"
+#include "worker_pool.h"
 
 // This file exposes some plugin internals for unit testing. See
 // https://github.com/flutter/flutter/issues/88724 for current limitations
@@ -12,4 +18,64 @@
 // Handles the getPlatformVersion method call.
 FlMethodResponse* get_platform_version();
 
+// Handles the cropImageNative method call: crops, turns and scales the
+// image at arguments["path"] and writes it to a temporary file, whose path
+// is the result. Runs on a worker thread.
+FlMethodResponse* handle_crop_image_native(FlValue* arguments,
+                                           ImagePickerMasterPlugin* self);
+
+// Encoding of a cropImageNative result or a compressed copy. The WebP
+// formats become kJpeg when the plugin is built without libwebp.
+enum class OutputFormat { kJpeg, kPng, kWebpLossy, kWebpLossless };
+
+// Per-file processing options parsed from pickFiles / capturePhoto.
+struct FileMapOptions {
+  bool with_data           = false;
+  bool allow_compression   = false;
+  int  compression_quality = 80;
+  // kJpeg, kWebpLossy or kWebpLossless.
+  OutputFormat compression_format = OutputFormat::kJpeg;
+  // Progressive, Huffman and subsampling settings for JPEG copies; the
+  // quality is compression_quality. Without jpeg_subsampling_set a JPEG
+  // re-encoded in YCbCr keeps its own subsampling.
+  image_picker_master::JpegEncodeOptions jpeg;
+  bool jpeg_subsampling_set = false;
+  // Upper bound on a compressed copy in bytes, 0 for none. Images larger
+  // than this are compressed even without allow_compression, searching
+  // quality and then dimensions for the largest encode that fits.
+  int64_t max_bytes        = 0;
+  // Maximum size of a compressed copy as displayed, 0 for none. Larger
+  // images are scaled down to fit, keeping their aspect ratio, and are
+  // compressed even without allow_compression.
+  int     max_width        = 0;
+  int     max_height       = 0;
+  int64_t max_pixels       = 0;
+  // Return only path and name and skip every other per-file step; details
+  // are fetched later with getFileDetails.
+  bool lazy_metadata       = false;
+};
+
+// The fields getFileDetails was asked for.
+struct FileDetailFields {
+  bool size       = false;
+  bool mime_type  = false;
+  bool dimensions = false;
+  bool bytes      = false;
+};
+
+// Builds the list of PickedFile maps for |file_paths|, spreading the
+// per-file work across |pool|. Result order always matches |file_paths|;
+// files that fail to process are skipped. Returns a new reference.
+FlValue* build_file_list(const std::vector<std::string>& file_paths,
+                         const FileMapOptions& options,
+                         image_picker_master::WorkerPool& pool,
+                         ImagePickerMasterPlugin* self);
+
+// Builds one map per path, in order: path, name, and only the fields set in
+// |fields| (size, mimeType, width/height, bytes). A field that cannot be
+// determined is null. Work is spread across |pool|. Returns a new reference.
+FlValue* build_file_details(const std::vector<std::string>& file_paths,
+                            const FileDetailFields& fields,
+                            image_picker_master::WorkerPool& pool);
+
 #endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_PLUGIN_PRIVATE_H_
@@ -0,0 +1,328 @@
+#include "image_probe.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace image_picker_master {
+
+namespace {
+
+// Random access to the encoded bytes. Probing a file costs one read of
+// kHeadBytes plus one pread per later hop (JPEG segments, TIFF IFDs).
+class ByteSource {
+ public:
+  virtual ~ByteSource() = default;
+  // Fills |buf| with |n| bytes at |offset|; false if the source is shorter.
+  virtual bool Read(uint64_t offset, uint8_t* buf, size_t n) const = 0;
+};
+
+class MemorySource : public ByteSource {
+ public:
+  MemorySource(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  bool Read(uint64_t offset, uint8_t* buf, size_t n) const override {
+    if (offset > size_ || n > size_ - offset) return false;
+    memcpy(buf, data_ + offset, n);
+    return true;
+  }
+
+ private:
+  const uint8_t* data_;
+  size_t         size_;
+};
+
+class FileSource : public ByteSource {
+ public:
+  static constexpr size_t kHeadBytes = 4096;
+
+  explicit FileSource(int fd) : fd_(fd) { head_size_ = ReadAt(0, head_, kHeadBytes); }
+
+  bool Read(uint64_t offset, uint8_t* buf, size_t n) const override {
+    if (offset + n <= head_size_) {
+      memcpy(buf, head_ + offset, n);
+      return true;
+    }
+    return ReadAt(offset, buf, n) == n;
+  }
+
+ private:
+  size_t ReadAt(uint64_t offset, uint8_t* buf, size_t n) const {
+    size_t done = 0;
+    while (done < n) {
+      ssize_t got = pread(fd_, buf + done, n - done,
+                          static_cast<off_t>(offset + done));
+      if (got < 0 && errno == EINTR) continue;
+      if (got <= 0) break;
+      done += static_cast<size_t>(got);
+    }
+    return done;
+  }
+
+  int     fd_;
+  uint8_t head_[kHeadBytes];
+  size_t  head_size_ = 0;
+};
+
+uint16_t be16(const uint8_t* p) { return static_cast<uint16_t>(p[0] << 8 | p[1]); }
+uint32_t be32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[1] << 8 | p[0]); }
+uint32_t le24(const uint8_t* p) { return p[2] << 16 | p[1] << 8 | p[0]; }
+uint32_t le32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[3]) << 24 | p[2] << 16 | p[1] << 8 | p[0];
+}
+
+bool done(ImageProbe* out, const char* format, int64_t width, int64_t height,
+          bool has_alpha) {
+  if (width <= 0 || height <= 0 || width > INT32_MAX || height > INT32_MAX) {
+    return false;
+  }
+  out->format = format;
+  out->width = static_cast<int>(width);
+  out->height = static_cast<int>(height);
+  out->has_alpha = has_alpha;
+  out->quality = 0;
+  return true;
+}
+
+// libjpeg's base luminance table (ITU-T T.81, Annex K) in zigzag order, as
+// DQT stores it. Its quality setting scales the table by 5000 / q percent
+// below 50 and by 200 - 2q above.
+constexpr uint8_t kBaseLumaTable[64] = {
+     16,  11,  12,  14,  12,  10,  16,  14,
+     13,  14,  18,  17,  16,  19,  24,  40,
+     26,  24,  22,  22,  24,  49,  35,  37,
+     29,  40,  58,  51,  61,  60,  57,  51,
+     56,  55,  64,  72,  92,  78,  64,  68,
+     87,  69,  55,  56,  80, 109,  81,  87,
+     95,  98, 103, 104, 103,  62,  77, 113,
+    121, 112, 100, 120,  92, 101, 103,  99};
+
+// Inverts libjpeg's quality scaling for one 8-bit or 16-bit table from the
+// ratio of its total to the base table's. Entries clamped to 1 or 255
+// carry no scale and are left out of both totals.
+int estimate_quality(const uint8_t* values, bool wide) {
+  const int max_value = wide ? 65535 : 255;
+  int64_t table_sum = 0, base_sum = 0;
+  bool all_ones = true;
+  for (int i = 0; i < 64; i++) {
+    int value = wide ? be16(values + 2 * i) : values[i];
+    all_ones = all_ones && value == 1;
+    if (value <= 1 || value >= max_value) continue;
+    table_sum += value;
+    base_sum  += kBaseLumaTable[i];
+  }
+  if (base_sum == 0) return all_ones ? 100 : 1;
+  const double scale = 100.0 * table_sum / base_sum;
+  const double quality = scale <= 100 ? (200 - scale) / 2 : 5000 / scale;
+  return std::clamp(static_cast<int>(quality + 0.5), 1, 100);
+}
+
+// Walks marker segments up to the first SOFn, estimating the quality from
+// table 0 of the DQT segments on the way. Metadata (EXIF, ICC, XMP) is
+// skipped by length, never read.
+bool probe_jpeg(const ByteSource& src, ImageProbe* out) {
+  uint64_t pos = 2;
+  int quality = 0;
+  for (int segments = 0; segments < 1024; segments++) {
+    uint8_t marker[2];
+    if (!src.Read(pos, marker, 2) || marker[0] != 0xFF) return false;
+    pos += 1;
+    while (marker[1] == 0xFF) {  // fill bytes
+      if (!src.Read(++pos, marker + 1, 1)) return false;
+    }
+    pos += 1;
+    uint8_t m = marker[1];
+    if (m == 0x01 || (m >= 0xD0 && m <= 0xD7)) continue;  // no payload
+    if (m == 0xD9 || m == 0xDA) return false;  // no frame header before data
+
+    uint8_t seg[7];
+    if (!src.Read(pos, seg, 2)) return false;
+    uint16_t length = be16(seg);
+    if (length < 2) return false;
+    bool sof = m >= 0xC0 && m <= 0xCF && m != 0xC4 && m != 0xC8 && m != 0xCC;
+    if (sof) {
+      // length, precision, height, width (height 0 = defined by DNL later)
+      if (length < 8 || !src.Read(pos, seg, 7)) return false;
+      if (!done(out, "jpeg", be16(seg + 5), be16(seg + 3), false)) {
+        return false;
+      }
+      out->quality = quality;
+      return true;
+    }
+    if (m == 0xDB) {
+      // One or more tables: a Pq/Tq byte, then 64 8-bit or 16-bit values.
+      uint8_t tables[2 + 4 * 129];
+      const size_t size = std::min<size_t>(length, sizeof(tables));
+      if (!src.Read(pos, tables, size)) return false;
+      for (size_t at = 2; at < size;) {
+        const bool wide = tables[at] >> 4;
+        const size_t bytes = wide ? 128 : 64;
+        if (at + 1 + bytes > size) break;
+        if ((tables[at] & 0x0F) == 0) {
+          quality = estimate_quality(tables + at + 1, wide);
+        }
+        at += 1 + bytes;
+      }
+    }
+    pos += length;
+  }
+  return false;
+}
+
+// IHDR, then chunk headers only until IDAT, looking for tRNS.
+bool probe_png(const ByteSource& src, ImageProbe* out) {
+  uint8_t ihdr[25];
+  if (!src.Read(8, ihdr, 25) || memcmp(ihdr + 4, "IHDR", 4) != 0) return false;
+  uint8_t color_type = ihdr[17];
+  bool has_alpha = color_type == 4 || color_type == 6;
+
+  uint64_t pos = 8 + 8 + be32(ihdr) + 4;
+  for (int chunks = 0; !has_alpha && chunks < 64; chunks++) {
+    uint8_t header[8];
+    if (!src.Read(pos, header, 8) || memcmp(header + 4, "IDAT", 4) == 0) break;
+    if (memcmp(header + 4, "tRNS", 4) == 0) has_alpha = true;
+    pos += 8 + static_cast<uint64_t>(be32(header)) + 4;
+  }
+  return done(out, "png", be32(ihdr + 8), be32(ihdr + 12), has_alpha);
+}
+
+// Logical screen size; transparent if a Graphic Control Extension before the
+// first image sets its transparency flag.
+bool probe_gif(const ByteSource& src, ImageProbe* out) {
+  uint8_t screen[7];
+  if (!src.Read(6, screen, 7)) return false;
+  uint64_t pos = 13;
+  if (screen[4] & 0x80) pos += 3u << ((screen[4] & 0x07) + 1);
+
+  bool has_alpha = false;
+  for (int blocks = 0; blocks < 256; blocks++) {
+    uint8_t intro[2];
+    if (!src.Read(pos, intro, 1) || intro[0] != 0x21) break;  // image or end
+    if (!src.Read(pos + 1, intro + 1, 1)) break;
+    pos += 2;
+    if (intro[1] == 0xF9) {
+      uint8_t gce[2];
+      if (src.Read(pos, gce, 2) && gce[0] >= 1 && (gce[1] & 0x01)) {
+        has_alpha = true;
+        break;
+      }
+    }
+    uint8_t sub = 0;  // skip the extension's sub-blocks
+    while (src.Read(pos, &sub, 1) && sub != 0) pos += 1 + sub;
+    pos += 1;
+  }
+  return done(out, "gif", le16(screen), le16(screen + 2), has_alpha);
+}
+
+bool probe_bmp(const ByteSource& src, ImageProbe* out) {
+  uint8_t dib[56];
+  if (!src.Read(14, dib, 16)) return false;
+  uint32_t header_size = le32(dib);
+  if (header_size == 12) {  // OS/2 BITMAPCOREHEADER
+    return done(out, "bmp", le16(dib + 4), le16(dib + 6), false);
+  }
+  if (header_size < 40 || !src.Read(14, dib, header_size >= 56 ? 56 : 40)) {
+    return false;
+  }
+  int32_t height = static_cast<int32_t>(le32(dib + 8));
+  uint16_t bpp = le16(dib + 14);
+  uint32_t compression = le32(dib + 16);
+  // 32-bit pixels carry alpha when the header has an alpha mask (V3 and
+  // later) or says BI_ALPHABITFIELDS.
+  bool has_alpha = bpp == 32 &&
+                   (compression == 6 || (header_size >= 56 && le32(dib + 52)));
+  return done(out, "bmp", static_cast<int32_t>(le32(dib + 4)),
+              height < 0 ? -static_cast<int64_t>(height) : height, has_alpha);
+}
+
+bool probe_webp(const ByteSource& src, ImageProbe* out) {
+  uint8_t chunk[18];
+  if (!src.Read(12, chunk, 18)) return false;
+  const uint8_t* p = chunk + 8;
+  if (memcmp(chunk, "VP8X", 4) == 0) {
+    return done(out, "webp", le24(p + 4) + 1, le24(p + 7) + 1,
+                (p[0] & 0x10) != 0);
+  }
+  if (memcmp(chunk, "VP8L", 4) == 0) {
+    if (p[0] != 0x2F) return false;
+    uint32_t bits = le32(p + 1);
+    return done(out, "webp", (bits & 0x3FFF) + 1, ((bits >> 14) & 0x3FFF) + 1,
+                (bits >> 28) & 1);
+  }
+  if (memcmp(chunk, "VP8 ", 4) == 0) {
+    if (p[3] != 0x9D || p[4] != 0x01 || p[5] != 0x2A) return false;
+    return done(out, "webp", le16(p + 6) & 0x3FFF, le16(p + 8) & 0x3FFF,
+                false);
+  }
+  return false;
+}
+
+// First IFD only: ImageWidth, ImageLength and ExtraSamples.
+bool probe_tiff(const ByteSource& src, const uint8_t* head, ImageProbe* out) {
+  bool le = head[0] == 'I';
+  auto u16 = [le](const uint8_t* p) { return le ? le16(p) : be16(p); };
+  auto u32 = [le](const uint8_t* p) { return le ? le32(p) : be32(p); };
+
+  uint64_t ifd = u32(head + 4);
+  uint8_t count_bytes[2];
+  if (!src.Read(ifd, count_bytes, 2)) return false;
+  size_t count = std::min<size_t>(u16(count_bytes), 512);
+  uint8_t entries[512 * 12];
+  if (!src.Read(ifd + 2, entries, count * 12)) return false;
+
+  int64_t width = 0, height = 0;
+  bool has_alpha = false;
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t* e = entries + i * 12;
+    uint16_t tag = u16(e);
+    uint16_t type = u16(e + 2);
+    // SHORT values sit left-justified in the 4-byte value field.
+    uint32_t value = type == 3 ? u16(e + 8) : u32(e + 8);
+    if (tag == 256) width = value;
+    else if (tag == 257) height = value;
+    else if (tag == 338) has_alpha = value == 1 || value == 2;  // (un)assoc.
+  }
+  return done(out, "tiff", width, height, has_alpha);
+}
+
+bool probe(const ByteSource& src, ImageProbe* out) {
+  uint8_t head[16] = {0};
+  if (!src.Read(0, head, 8)) return false;
+  src.Read(0, head, 16);  // longer signatures; shorter files fail below
+
+  if (head[0] == 0xFF && head[1] == 0xD8) return probe_jpeg(src, out);
+  if (memcmp(head, "\x89PNG\r\n\x1a\n", 8) == 0) return probe_png(src, out);
+  if (memcmp(head, "GIF87a", 6) == 0 || memcmp(head, "GIF89a", 6) == 0) {
+    return probe_gif(src, out);
+  }
+  if (head[0] == 'B' && head[1] == 'M') return probe_bmp(src, out);
+  if (memcmp(head, "RIFF", 4) == 0 && memcmp(head + 8, "WEBP", 4) == 0) {
+    return probe_webp(src, out);
+  }
+  if (memcmp(head, "II*\0", 4) == 0 || memcmp(head, "MM\0*", 4) == 0) {
+    return probe_tiff(src, head, out);
+  }
+  return false;
+}
+
+}  // namespace
+
+bool ProbeImage(const std::string& path, ImageProbe* out) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  bool ok = probe(FileSource(fd), out);
+  close(fd);
+  return ok;
+}
+
+bool ProbeImageData(const uint8_t* data, size_t size, ImageProbe* out) {
+  return probe(MemorySource(data, size), out);
+}
+
+}  // namespace image_picker_master
@@ -0,0 +1,34 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_PROBE_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_PROBE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace image_picker_master {
+
+// What an image header says, without decoding any pixels.
+struct ImageProbe {
+  std::string format;  // gdk-pixbuf format name: "jpeg", "png", "gif", ...
+  int  width     = 0;  // as stored, before any EXIF orientation
+  int  height    = 0;
+  bool has_alpha = false;
+  // JPEG only: the libjpeg quality (1-100) whose luminance table is
+  // closest to the file's, 0 when there is none. Only an estimate for
+  // encoders with their own tables, but a good one for libjpeg's.
+  int  quality   = 0;
+};
+
+// Reads just enough of the file at |path| to find its format, size and
+// whether it carries alpha: usually the first few KB, plus a seek or two
+// past JPEG metadata segments (and a read of each quantization table).
+// Understands JPEG, PNG, GIF, BMP, WebP and TIFF. Returns false for
+// anything else or a truncated header.
+bool ProbeImage(const std::string& path, ImageProbe* out);
+
+// Same as ProbeImage, over an encoded image already in memory.
+bool ProbeImageData(const uint8_t* data, size_t size, ImageProbe* out);
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_PROBE_H_
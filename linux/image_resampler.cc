@@ -0,0 +1,463 @@
+#include "image_resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IMAGE_PICKER_MASTER_RESAMPLER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace image_picker_master {
+
+namespace {
+
+// Weights are 1.14 fixed point, so a pair of them times a pair of 8-bit
+// pixels fits one pmaddwd lane and a full kernel sum stays far from
+// overflowing int32.
+constexpr int kWeightBits = 14;
+constexpr int kWeightOne  = 1 << kWeightBits;
+constexpr int kRound      = 1 << (kWeightBits - 1);
+
+// Taps for one axis. Output |i| reads |taps| consecutive source pixels from
+// first[i]; kernels shorter than |taps| are padded with zero weights, and
+// first[i] is pulled back where needed so no tap reads past the edge.
+struct Coefficients {
+  int taps = 0;
+  std::vector<int>     first;
+  std::vector<int16_t> weights;  // first.size() × taps
+
+  const int16_t* at(int i) const {
+    return weights.data() + static_cast<size_t>(i) * taps;
+  }
+};
+
+double lanczos3(double x) {
+  x = std::abs(x);
+  if (x < 1e-9) return 1.0;
+  if (x >= 3.0) return 0.0;
+  double px = M_PI * x;
+  return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
+}
+
+double triangle(double x) {
+  x = std::abs(x);
+  return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+Coefficients build_coefficients(int count, double origin, double step,
+                                int limit, ResampleFilter filter) {
+  std::vector<int> first(count);
+  std::vector<std::vector<double>> kernels(count);
+  int taps = 1;
+
+  for (int i = 0; i < count; i++) {
+    std::vector<double>& w = kernels[i];
+    double centre = origin + (i + 0.5) * step;
+    int lo;
+
+    if (filter == ResampleFilter::kArea && step >= 1.0) {
+      double a = std::clamp(origin + i * step, 0.0, static_cast<double>(limit));
+      double b = std::clamp(a + step, a, static_cast<double>(limit));
+      lo = std::min(static_cast<int>(a), limit - 1);
+      int hi = std::max(static_cast<int>(std::ceil(b)), lo + 1);
+      for (int s = lo; s < hi; s++) {
+        w.push_back(std::max(0.0, std::min(b, s + 1.0) - std::max(a, 1.0 * s)));
+      }
+    } else {
+      bool lanczos  = filter == ResampleFilter::kLanczos3;
+      double scale  = std::max(step, 1.0);
+      double radius = (lanczos ? 3.0 : 1.0) * scale;
+      lo = std::max(static_cast<int>(std::floor(centre - radius)), 0);
+      int hi = std::min(static_cast<int>(std::ceil(centre + radius)), limit);
+      for (int s = lo; s < hi; s++) {
+        double x = (s + 0.5 - centre) / scale;
+        w.push_back(lanczos ? lanczos3(x) : triangle(x));
+      }
+    }
+
+    // Trim zero tails, renormalise what is left.
+    while (!w.empty() && w.back() == 0.0) w.pop_back();
+    size_t lead = 0;
+    while (lead < w.size() && w[lead] == 0.0) lead++;
+    w.erase(w.begin(), w.begin() + lead);
+    lo += static_cast<int>(lead);
+
+    double sum = 0;
+    for (double v : w) sum += v;
+    if (w.empty() || sum == 0.0) {
+      lo = std::clamp(static_cast<int>(centre), 0, limit - 1);
+      w.assign(1, 1.0);
+      sum = 1.0;
+    }
+    for (double& v : w) v /= sum;
+
+    first[i] = lo;
+    taps = std::max(taps, static_cast<int>(w.size()));
+  }
+
+  Coefficients c;
+  c.taps = taps;
+  c.first.resize(count);
+  c.weights.assign(static_cast<size_t>(count) * taps, 0);
+  for (int i = 0; i < count; i++) {
+    const std::vector<double>& w = kernels[i];
+    int start = std::max(0, std::min(first[i], limit - taps));
+    int pad   = first[i] - start;
+    int16_t* out = c.weights.data() + static_cast<size_t>(i) * taps + pad;
+
+    // Round to fixed point and give the rounding error to the largest tap
+    // so every kernel sums to exactly kWeightOne.
+    int total = 0;
+    size_t largest = 0;
+    for (size_t k = 0; k < w.size(); k++) {
+      out[k] = static_cast<int16_t>(std::lround(w[k] * kWeightOne));
+      total += out[k];
+      if (w[k] > w[largest]) largest = k;
+    }
+    out[largest] = static_cast<int16_t>(out[largest] + kWeightOne - total);
+    c.first[i] = start;
+  }
+  return c;
+}
+
+inline uint8_t clamp8(int v) {
+  return static_cast<uint8_t>(std::clamp(v >> kWeightBits, 0, 255));
+}
+
+// ─── Scalar ──────────────────────────────────────────────────────────────
+
+template <int C>
+void horizontal_scalar(const uint8_t* in, uint8_t* out, int out_w,
+                       const Coefficients& cx, int) {
+  for (int x = 0; x < out_w; x++, out += C) {
+    const uint8_t* p = in + cx.first[x] * C;
+    const int16_t* w = cx.at(x);
+    int acc[C];
+    for (int c = 0; c < C; c++) acc[c] = kRound;
+    for (int k = 0; k < cx.taps; k++, p += C) {
+      for (int c = 0; c < C; c++) acc[c] += w[k] * p[c];
+    }
+    for (int c = 0; c < C; c++) out[c] = clamp8(acc[c]);
+  }
+}
+
+void vertical_scalar(const uint8_t* const* rows, const int16_t* w, int taps,
+                     uint8_t* out, int n, int start) {
+  for (int i = start; i < n; i++) {
+    int acc = kRound;
+    for (int k = 0; k < taps; k++) acc += w[k] * rows[k][i];
+    out[i] = clamp8(acc);
+  }
+}
+
+void vertical_scalar_row(const uint8_t* const* rows, const int16_t* w,
+                         int taps, uint8_t* out, int n) {
+  vertical_scalar(rows, w, taps, out, n, 0);
+}
+
+#ifdef IMAGE_PICKER_MASTER_RESAMPLER_X86
+
+// ─── SSE2 ────────────────────────────────────────────────────────────────
+// Both passes feed pmaddwd with interleaved pairs: two taps' pixels
+// zero-extended to 16 bits next to each other, times (w0, w1), summed into
+// one 32-bit lane per channel.
+
+inline uint32_t weight_pair(int16_t w0, int16_t w1) {
+  return static_cast<uint16_t>(w0) |
+         (static_cast<uint32_t>(static_cast<uint16_t>(w1)) << 16);
+}
+
+// One pixel in the low 32 bits. RGB reads a fourth byte that is discarded,
+// except at the right edge where that byte may be past the buffer.
+template <int C>
+inline uint32_t load_pixel(const uint8_t* p, bool edge) {
+  uint32_t v;
+  if (C == 4 || !edge) {
+    memcpy(&v, p, 4);
+  } else {
+    v = p[0] | (p[1] << 8) | (p[2] << 16);
+  }
+  return v;
+}
+
+template <int C>
+__attribute__((target("sse2")))
+void horizontal_sse2(const uint8_t* in, uint8_t* out, int out_w,
+                     const Coefficients& cx, int in_w) {
+  const __m128i zero = _mm_setzero_si128();
+  const int taps = cx.taps;
+  for (int x = 0; x < out_w; x++, out += C) {
+    const int first = cx.first[x];
+    const uint8_t* p = in + first * C;
+    const int16_t* w = cx.at(x);
+    __m128i acc = _mm_set1_epi32(kRound);
+    int k = 0;
+    for (; k + 1 < taps; k += 2) {
+      __m128i a = _mm_cvtsi32_si128(static_cast<int>(
+          load_pixel<C>(p + k * C, first + k + 1 >= in_w)));
+      __m128i b = _mm_cvtsi32_si128(static_cast<int>(
+          load_pixel<C>(p + (k + 1) * C, first + k + 2 >= in_w)));
+      __m128i px = _mm_unpacklo_epi8(_mm_unpacklo_epi8(a, b), zero);
+      acc = _mm_add_epi32(
+          acc, _mm_madd_epi16(px, _mm_set1_epi32(static_cast<int>(
+                                      weight_pair(w[k], w[k + 1])))));
+    }
+    if (k < taps) {
+      __m128i a = _mm_cvtsi32_si128(static_cast<int>(
+          load_pixel<C>(p + k * C, first + k + 1 >= in_w)));
+      __m128i px = _mm_unpacklo_epi8(_mm_unpacklo_epi8(a, zero), zero);
+      acc = _mm_add_epi32(
+          acc, _mm_madd_epi16(px, _mm_set1_epi32(static_cast<int>(
+                                      weight_pair(w[k], 0)))));
+    }
+    acc = _mm_srai_epi32(acc, kWeightBits);
+    acc = _mm_packs_epi32(acc, acc);
+    acc = _mm_packus_epi16(acc, acc);
+    uint32_t v = static_cast<uint32_t>(_mm_cvtsi128_si32(acc));
+    memcpy(out, &v, C);
+  }
+}
+
+__attribute__((target("sse2")))
+void vertical_sse2_from(const uint8_t* const* rows, const int16_t* w, int taps,
+                        uint8_t* out, int n, int i) {
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16) {
+    __m128i acc0 = _mm_set1_epi32(kRound);
+    __m128i acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    for (int k = 0; k < taps; k += 2) {
+      bool pair = k + 1 < taps;
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + i));
+      __m128i b = pair ? _mm_loadu_si128(
+                             reinterpret_cast<const __m128i*>(rows[k + 1] + i))
+                       : zero;
+      __m128i wv = _mm_set1_epi32(
+          static_cast<int>(weight_pair(w[k], pair ? w[k + 1] : 0)));
+      __m128i lo = _mm_unpacklo_epi8(a, b);
+      __m128i hi = _mm_unpackhi_epi8(a, b);
+      acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), wv));
+      acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), wv));
+      acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), wv));
+      acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), wv));
+    }
+    __m128i p01 = _mm_packs_epi32(_mm_srai_epi32(acc0, kWeightBits),
+                                  _mm_srai_epi32(acc1, kWeightBits));
+    __m128i p23 = _mm_packs_epi32(_mm_srai_epi32(acc2, kWeightBits),
+                                  _mm_srai_epi32(acc3, kWeightBits));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packus_epi16(p01, p23));
+  }
+  vertical_scalar(rows, w, taps, out, n, i);
+}
+
+void vertical_sse2(const uint8_t* const* rows, const int16_t* w, int taps,
+                   uint8_t* out, int n) {
+  vertical_sse2_from(rows, w, taps, out, n, 0);
+}
+
+// ─── AVX2 ────────────────────────────────────────────────────────────────
+// The vertical pass is where the bytes are, so it gets 32-byte vectors.
+// unpack and pack both work per 128-bit lane, so the lane split cancels
+// out and the stored bytes come back in order. The horizontal pass handles
+// one pixel per step and has nothing to gain from wider registers.
+
+__attribute__((target("avx2")))
+void vertical_avx2(const uint8_t* const* rows, const int16_t* w, int taps,
+                   uint8_t* out, int n) {
+  const __m256i zero = _mm256_setzero_si256();
+  int i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i acc0 = _mm256_set1_epi32(kRound);
+    __m256i acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    for (int k = 0; k < taps; k += 2) {
+      bool pair = k + 1 < taps;
+      __m256i a = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(rows[k] + i));
+      __m256i b = pair ? _mm256_loadu_si256(
+                             reinterpret_cast<const __m256i*>(rows[k + 1] + i))
+                       : zero;
+      __m256i wv = _mm256_set1_epi32(
+          static_cast<int>(weight_pair(w[k], pair ? w[k + 1] : 0)));
+      __m256i lo = _mm256_unpacklo_epi8(a, b);
+      __m256i hi = _mm256_unpackhi_epi8(a, b);
+      acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), wv));
+      acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), wv));
+      acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), wv));
+      acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), wv));
+    }
+    __m256i p01 = _mm256_packs_epi32(_mm256_srai_epi32(acc0, kWeightBits),
+                                     _mm256_srai_epi32(acc1, kWeightBits));
+    __m256i p23 = _mm256_packs_epi32(_mm256_srai_epi32(acc2, kWeightBits),
+                                     _mm256_srai_epi32(acc3, kWeightBits));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm256_packus_epi16(p01, p23));
+  }
+  vertical_sse2_from(rows, w, taps, out, n, i);
+}
+
+#endif  // IMAGE_PICKER_MASTER_RESAMPLER_X86
+
+struct Kernels {
+  void (*horizontal3)(const uint8_t*, uint8_t*, int, const Coefficients&, int);
+  void (*horizontal4)(const uint8_t*, uint8_t*, int, const Coefficients&, int);
+  void (*vertical)(const uint8_t* const*, const int16_t*, int, uint8_t*, int);
+};
+
+Kernels kernels_for(ResampleIsa isa) {
+  ResampleIsa best = BestResampleIsa();
+  if (isa == ResampleIsa::kAuto || static_cast<int>(isa) > static_cast<int>(best)) {
+    isa = best;
+  }
+#ifdef IMAGE_PICKER_MASTER_RESAMPLER_X86
+  if (isa == ResampleIsa::kAvx2) {
+    return {horizontal_sse2<3>, horizontal_sse2<4>, vertical_avx2};
+  }
+  if (isa == ResampleIsa::kSse2) {
+    return {horizontal_sse2<3>, horizontal_sse2<4>, vertical_sse2};
+  }
+#endif
+  return {horizontal_scalar<3>, horizontal_scalar<4>, vertical_scalar_row};
+}
+
+// Output rows [v_begin, v_end) of one resample. Horizontal rows are produced
+// on demand into a ring of |taps| rows, so the working set is one kernel's
+// worth of narrow rows (well inside L2 even for large Lanczos reductions)
+// rather than a full-height intermediate image, and stripes can run on
+// different threads without sharing anything but the read-only source.
+struct Stripe {
+  const ImageBuffer* src = nullptr;
+  Coefficients cx;
+  Coefficients cy;
+  Kernels      kernels;
+  int          rotation = 0;
+  bool         mirror   = false;
+  ImageBuffer  dst;
+
+  void Run(int v_begin, int v_end) const {
+    if (v_begin >= v_end) return;
+    const int width    = static_cast<int>(cx.first.size());
+    const int height   = static_cast<int>(cy.first.size());
+    const int channels = src->channels;
+    const int taps     = cy.taps;
+    auto horizontal = channels == 4 ? kernels.horizontal4 : kernels.horizontal3;
+
+    ImageBuffer ring = ImageBuffer::Allocate(width, taps, channels);
+    const bool scatter = rotation != 0 || mirror;
+    std::vector<uint8_t> line(scatter ? ring.stride : 0);
+    std::vector<const uint8_t*> rows(taps);
+    int next_row = cy.first[v_begin];
+
+    for (int v = v_begin; v < v_end; v++) {
+      const int top = cy.first[v];  // non-decreasing in v
+      next_row = std::max(next_row, top);
+      for (; next_row < top + taps; next_row++) {
+        horizontal(src->row(next_row), ring.row(next_row % taps), width, cx,
+                   src->width);
+      }
+      for (int k = 0; k < taps; k++) rows[k] = ring.row((top + k) % taps);
+
+      // Plain rows go straight into the output; rotated or mirrored ones
+      // go through a one-row scratch line and are scattered into place.
+      uint8_t* target = scatter ? line.data() : dst.row(v);
+      kernels.vertical(rows.data(), cy.at(v), taps, target, width * channels);
+      if (!scatter) continue;
+
+      for (int u = 0; u < width; u++) {
+        const int m = mirror ? width - 1 - u : u;
+        int i, j;
+        switch (rotation) {
+          case 90:  i = v;              j = width - 1 - m;  break;
+          case 180: i = width - 1 - m;  j = height - 1 - v; break;
+          case 270: i = height - 1 - v; j = m;              break;
+          default:  i = m;              j = v;              break;
+        }
+        memcpy(dst.row(j) + i * channels, line.data() + u * channels,
+               channels);
+      }
+    }
+  }
+};
+
+}  // namespace
+
+ResampleIsa BestResampleIsa() {
+#ifdef IMAGE_PICKER_MASTER_RESAMPLER_X86
+  static const ResampleIsa best = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return ResampleIsa::kAvx2;
+    if (__builtin_cpu_supports("sse2")) return ResampleIsa::kSse2;
+    return ResampleIsa::kScalar;
+  }();
+  return best;
+#else
+  return ResampleIsa::kScalar;
+#endif
+}
+
+ImageBuffer Resample(const ImageBuffer& src,
+                     int width,
+                     int height,
+                     ResampleFilter filter,
+                     ResampleIsa isa,
+                     WorkerPool* pool) {
+  if (width <= 0 || height <= 0) return ImageBuffer();
+  CropRotateScaleSpec spec;
+  spec.step_x     = static_cast<double>(src.width) / width;
+  spec.step_y     = static_cast<double>(src.height) / height;
+  spec.out_width  = width;
+  spec.out_height = height;
+  return ResampleRegion(src, spec, filter, isa, pool);
+}
+
+ImageBuffer ResampleRegion(const ImageBuffer& src,
+                           const CropRotateScaleSpec& spec,
+                           ResampleFilter filter,
+                           ResampleIsa isa,
+                           WorkerPool* pool) {
+  if (src.empty() || (src.channels != 3 && src.channels != 4) ||
+      spec.out_width <= 0 || spec.out_height <= 0 ||
+      spec.step_x <= 0 || spec.step_y <= 0) {
+    return ImageBuffer();
+  }
+
+  const bool quarter    = spec.rotation == 90 || spec.rotation == 270;
+  const int unrotated_w = quarter ? spec.out_height : spec.out_width;
+  const int unrotated_h = quarter ? spec.out_width : spec.out_height;
+
+  Stripe job;
+  job.src      = &src;
+  job.cx       = build_coefficients(unrotated_w, spec.origin_x, spec.step_x,
+                                    src.width, filter);
+  job.cy       = build_coefficients(unrotated_h, spec.origin_y, spec.step_y,
+                                    src.height, filter);
+  job.kernels  = kernels_for(isa);
+  job.rotation = spec.rotation;
+  job.mirror   = spec.mirror;
+  job.dst = ImageBuffer::Allocate(spec.out_width, spec.out_height, src.channels);
+
+  // Two stripes per thread so uneven ones (edge rows, busy cores) even out.
+  // Each stripe repeats one kernel's worth of horizontal rows, so keep
+  // stripes at least four kernels tall to bound that overhead to ~25%.
+  size_t stripes = 1;
+  if (pool && pool->size() > 1) {
+    const Coefficients& cy = job.cy;
+    int spanned = cy.first.back() + cy.taps - cy.first.front();
+    size_t tall_enough = static_cast<size_t>(std::max(1, spanned / (4 * cy.taps)));
+    stripes = std::min({static_cast<size_t>(unrotated_h), pool->size() * 2,
+                        tall_enough});
+  }
+  if (stripes == 1) {
+    job.Run(0, unrotated_h);
+  } else {
+    pool->ParallelFor(stripes, [&job, stripes, unrotated_h](size_t i) {
+      job.Run(static_cast<int>(unrotated_h * i / stripes),
+              static_cast<int>(unrotated_h * (i + 1) / stripes));
+    });
+  }
+  return job.dst;
+}
+
+}  // namespace image_picker_master
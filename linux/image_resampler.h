@@ -0,0 +1,53 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_RESAMPLER_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_RESAMPLER_H_
+
+#include "image_buffer.h"
+#include "image_transform.h"
+#include "worker_pool.h"
+
+namespace image_picker_master {
+
+enum class ResampleFilter {
+  // Exact pixel-area average when shrinking, bilinear when enlarging.
+  kArea,
+  // Windowed sinc with three lobes; sharper, about twice the taps.
+  kLanczos3,
+};
+
+// Instruction set for the convolution loops. kAuto picks the best one the
+// CPU reports at run time; asking for more than the CPU has falls back to
+// what it does have. All paths produce bit-identical output.
+enum class ResampleIsa {
+  kAuto,
+  kScalar,
+  kSse2,
+  kAvx2,
+};
+
+// What kAuto resolves to on this machine.
+ResampleIsa BestResampleIsa();
+
+// Resamples all of |src| to exactly |width| × |height| with a separable
+// two-pass convolution (horizontal, then vertical) in 14-bit fixed point.
+// With a |pool|, the output is split into horizontal stripes that run in
+// parallel via ParallelFor; each stripe streams its horizontal rows through
+// a cache-sized ring instead of a full-height intermediate.
+ImageBuffer Resample(const ImageBuffer& src,
+                     int width,
+                     int height,
+                     ResampleFilter filter,
+                     ResampleIsa isa = ResampleIsa::kAuto,
+                     WorkerPool* pool = nullptr);
+
+// Resamples the window described by |spec| and writes it rotated, so a
+// crop + scale + quarter-turn still produces a single output buffer. Taps
+// near the window edge read the real neighbouring source pixels.
+ImageBuffer ResampleRegion(const ImageBuffer& src,
+                           const CropRotateScaleSpec& spec,
+                           ResampleFilter filter,
+                           ResampleIsa isa = ResampleIsa::kAuto,
+                           WorkerPool* pool = nullptr);
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_RESAMPLER_H_
@@ -0,0 +1,165 @@
+#include "image_transform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "image_resampler.h"
+
+namespace image_picker_master {
+
+namespace {
+
+// Source taps for every output coordinate along one axis: output |i| reads
+// weights[offset[i] .. offset[i + 1]) applied to source pixels first[i], ….
+struct AxisTaps {
+  std::vector<int>   first;
+  std::vector<int>   offset;
+  std::vector<float> weights;
+};
+
+AxisTaps build_axis_taps(int count, double origin, double step, int limit) {
+  AxisTaps taps;
+  taps.first.reserve(count);
+  taps.offset.reserve(count + 1);
+  taps.offset.push_back(0);
+
+  for (int i = 0; i < count; i++) {
+    double a = origin + i * step;
+    double b = a + step;
+    size_t start = taps.weights.size();
+    int first;
+
+    if (step > 1.0) {
+      // Shrinking: average every source pixel the footprint overlaps,
+      // weighted by the overlap length.
+      a = std::clamp(a, 0.0, static_cast<double>(limit));
+      b = std::clamp(b, a, static_cast<double>(limit));
+      first = std::min(static_cast<int>(a), limit - 1);
+      int last = std::max(static_cast<int>(std::ceil(b)) - 1, first);
+      for (int s = first; s <= last; s++) {
+        double overlap = std::min(b, s + 1.0) - std::max(a, static_cast<double>(s));
+        taps.weights.push_back(static_cast<float>(std::max(overlap, 0.0)));
+      }
+    } else {
+      // Same size or enlarging: bilinear between the two nearest centres.
+      double centre = (a + b) * 0.5 - 0.5;
+      int s0 = static_cast<int>(std::floor(centre));
+      float frac = static_cast<float>(centre - s0);
+      if (s0 < 0) {
+        s0 = 0;
+        frac = 0;
+      } else if (s0 >= limit - 1) {
+        s0 = limit - 1;
+        frac = 0;
+      }
+      first = s0;
+      taps.weights.push_back(1.0f - frac);
+      if (frac > 0) taps.weights.push_back(frac);
+    }
+
+    float sum = 0;
+    for (size_t k = start; k < taps.weights.size(); k++) sum += taps.weights[k];
+    if (sum <= 0) {
+      taps.weights.resize(start);
+      taps.weights.push_back(1.0f);
+    } else {
+      for (size_t k = start; k < taps.weights.size(); k++) taps.weights[k] /= sum;
+    }
+
+    taps.first.push_back(first);
+    taps.offset.push_back(static_cast<int>(taps.weights.size()));
+  }
+  return taps;
+}
+
+template <int kChannels>
+void render(const ImageBuffer& src, const AxisTaps& xs, const AxisTaps& ys,
+            int unrotated_w, int unrotated_h, int rotation, bool mirror,
+            const ImageBuffer& dst, int j_begin, int j_end) {
+  for (int j = j_begin; j < j_end; j++) {
+    uint8_t* out = dst.row(j);
+    for (int i = 0; i < dst.width; i++) {
+      // Which unrotated pixel lands on output (i, j).
+      int u, v;
+      switch (rotation) {
+        case 90:  u = unrotated_w - 1 - j; v = i;                   break;
+        case 180: u = unrotated_w - 1 - i; v = unrotated_h - 1 - j; break;
+        case 270: u = j;                   v = unrotated_h - 1 - i; break;
+        default:  u = i;                   v = j;                   break;
+      }
+      if (mirror) u = unrotated_w - 1 - u;
+
+      float acc[kChannels] = {};
+      const int x0 = xs.first[u];
+      const int xn = xs.offset[u + 1] - xs.offset[u];
+      const float* wx = xs.weights.data() + xs.offset[u];
+      const float* wy = ys.weights.data() + ys.offset[v];
+      const int yn = ys.offset[v + 1] - ys.offset[v];
+
+      for (int ty = 0; ty < yn; ty++) {
+        const uint8_t* p = src.row(ys.first[v] + ty) + x0 * kChannels;
+        float row_acc[kChannels] = {};
+        for (int tx = 0; tx < xn; tx++, p += kChannels) {
+          for (int c = 0; c < kChannels; c++) row_acc[c] += wx[tx] * p[c];
+        }
+        for (int c = 0; c < kChannels; c++) acc[c] += wy[ty] * row_acc[c];
+      }
+
+      for (int c = 0; c < kChannels; c++) {
+        out[c] = static_cast<uint8_t>(std::clamp(acc[c] + 0.5f, 0.0f, 255.0f));
+      }
+      out += kChannels;
+    }
+  }
+}
+
+}  // namespace
+
+ImageBuffer CropRotateScale(const ImageBuffer& src,
+                            const CropRotateScaleSpec& spec,
+                            WorkerPool* pool) {
+  if (src.empty() || spec.out_width <= 0 || spec.out_height <= 0 ||
+      spec.step_x <= 0 || spec.step_y <= 0) {
+    return ImageBuffer();
+  }
+
+  // Footprints of many pixels are cheaper as two separable passes.
+  if (spec.step_x >= 2 || spec.step_y >= 2) {
+    return ResampleRegion(src, spec, ResampleFilter::kArea, ResampleIsa::kAuto,
+                          pool);
+  }
+
+  const bool quarter_turn = spec.rotation == 90 || spec.rotation == 270;
+  const int unrotated_w = quarter_turn ? spec.out_height : spec.out_width;
+  const int unrotated_h = quarter_turn ? spec.out_width : spec.out_height;
+
+  AxisTaps xs = build_axis_taps(unrotated_w, spec.origin_x, spec.step_x, src.width);
+  AxisTaps ys = build_axis_taps(unrotated_h, spec.origin_y, spec.step_y, src.height);
+
+  ImageBuffer dst =
+      ImageBuffer::Allocate(spec.out_width, spec.out_height, src.channels);
+  auto rows = [&](int j_begin, int j_end) {
+    if (src.channels == 4) {
+      render<4>(src, xs, ys, unrotated_w, unrotated_h, spec.rotation,
+                spec.mirror, dst, j_begin, j_end);
+    } else {
+      render<3>(src, xs, ys, unrotated_w, unrotated_h, spec.rotation,
+                spec.mirror, dst, j_begin, j_end);
+    }
+  };
+
+  const int height = spec.out_height;
+  if (!pool || pool->size() < 2 || height < 2) {
+    rows(0, height);
+  } else {
+    const size_t stripes = std::min(static_cast<size_t>(height), pool->size() * 4);
+    pool->ParallelFor(stripes, [&rows, stripes, height](size_t i) {
+      rows(static_cast<int>(height * i / stripes),
+           static_cast<int>(height * (i + 1) / stripes));
+    });
+  }
+  return dst;
+}
+
+}  // namespace image_picker_master
@@ -0,0 +1,43 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_TRANSFORM_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_TRANSFORM_H_
+
+#include "image_buffer.h"
+#include "worker_pool.h"
+
+namespace image_picker_master {
+
+// One axis-aligned affine map from output pixels to source pixels that
+// combines crop, scale and a quarter-turn rotation.
+//
+// The output is first described unrotated: unrotated pixel (u, v) covers the
+// source area starting at (origin_x + u * step_x, origin_y + v * step_y) and
+// extending step_x × step_y source pixels. With |mirror| the unrotated image
+// is flipped left-right (u counts from the right edge), which together with
+// the rotation covers all eight EXIF orientations. The unrotated image is
+// then turned by |rotation| degrees — 90 is counter-clockwise and 270
+// clockwise, the same sense as gdk_pixbuf_rotate_simple and
+// cropImageNative's `rotation`.
+struct CropRotateScaleSpec {
+  double origin_x = 0;
+  double origin_y = 0;
+  double step_x   = 1;
+  double step_y   = 1;
+  int rotation    = 0;  // 0, 90, 180 or 270
+  bool mirror     = false;
+  int out_width   = 0;  // final (rotated) size
+  int out_height  = 0;
+};
+
+// Renders |spec| from |src| in a single pass into one newly allocated buffer
+// with the same channel count. Each output pixel reads its source footprint
+// directly: area-weighted when shrinking, bilinear when enlarging. Meant for
+// footprints of a few source pixels (the crop path decodes near the target
+// resolution first); reductions of 2× or more are handed to ResampleRegion.
+// With a |pool|, output rows are split across its threads.
+ImageBuffer CropRotateScale(const ImageBuffer& src,
+                            const CropRotateScaleSpec& spec,
+                            WorkerPool* pool = nullptr);
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_IMAGE_TRANSFORM_H_
@@ -0,0 +1,128 @@
+#include "jpeg_decoder.h"
+
+#include <algorithm>
+
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBJPEG
+#include <csetjmp>
+#include <cstdio>
+
+#include <jpeglib.h>
+
+#include "jpeg_error_manager.h"
+#endif
+
+namespace image_picker_master {
+
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBJPEG
+
+bool JpegRegionDecodeAvailable() { return true; }
+
+bool DecodeJpegRegion(const std::string& path,
+                      const PixelRect& region,
+                      int scale_denom,
+                      JpegRegion* out) {
+  if (region.width <= 0 || region.height <= 0) return false;
+
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file) return false;
+
+  jpeg_decompress_struct cinfo;
+  JpegErrorManager       jerr;
+  cinfo.err = InstallJpegErrorManager(&jerr);
+
+  // Only plain (volatile) locals may be live across the longjmp.
+  uint8_t* volatile pixels = nullptr;
+
+  if (setjmp(jerr.jump)) {
+    jpeg_destroy_decompress(&cinfo);
+    fclose(file);
+    delete[] pixels;
+    return false;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  jpeg_stdio_src(&cinfo, file);
+  jpeg_read_header(&cinfo, TRUE);
+
+  if (cinfo.jpeg_color_space == JCS_CMYK ||
+      cinfo.jpeg_color_space == JCS_YCCK) {
+    jpeg_destroy_decompress(&cinfo);
+    fclose(file);
+    return false;
+  }
+
+  cinfo.out_color_space = JCS_RGB;
+  cinfo.scale_num       = 1;
+  cinfo.scale_denom     = static_cast<unsigned int>(scale_denom);
+  jpeg_start_decompress(&cinfo);
+
+  // Region in decoded (scaled) coordinates, clamped to the output.
+  const int denom  = scale_denom;
+  const int full_w = static_cast<int>(cinfo.output_width);
+  const int full_h = static_cast<int>(cinfo.output_height);
+  int x0 = std::clamp(region.x / denom, 0, full_w - 1);
+  int y0 = std::clamp(region.y / denom, 0, full_h - 1);
+  int x1 = std::clamp((region.x + region.width + denom - 1) / denom, x0 + 1, full_w);
+  int y1 = std::clamp((region.y + region.height + denom - 1) / denom, y0 + 1, full_h);
+
+  JDIMENSION xoffset = static_cast<JDIMENSION>(x0);
+  JDIMENSION width   = static_cast<JDIMENSION>(x1 - x0);
+#ifdef LIBJPEG_TURBO_VERSION
+  // Widens to iMCU column boundaries; output_width becomes |width|.
+  jpeg_crop_scanline(&cinfo, &xoffset, &width);
+#else
+  // Plain IJG libjpeg cannot skip columns — decode full rows.
+  xoffset = 0;
+  width   = cinfo.output_width;
+#endif
+
+  const int rows   = y1 - y0;
+  const int stride = static_cast<int>(width) * 3;
+  pixels = new uint8_t[static_cast<size_t>(stride) * rows];
+
+#ifdef LIBJPEG_TURBO_VERSION
+  jpeg_skip_scanlines(&cinfo, static_cast<JDIMENSION>(y0));
+#else
+  while (static_cast<int>(cinfo.output_scanline) < y0) {
+    JSAMPROW scratch = pixels;
+    jpeg_read_scanlines(&cinfo, &scratch, 1);
+  }
+#endif
+
+  while (static_cast<int>(cinfo.output_scanline) < y1) {
+    JSAMPROW row = pixels +
+        static_cast<size_t>(cinfo.output_scanline - y0) * stride;
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+
+  // Rows below the region are never decoded; destroy aborts the stream.
+  jpeg_destroy_decompress(&cinfo);
+  fclose(file);
+
+  ImageBuffer buffer;
+  buffer.storage  = std::shared_ptr<uint8_t>(pixels,
+                                             std::default_delete<uint8_t[]>());
+  buffer.pixels   = buffer.storage.get();
+  buffer.width    = static_cast<int>(width);
+  buffer.height   = rows;
+  buffer.stride   = stride;
+  buffer.channels = 3;
+
+  out->pixels      = std::move(buffer);
+  out->scale_denom = denom;
+  out->source_rect = PixelRect{static_cast<int>(xoffset) * denom, y0 * denom,
+                               static_cast<int>(width) * denom, rows * denom};
+  return true;
+}
+
+#else  // !IMAGE_PICKER_MASTER_HAVE_LIBJPEG
+
+bool JpegRegionDecodeAvailable() { return false; }
+
+bool DecodeJpegRegion(const std::string&, const PixelRect&, int, JpegRegion*) {
+  return false;
+}
+
+#endif  // IMAGE_PICKER_MASTER_HAVE_LIBJPEG
+
+}  // namespace image_picker_master
@@ -0,0 +1,44 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_JPEG_DECODER_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_JPEG_DECODER_H_
+
+#include <string>
+
+#include "image_buffer.h"
+
+namespace image_picker_master {
+
+// Rectangle in pixel coordinates.
+struct PixelRect {
+  int x      = 0;
+  int y      = 0;
+  int width  = 0;
+  int height = 0;
+};
+
+// Result of DecodeJpegRegion. The decoder can only start on iMCU boundaries
+// and scales by whole factors, so |pixels| usually covers a little more than
+// the requested rectangle; |source_rect| says exactly which part of the
+// source image it holds (1 decoded pixel = |scale_denom| source pixels).
+struct JpegRegion {
+  ImageBuffer pixels;
+  PixelRect   source_rect;
+  int         scale_denom = 1;
+};
+
+// True when the plugin was built against libjpeg(-turbo).
+bool JpegRegionDecodeAvailable();
+
+// Decodes only |region| (source pixel coordinates) of the JPEG at |path|,
+// shrinking by 1/|scale_denom| (1, 2, 4 or 8) inside the IDCT. Rows above
+// the region are skipped with jpeg_skip_scanlines, rows below it are never
+// read, and columns outside it are skipped with jpeg_crop_scanline, so time
+// and memory follow the crop area rather than the image size. Output is RGB.
+// Returns false for non-JPEG input, CMYK, or any decode error.
+bool DecodeJpegRegion(const std::string& path,
+                      const PixelRect& region,
+                      int scale_denom,
+                      JpegRegion* out);
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_JPEG_DECODER_H_
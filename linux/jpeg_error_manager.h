@@ -0,0 +1,34 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_JPEG_ERROR_MANAGER_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_JPEG_ERROR_MANAGER_H_
+
+// libjpeg error handling shared by the libjpeg users. Only include when
+// building with IMAGE_PICKER_MASTER_HAVE_LIBJPEG.
+
+#include <csetjmp>
+#include <cstdio>
+
+#include <jpeglib.h>
+
+namespace image_picker_master {
+
+// libjpeg's default error_exit() calls exit(); jump back instead.
+struct JpegErrorManager {
+  jpeg_error_mgr pub;
+  jmp_buf        jump;
+};
+
+// Sets up |manager| so errors longjmp to its |jump| and corrupt-data
+// warnings, which are not actionable here, keep stderr quiet. Returns the
+// pointer to store in cinfo.err.
+inline jpeg_error_mgr* InstallJpegErrorManager(JpegErrorManager* manager) {
+  jpeg_error_mgr* err = jpeg_std_error(&manager->pub);
+  err->error_exit = [](j_common_ptr cinfo) {
+    longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump, 1);
+  };
+  err->output_message = [](j_common_ptr) {};
+  return err;
+}
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_JPEG_ERROR_MANAGER_H_
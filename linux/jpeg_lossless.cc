@@ -0,0 +1,253 @@
+#include "jpeg_lossless.h"
+
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBJPEG
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include <jpeglib.h>
+
+#include "jpeg_error_manager.h"
+#include "jpeg_vector_destination.h"
+#endif
+
+namespace image_picker_master {
+
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBJPEG
+
+namespace {
+
+int div_round_up(int a, int b) { return (a + b - 1) / b; }
+int round_up(int a, int b) { return div_round_up(a, b) * b; }
+
+// Moves |crop|'s edges outward onto the MCU grid on the sides that the
+// turn brings to the output's top and left. Along each source axis that
+// is the start when the axis is read forward and the end when it is read
+// backward; the opposite edge is left alone and may cut a block.
+bool snap_axis(int start, int length, int extent, int mcu, bool flipped,
+               int* snapped_start, int* snapped_length) {
+  int end = std::min(start + length, extent);
+  start = std::max(start, 0);
+  if (end <= start) return false;
+  if (flipped) {
+    end = round_up(end, mcu);
+    if (end > extent) return false;
+  } else {
+    start -= start % mcu;
+  }
+  *snapped_start  = start;
+  *snapped_length = end - start;
+  return true;
+}
+
+// Quantization tables are stored in natural (row-major) order, so a
+// transpose of the blocks needs the tables transposed to match.
+void transpose_quant_tables(j_compress_ptr cinfo) {
+  for (JQUANT_TBL* table : cinfo->quant_tbl_ptrs) {
+    if (!table) continue;
+    for (int v = 0; v < DCTSIZE; v++) {
+      for (int u = v + 1; u < DCTSIZE; u++) {
+        std::swap(table->quantval[v * DCTSIZE + u],
+                  table->quantval[u * DCTSIZE + v]);
+      }
+    }
+  }
+}
+
+// Writes the remapped coefficients of one source block. Transposing in
+// pixel space transposes the DCT; flipping negates the odd frequencies
+// along that axis.
+void transform_block(const JCOEF* src, JCOEF* dst, bool transpose,
+                     bool flip_x, bool flip_y) {
+  for (int v = 0; v < DCTSIZE; v++) {
+    for (int u = 0; u < DCTSIZE; u++) {
+      int vs = transpose ? u : v;
+      int us = transpose ? v : u;
+      JCOEF value = src[vs * DCTSIZE + us];
+      if ((flip_x && (us & 1)) != (flip_y && (vs & 1))) value = -value;
+      dst[v * DCTSIZE + u] = value;
+    }
+  }
+}
+
+}  // namespace
+
+bool LosslessJpegAvailable() { return true; }
+
+bool TransformJpegLossless(const uint8_t* data, size_t size,
+                           const PixelRect& crop, int rotation, bool mirror,
+                           const JpegEncodeOptions& options,
+                           std::vector<uint8_t>* out, PixelRect* applied) {
+  out->clear();
+  rotation = ((rotation % 360) + 360) % 360;
+  if (rotation % 90 != 0 || !data || size == 0) return false;
+
+  // Source axes as seen from the output: 90/270 swap them, and each may be
+  // read backward. Mirroring flips the source's x before the turn.
+  const bool transpose = rotation == 90 || rotation == 270;
+  const bool flip_x = (rotation == 180 || rotation == 90) != mirror;
+  const bool flip_y = rotation == 180 || rotation == 270;
+
+  jpeg_decompress_struct src;
+  jpeg_compress_struct dst;
+  memset(&src, 0, sizeof(src));
+  memset(&dst, 0, sizeof(dst));
+  JpegErrorManager jerr;
+  src.err = InstallJpegErrorManager(&jerr);
+  dst.err = src.err;
+  // Both structs are set up before anything can fail, so one handler can
+  // destroy both; jpeg_destroy on a struct never created is a no-op.
+  if (setjmp(jerr.jump)) {
+    jpeg_destroy_compress(&dst);
+    jpeg_destroy_decompress(&src);
+    out->clear();
+    return false;
+  }
+  jpeg_create_decompress(&src);
+  jpeg_create_compress(&dst);
+  jpeg_mem_src(&src, data, static_cast<unsigned long>(size));
+  jpeg_read_header(&src, TRUE);
+
+  int max_h = 1, max_v = 1;
+  for (int c = 0; c < src.num_components; c++) {
+    max_h = std::max(max_h, src.comp_info[c].h_samp_factor);
+    max_v = std::max(max_v, src.comp_info[c].v_samp_factor);
+  }
+  // Fractional sampling (e.g. 3:1) cannot be re-gridded block by block.
+  bool supported = true;
+  for (int c = 0; c < src.num_components; c++) {
+    supported = supported && max_h % src.comp_info[c].h_samp_factor == 0 &&
+                max_v % src.comp_info[c].v_samp_factor == 0;
+  }
+
+  PixelRect rect;
+  if (!supported ||
+      !snap_axis(crop.x, crop.width, static_cast<int>(src.image_width),
+                 max_h * DCTSIZE, flip_x, &rect.x, &rect.width) ||
+      !snap_axis(crop.y, crop.height, static_cast<int>(src.image_height),
+                 max_v * DCTSIZE, flip_y, &rect.y, &rect.height)) {
+    jpeg_destroy_compress(&dst);
+    jpeg_destroy_decompress(&src);
+    return false;
+  }
+
+  jvirt_barray_ptr* src_coefs = jpeg_read_coefficients(&src);
+  jpeg_copy_critical_parameters(&src, &dst);
+  const int out_width  = transpose ? rect.height : rect.width;
+  const int out_height = transpose ? rect.width : rect.height;
+  dst.image_width  = static_cast<JDIMENSION>(out_width);
+  dst.image_height = static_cast<JDIMENSION>(out_height);
+#if JPEG_LIB_VERSION >= 70
+  dst.jpeg_width  = dst.image_width;
+  dst.jpeg_height = dst.image_height;
+#endif
+  if (transpose) {
+    for (int c = 0; c < dst.num_components; c++) {
+      std::swap(dst.comp_info[c].h_samp_factor,
+                dst.comp_info[c].v_samp_factor);
+    }
+    transpose_quant_tables(&dst);
+  }
+  // Standard Huffman tables unless asked otherwise, as jpegtran defaults
+  // to: optimizing them saves ~5% but costs a second pass over every block.
+  dst.optimize_coding =
+      options.optimize_coding || options.progressive ? TRUE : FALSE;
+  if (options.progressive) jpeg_simple_progression(&dst);
+
+  // Destination coefficient arrays, padded to whole MCUs like libjpeg's own.
+  const int dst_max_h = transpose ? max_v : max_h;
+  const int dst_max_v = transpose ? max_h : max_v;
+  std::vector<jvirt_barray_ptr> dst_coefs(dst.num_components);
+  std::vector<int> dst_blocks_wide(dst.num_components);
+  std::vector<int> dst_blocks_high(dst.num_components);
+  for (int c = 0; c < dst.num_components; c++) {
+    const jpeg_component_info& comp = dst.comp_info[c];
+    dst_blocks_wide[c] = round_up(
+        div_round_up(out_width * comp.h_samp_factor, dst_max_h * DCTSIZE),
+        comp.h_samp_factor);
+    dst_blocks_high[c] = round_up(
+        div_round_up(out_height * comp.v_samp_factor, dst_max_v * DCTSIZE),
+        comp.v_samp_factor);
+    dst_coefs[c] = dst.mem->request_virt_barray(
+        reinterpret_cast<j_common_ptr>(&dst), JPOOL_IMAGE, TRUE,
+        static_cast<JDIMENSION>(dst_blocks_wide[c]),
+        static_cast<JDIMENSION>(dst_blocks_high[c]),
+        static_cast<JDIMENSION>(comp.v_samp_factor));
+  }
+
+  VectorDestination destination;
+  UseVectorDestination(&dst, &destination, out, size / 2);
+  jpeg_write_coefficients(&dst, dst_coefs.data());
+
+  for (int c = 0; c < dst.num_components; c++) {
+    const jpeg_component_info& src_comp = src.comp_info[c];
+    const int v_samp = dst.comp_info[c].v_samp_factor;
+    // The crop in this component's blocks: [x0, x1) x [y0, y1). The
+    // snapped edges are block aligned; the others round outward.
+    const int block_w = max_h / src_comp.h_samp_factor * DCTSIZE;
+    const int block_h = max_v / src_comp.v_samp_factor * DCTSIZE;
+    const int x0 = rect.x / block_w;
+    const int y0 = rect.y / block_h;
+    const int x1 = div_round_up(rect.x + rect.width, block_w);
+    const int y1 = div_round_up(rect.y + rect.height, block_h);
+    const int src_blocks_wide = static_cast<int>(src_comp.width_in_blocks);
+    const int src_blocks_high = static_cast<int>(src_comp.height_in_blocks);
+
+    for (int row = 0; row < dst_blocks_high[c]; row += v_samp) {
+      JBLOCKARRAY dst_rows = dst.mem->access_virt_barray(
+          reinterpret_cast<j_common_ptr>(&dst), dst_coefs[c],
+          static_cast<JDIMENSION>(row), static_cast<JDIMENSION>(v_samp),
+          TRUE);
+      for (int i = 0; i < v_samp; i++) {
+        const int oby = row + i;
+        for (int obx = 0; obx < dst_blocks_wide[c]; obx++) {
+          const int a = transpose ? oby : obx;  // along the source's x
+          const int b = transpose ? obx : oby;  // along the source's y
+          const int sbx = flip_x ? x1 - 1 - a : x0 + a;
+          const int sby = flip_y ? y1 - 1 - b : y0 + b;
+          JCOEF* block = dst_rows[i][obx];
+          if (sbx < x0 || sbx >= x1 || sby < y0 || sby >= y1 ||
+              sbx >= src_blocks_wide || sby >= src_blocks_high) {
+            // Padding past the crop; never shown.
+            memset(block, 0, sizeof(JBLOCK));
+            continue;
+          }
+          // The source arrays are not writable, so libjpeg hands out one
+          // block row at a time; reading per block keeps this simple at
+          // the cost of some lookups.
+          JBLOCKARRAY src_row = src.mem->access_virt_barray(
+              reinterpret_cast<j_common_ptr>(&src), src_coefs[c],
+              static_cast<JDIMENSION>(sby), 1, FALSE);
+          transform_block(src_row[0][sbx], block, transpose, flip_x, flip_y);
+        }
+      }
+    }
+  }
+
+  jpeg_finish_compress(&dst);
+  jpeg_destroy_compress(&dst);
+  jpeg_finish_decompress(&src);
+  jpeg_destroy_decompress(&src);
+  if (applied) *applied = rect;
+  return true;
+}
+
+#else  // !IMAGE_PICKER_MASTER_HAVE_LIBJPEG
+
+bool LosslessJpegAvailable() { return false; }
+
+bool TransformJpegLossless(const uint8_t* /*data*/, size_t /*size*/,
+                           const PixelRect& /*crop*/, int /*rotation*/,
+                           bool /*mirror*/,
+                           const JpegEncodeOptions& /*options*/,
+                           std::vector<uint8_t>* out,
+                           PixelRect* /*applied*/) {
+  out->clear();
+  return false;
+}
+
+#endif  // IMAGE_PICKER_MASTER_HAVE_LIBJPEG
+
+}  // namespace image_picker_master
@@ -0,0 +1,41 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_JPEG_LOSSLESS_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_JPEG_LOSSLESS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "image_codec.h"
+#include "jpeg_decoder.h"
+
+namespace image_picker_master {
+
+// True when the plugin was built against libjpeg(-turbo).
+bool LosslessJpegAvailable();
+
+// Crops and turns the JPEG in |data| without decoding it, jpegtran style:
+// the quantized DCT blocks inside |crop| are moved, transposed and
+// sign-flipped into a new JPEG (|out|), so no pixel is re-quantized and
+// the only work is entropy decoding and encoding. |crop| is in source
+// pixels; |mirror| and |rotation| follow CropRotateScaleSpec — mirror the
+// crop left-right, then turn it by 0, 90 (counter-clockwise), 180 or 270.
+//
+// Blocks cannot be split, so the crop edges that end up at the output's
+// top and left are moved outward onto the source's MCU grid (8 or 16 px);
+// the far edges may cut through a block. |applied| (optional) receives the
+// rectangle actually used. Returns false when that is impossible — the
+// leading edge would need source rows or columns past the image, as when
+// the crop touches an unaligned right or bottom border that becomes the
+// output's top or left — or for unsupported sampling or a corrupt file.
+//
+// Of |options| only progressive and optimize_coding apply; quality and
+// subsampling are the source's by construction.
+bool TransformJpegLossless(const uint8_t* data, size_t size,
+                           const PixelRect& crop, int rotation, bool mirror,
+                           const JpegEncodeOptions& options,
+                           std::vector<uint8_t>* out,
+                           PixelRect* applied = nullptr);
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_JPEG_LOSSLESS_H_
@@ -0,0 +1,53 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_JPEG_VECTOR_DESTINATION_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_JPEG_VECTOR_DESTINATION_H_
+
+// libjpeg destination manager shared by the encoders. Only include when
+// building with IMAGE_PICKER_MASTER_HAVE_LIBJPEG.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <jpeglib.h>
+
+namespace image_picker_master {
+
+// Compressed output straight into a growing std::vector.
+struct VectorDestination {
+  jpeg_destination_mgr pub;
+  std::vector<uint8_t>* out;
+  size_t initial_size;
+};
+
+// Points |cinfo| at |dest|, which appends to |out|. |initial_size| is a
+// guess at the output size; the vector doubles whenever it runs out.
+inline void UseVectorDestination(j_compress_ptr cinfo, VectorDestination* dest,
+                                 std::vector<uint8_t>* out,
+                                 size_t initial_size) {
+  dest->out          = out;
+  dest->initial_size = std::max<size_t>(initial_size, 16 << 10);
+  dest->pub.init_destination = [](j_compress_ptr cinfo) {
+    auto* d = reinterpret_cast<VectorDestination*>(cinfo->dest);
+    d->out->resize(d->initial_size);
+    d->pub.next_output_byte = d->out->data();
+    d->pub.free_in_buffer   = d->out->size();
+  };
+  dest->pub.empty_output_buffer = [](j_compress_ptr cinfo) -> boolean {
+    auto* d = reinterpret_cast<VectorDestination*>(cinfo->dest);
+    size_t used = d->out->size();
+    d->out->resize(used * 2);
+    d->pub.next_output_byte = d->out->data() + used;
+    d->pub.free_in_buffer   = d->out->size() - used;
+    return TRUE;
+  };
+  dest->pub.term_destination = [](j_compress_ptr cinfo) {
+    auto* d = reinterpret_cast<VectorDestination*>(cinfo->dest);
+    d->out->resize(d->out->size() - d->pub.free_in_buffer);
+  };
+  cinfo->dest = &dest->pub;
+}
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_JPEG_VECTOR_DESTINATION_H_
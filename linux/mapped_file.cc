@@ -0,0 +1,47 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace image_picker_master {
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::string& path,
+                                             Access access) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return nullptr;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return nullptr;
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  if (size == 0) {
+    close(fd);  // mmap rejects zero-length mappings
+    return std::unique_ptr<MappedFile>(new MappedFile(nullptr, 0));
+  }
+
+  void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // the mapping keeps its own reference to the file
+  if (addr == MAP_FAILED) return nullptr;
+
+  if (access == Access::kSequential) {
+    // The only reader walks it front to back once.
+    madvise(addr, size, MADV_SEQUENTIAL);
+    madvise(addr, size, MADV_WILLNEED);
+  } else {
+    // Without this a fault still reads ahead around the page it needs.
+    madvise(addr, size, MADV_RANDOM);
+  }
+  return std::unique_ptr<MappedFile>(
+      new MappedFile(static_cast<const uint8_t*>(addr), size));
+}
+
+MappedFile::~MappedFile() {
+  if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+}  // namespace image_picker_master
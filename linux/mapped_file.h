@@ -0,0 +1,46 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_MAPPED_FILE_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace image_picker_master {
+
+// Read-only mmap of a whole file. The pages belong to the page cache, so
+// mapping a large file costs no anonymous memory until something copies
+// from it, and the kernel can drop pages already read. Not copyable; the
+// mapping lives as long as the object.
+class MappedFile {
+ public:
+  // How the mapping will be read, which sets the kernel's readahead.
+  enum class Access {
+    kSequential,  // the whole file, front to back: read it all in early
+    kHeaders,     // a few scattered pages: read only the pages touched
+  };
+
+  // Maps |path| for |access|. Returns nullptr when the file cannot be
+  // opened or mapped, or is not a regular file. An empty file maps to
+  // data() == nullptr, size() == 0.
+  static std::unique_ptr<MappedFile> Open(
+      const std::string& path, Access access = Access::kSequential);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const uint8_t* data() const { return data_; }
+  size_t         size() const { return size_; }
+
+ private:
+  MappedFile(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  const uint8_t* data_;
+  size_t         size_;
+};
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_MAPPED_FILE_H_
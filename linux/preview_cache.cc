@@ -0,0 +1,108 @@
+#include "preview_cache.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+namespace image_picker_master {
+
+namespace {
+
+// 64-bit FNV-1a — short, stable across runs, and plenty for file names
+// within one cache directory.
+uint64_t fnv1a(const std::string& data, uint64_t hash = 14695981039346656037ull) {
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+}  // namespace
+
+PreviewCache::PreviewCache(std::string directory, uint64_t max_bytes)
+    : directory_(std::move(directory)), max_bytes_(max_bytes) {}
+
+std::string PreviewCache::PathFor(const PreviewKey& key) const {
+  std::string identity = key.path;
+  identity.push_back('\0');
+  identity += std::to_string(key.mtime_ns) + ":" + std::to_string(key.size) +
+              ":" + std::to_string(key.max_size) + (key.thumbnail ? ":t" : "");
+  char name[40];
+  snprintf(name, sizeof(name), "preview_%016" PRIx64 ".jpg", fnv1a(identity));
+  return directory_ + "/" + name;
+}
+
+bool PreviewCache::Lookup(const PreviewKey& key, std::string* path) {
+  std::string file = PathFor(key);
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = index_.find(file);
+  if (it == index_.end()) return false;
+
+  // Someone may have emptied the directory behind our back.
+  std::error_code ec;
+  if (!std::filesystem::exists(file, ec)) {
+    total_bytes_ -= it->second->bytes;
+    lru_.erase(it->second);
+    index_.erase(it);
+    return false;
+  }
+
+  lru_.splice(lru_.begin(), lru_, it->second);
+  *path = std::move(file);
+  return true;
+}
+
+void PreviewCache::Insert(const PreviewKey& key, uint64_t bytes) {
+  std::string file = PathFor(key);
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = index_.find(file);
+  if (it != index_.end()) {
+    // Two workers raced on the same key; the later rename won.
+    total_bytes_ -= it->second->bytes;
+    it->second->bytes = bytes;
+    lru_.splice(lru_.begin(), lru_, it->second);
+  } else {
+    lru_.push_front(Entry{file, bytes});
+    index_.emplace(std::move(file), lru_.begin());
+  }
+  total_bytes_ += bytes;
+  EvictLocked();
+}
+
+void PreviewCache::Clear() {
+  std::lock_guard<std::mutex> lk(mutex_);
+  for (const Entry& entry : lru_) {
+    std::error_code ec;
+    std::filesystem::remove(entry.file, ec);
+  }
+  lru_.clear();
+  index_.clear();
+  total_bytes_ = 0;
+}
+
+uint64_t PreviewCache::total_bytes() const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return total_bytes_;
+}
+
+size_t PreviewCache::size() const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  return lru_.size();
+}
+
+void PreviewCache::EvictLocked() {
+  // The newest entry always stays, even if it alone is over budget.
+  while (total_bytes_ > max_bytes_ && lru_.size() > 1) {
+    const Entry& victim = lru_.back();
+    std::error_code ec;
+    std::filesystem::remove(victim.file, ec);
+    total_bytes_ -= victim.bytes;
+    index_.erase(victim.file);
+    lru_.pop_back();
+  }
+}
+
+}  // namespace image_picker_master
@@ -0,0 +1,70 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_PREVIEW_CACHE_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_PREVIEW_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace image_picker_master {
+
+// Identity of one resizeImageForCropper result. The source's mtime and size
+// stand in for its content, so an edited file gets a new key.
+struct PreviewKey {
+  std::string path;
+  int64_t     mtime_ns  = 0;
+  int64_t     size      = 0;
+  int         max_size  = 0;
+  bool        thumbnail = false;  // the quick first tier of a tiered preview
+};
+
+// Content-addressed store of preview files under one directory. Each key
+// maps to a fixed file name (a hash of the key), so a repeat request is a
+// map lookup plus a stat. Total size on disk is bounded; once an insert
+// goes over |max_bytes|, least recently used previews are deleted.
+// Thread-safe: lookups come from the main context, inserts from workers.
+class PreviewCache {
+ public:
+  PreviewCache(std::string directory, uint64_t max_bytes);
+
+  PreviewCache(const PreviewCache&) = delete;
+  PreviewCache& operator=(const PreviewCache&) = delete;
+
+  // Where the preview for |key| lives (or should be written).
+  std::string PathFor(const PreviewKey& key) const;
+
+  // Returns true and sets |path| when |key| has a preview that is still on
+  // disk, marking it most recently used.
+  bool Lookup(const PreviewKey& key, std::string* path);
+
+  // Records the |bytes|-long preview just written to PathFor(|key|), then
+  // evicts older entries until the cache fits its budget again.
+  void Insert(const PreviewKey& key, uint64_t bytes);
+
+  // Deletes every cached preview.
+  void Clear();
+
+  uint64_t total_bytes() const;
+  size_t   size() const;
+
+ private:
+  struct Entry {
+    std::string file;
+    uint64_t    bytes = 0;
+  };
+
+  void EvictLocked();
+
+  const std::string directory_;
+  const uint64_t    max_bytes_;
+
+  mutable std::mutex mutex_;
+  std::list<Entry>   lru_;  // front = most recently used
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  uint64_t           total_bytes_ = 0;
+};
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_PREVIEW_CACHE_H_
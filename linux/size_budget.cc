@@ -0,0 +1,159 @@
+#include "size_budget.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "image_resampler.h"
+
+namespace image_picker_master {
+
+namespace {
+
+// Trial encodes per round of the quality search. Each encode already fills
+// a core for its duration; more than a few per round mostly burns CPU on
+// qualities the next round would have ruled out anyway.
+constexpr size_t kMaxTrialsPerRound = 4;
+
+// Linear scale applied on top of the estimate, so the first smaller size
+// usually fits rather than landing just over the budget again.
+constexpr double kShrinkMargin = 0.95;
+
+struct Trial {
+  int quality = 0;
+  bool ok     = false;
+  std::vector<uint8_t> bytes;
+};
+
+// What one size's quality search found.
+struct QualitySearch {
+  bool fits = false;
+  int quality = 0;
+  std::vector<uint8_t> best;      // largest quality that fits
+  std::vector<uint8_t> smallest;  // smallest encode tried
+};
+
+// Up to |count| qualities spread evenly strictly between |good| and |bad|.
+std::vector<int> spread(int good, int bad, size_t count) {
+  std::vector<int> points;
+  for (size_t i = 0; i < count; i++) {
+    int q = good + static_cast<int>((bad - good) * static_cast<int64_t>(i + 1) /
+                                    static_cast<int64_t>(count + 1));
+    if (q > good && q < bad && (points.empty() || q != points.back())) {
+      points.push_back(q);
+    }
+  }
+  return points;
+}
+
+// Searches [min_quality, max_quality] at the size of |pixels| for the
+// largest quality whose encode fits. Quality is treated as monotonic in
+// size: |good| is the best quality known to fit, |bad| the lowest known
+// not to, and each round tests points between the two. The first round
+// always includes max_quality, which settles images that fit as they are
+// in a single round. Returns false if the encoder itself fails.
+bool search_quality(const ImageBuffer& pixels, const SizeBudget& budget,
+                    const BudgetEncoder& encode, WorkerPool* pool,
+                    int* trial_count, QualitySearch* search) {
+  const int max_q = std::clamp(budget.max_quality, 0, 100);
+  const int min_q = budget.lossy ? std::clamp(budget.min_quality, 0, max_q)
+                                 : max_q;
+  const size_t parallel =
+      pool ? std::clamp<size_t>(pool->size(), 1, kMaxTrialsPerRound) : 1;
+
+  int good = min_q - 1;
+  int bad  = max_q + 1;
+  bool first = true;
+  while (bad - good > 1) {
+    std::vector<int> points;
+    if (first) {
+      points = spread(good, max_q, parallel - 1);
+      points.push_back(max_q);
+      first = false;
+    } else {
+      points = spread(good, bad, parallel);
+    }
+
+    std::vector<Trial> trials(points.size());
+    auto run = [&](size_t i) {
+      trials[i].quality = points[i];
+      trials[i].ok = encode(pixels, points[i], &trials[i].bytes);
+    };
+    if (pool && trials.size() > 1) {
+      pool->ParallelFor(trials.size(), run);
+    } else {
+      for (size_t i = 0; i < trials.size(); i++) run(i);
+    }
+    *trial_count += static_cast<int>(trials.size());
+
+    for (Trial& trial : trials) {
+      if (!trial.ok || trial.bytes.empty()) return false;
+      if (search->smallest.empty() ||
+          trial.bytes.size() < search->smallest.size()) {
+        search->smallest = trial.bytes;
+      }
+      if (trial.bytes.size() <= budget.max_bytes) {
+        if (trial.quality > good) {
+          good = trial.quality;
+          search->best = std::move(trial.bytes);
+        }
+      } else {
+        bad = std::min(bad, trial.quality);
+      }
+    }
+  }
+  search->fits    = good >= min_q;
+  search->quality = good;
+  return true;
+}
+
+}  // namespace
+
+bool EncodeWithinBudget(const ImageBuffer& pixels, const SizeBudget& budget,
+                        const BudgetEncoder& encode, WorkerPool* pool,
+                        std::vector<uint8_t>* out, BudgetResult* result) {
+  out->clear();
+  BudgetResult local;
+  BudgetResult* stats = result ? result : &local;
+  *stats = BudgetResult();
+  if (pixels.empty() || budget.max_bytes == 0) return false;
+
+  ImageBuffer current = pixels;
+  std::vector<uint8_t> smallest;
+  for (;;) {
+    QualitySearch search;
+    if (!search_quality(current, budget, encode, pool, &stats->trials,
+                        &search)) {
+      out->clear();
+      return false;
+    }
+    if (search.fits) {
+      *out = std::move(search.best);
+      stats->quality = search.quality;
+      stats->width   = current.width;
+      stats->height  = current.height;
+      return true;
+    }
+    smallest = std::move(search.smallest);
+
+    // Encoded size grows roughly with the pixel count, so the budget over
+    // the smallest encode at this size gives the area to aim for.
+    const int longer = std::max(current.width, current.height);
+    if (longer <= budget.min_edge) break;
+    double scale = std::sqrt(static_cast<double>(budget.max_bytes) /
+                             static_cast<double>(smallest.size())) *
+                   kShrinkMargin;
+    scale = std::clamp(scale, 0.1, 0.9);
+    scale = std::max(scale, static_cast<double>(budget.min_edge) / longer);
+    const int width  = std::max(1, static_cast<int>(current.width * scale));
+    const int height = std::max(1, static_cast<int>(current.height * scale));
+    current = Resample(pixels, width, height, ResampleFilter::kArea,
+                       ResampleIsa::kAuto, pool);
+    if (current.empty()) break;
+  }
+
+  *out = std::move(smallest);
+  return false;
+}
+
+}  // namespace image_picker_master
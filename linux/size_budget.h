@@ -0,0 +1,53 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_SIZE_BUDGET_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_SIZE_BUDGET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "image_buffer.h"
+#include "worker_pool.h"
+
+namespace image_picker_master {
+
+// Encodes |pixels| at |quality| (0-100) into |out|. Lossless encoders
+// ignore |quality|. Called concurrently when EncodeWithinBudget has a pool.
+using BudgetEncoder = std::function<bool(const ImageBuffer& pixels,
+                                         int quality,
+                                         std::vector<uint8_t>* out)>;
+
+struct SizeBudget {
+  size_t max_bytes  = 0;
+  int    max_quality = 85;  // the requested quality; never exceeded
+  int    min_quality = 40;  // below this the image shrinks instead
+  bool   lossy       = true;  // false: only the dimensions are searched
+  int    min_edge    = 64;  // smallest longer edge tried
+};
+
+struct BudgetResult {
+  int quality = 0;
+  int width   = 0;
+  int height  = 0;
+  int trials  = 0;  // encodes run, for tests and the benchmark
+};
+
+// Finds the largest encode of |pixels| that fits |budget.max_bytes|, all in
+// memory. Quality is searched first, from max_quality down to min_quality,
+// at full size; only when even min_quality is too large is the image
+// resampled smaller (area filter, from the original each time) and the
+// quality searched again, the new size estimated from how far over the last
+// attempt was. With a |pool| each round of the quality search runs several
+// trial encodes at once, narrowing the range faster than one at a time.
+//
+// Returns true with the winning encode in |out|. When nothing fits, even at
+// min_edge, returns false with the smallest encode tried in |out|, so the
+// caller can still decide to use it.
+bool EncodeWithinBudget(const ImageBuffer& pixels, const SizeBudget& budget,
+                        const BudgetEncoder& encode, WorkerPool* pool,
+                        std::vector<uint8_t>* out,
+                        BudgetResult* result = nullptr);
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_SIZE_BUDGET_H_
@@ -0,0 +1,513 @@
+#include <flutter_linux/flutter_linux.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "include/image_picker_master/image_picker_master_plugin.h"
+#include "image_buffer.h"
+#include "image_codec.h"
+#include "image_picker_master_plugin_private.h"
+#include "image_probe.h"
+#include "image_resampler.h"
+#include "image_transform.h"
+#include "jpeg_lossless.h"
+#include "size_budget.h"
+#include "worker_pool.h"
+
+// Manual throughput benchmarks for the Linux plugin internals. Not part of
+// ctest. Build the example app with tests enabled, then run e.g.:
+// $ build/linux/x64/release/plugins/image_picker_master/image_picker_master_benchmark [files] [edge]
+
+namespace {
+
+using image_picker_master::ChromaSubsampling;
+using image_picker_master::CropRotateScaleSpec;
+using image_picker_master::ImageBuffer;
+using image_picker_master::JpegCodec;
+using image_picker_master::JpegDecodeOptions;
+using image_picker_master::JpegEncodeOptions;
+using image_picker_master::PixelRect;
+using image_picker_master::YuvImage;
+using image_picker_master::ImageProbe;
+using image_picker_master::Resample;
+using image_picker_master::ResampleFilter;
+using image_picker_master::ResampleIsa;
+using image_picker_master::WorkerPool;
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Writes |count| noisy |edge|x|edge| JPEGs so that recompression does real
+// entropy-coding work rather than encoding flat colour.
+std::vector<std::string> make_jpeg_corpus(const std::string& dir, int count,
+                                          int edge) {
+  std::filesystem::create_directories(dir);
+  GdkPixbuf* pixbuf =
+      gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, edge, edge);
+  guchar* pixels = gdk_pixbuf_get_pixels(pixbuf);
+  int stride = gdk_pixbuf_get_rowstride(pixbuf);
+  for (int y = 0; y < edge; y++) {
+    for (int x = 0; x < edge * 3; x++) {
+      pixels[y * stride + x] =
+          static_cast<guchar>((x * 7 + y * 13) ^ (g_random_int() & 0x1f));
+    }
+  }
+
+  std::vector<std::string> paths;
+  for (int i = 0; i < count; i++) {
+    std::string path = dir + "/bench_" + std::to_string(i) + ".jpg";
+    gdk_pixbuf_save(pixbuf, path.c_str(), "jpeg", nullptr,
+                    "quality", "95", nullptr);
+    paths.push_back(path);
+  }
+  g_object_unref(pixbuf);
+  return paths;
+}
+
+// pickFiles(allowCompression: true) over the corpus at 1, 2, 4, … threads.
+void bench_pick_files_scaling(ImagePickerMasterPlugin* plugin,
+                              const std::vector<std::string>& paths) {
+  FileMapOptions options;
+  options.allow_compression   = true;
+  options.compression_quality = 80;
+
+  unsigned cores = std::thread::hardware_concurrency();
+  std::vector<unsigned> thread_counts;
+  for (unsigned t = 1; t < cores; t *= 2) thread_counts.push_back(t);
+  thread_counts.push_back(cores == 0 ? 1 : cores);
+
+  std::printf("\npickFiles scaling (%zu files, allowCompression)\n",
+              paths.size());
+  std::printf("%8s %10s %9s %11s\n", "threads", "seconds", "speedup",
+              "efficiency");
+  double baseline = 0;
+  for (unsigned threads : thread_counts) {
+    WorkerPool pool(threads);
+    auto start = Clock::now();
+    FlValue* list = build_file_list(paths, options, pool, plugin);
+    double elapsed = seconds_since(start);
+    fl_value_unref(list);
+    if (baseline == 0) baseline = elapsed;
+    std::printf("%8u %10.3f %8.2fx %10.0f%%\n", threads, elapsed,
+                baseline / elapsed, 100.0 * baseline / elapsed / threads);
+  }
+}
+
+// Source megapixels per second of |fn|, best of |runs|.
+template <typename Fn>
+double megapixels_per_second(double megapixels, int runs, Fn fn) {
+  double best = 0;
+  for (int i = 0; i < runs; i++) {
+    auto start = Clock::now();
+    fn();
+    double elapsed = seconds_since(start);
+    if (best == 0 || elapsed < best) best = elapsed;
+  }
+  return megapixels / best;
+}
+
+// One large RGB downscale through gdk_pixbuf_scale_simple and through
+// Resample with each filter and instruction set.
+void bench_resample(int src_w, int src_h, int dst_w, int dst_h) {
+  ImageBuffer src = ImageBuffer::Allocate(src_w, src_h, 3);
+  for (int y = 0; y < src_h; y++) {
+    for (int x = 0; x < src_w * 3; x++) {
+      src.row(y)[x] = static_cast<uint8_t>((x * 7 + y * 13) ^ (g_random_int() & 0x1f));
+    }
+  }
+  GdkPixbuf* pixbuf = gdk_pixbuf_new_from_data(
+      src.pixels, GDK_COLORSPACE_RGB, FALSE, 8, src_w, src_h, src.stride,
+      nullptr, nullptr);
+  const double megapixels = src_w * static_cast<double>(src_h) / 1e6;
+  const int runs = 3;
+
+  std::printf("\nResample %dx%d -> %dx%d (source MP/s, best of %d)\n",
+              src_w, src_h, dst_w, dst_h, runs);
+  std::printf("%-28s %10s\n", "path", "MP/s");
+  std::printf("%-28s %10.1f\n", "gdk_pixbuf BILINEAR",
+              megapixels_per_second(megapixels, runs, [&] {
+                g_object_unref(gdk_pixbuf_scale_simple(pixbuf, dst_w, dst_h,
+                                                       GDK_INTERP_BILINEAR));
+              }));
+
+  const std::pair<const char*, ResampleFilter> filters[] = {
+      {"area", ResampleFilter::kArea}, {"lanczos3", ResampleFilter::kLanczos3}};
+  const std::pair<const char*, ResampleIsa> isas[] = {
+      {"scalar", ResampleIsa::kScalar},
+      {"sse2", ResampleIsa::kSse2},
+      {"avx2", ResampleIsa::kAvx2}};
+  for (const auto& [filter_name, filter] : filters) {
+    for (const auto& [isa_name, isa] : isas) {
+      std::string label = std::string(filter_name) + " " + isa_name;
+      std::printf("%-28s %10.1f\n", label.c_str(),
+                  megapixels_per_second(megapixels, runs, [&] {
+                    Resample(src, dst_w, dst_h, filter, isa);
+                  }));
+    }
+  }
+  g_object_unref(pixbuf);
+}
+
+// The same downscale split into stripes over 1, 2, 4, 8 and 16 threads.
+void bench_resample_scaling(int src_w, int src_h, int dst_w, int dst_h) {
+  ImageBuffer src = ImageBuffer::Allocate(src_w, src_h, 3);
+  for (int y = 0; y < src_h; y++) {
+    memset(src.row(y), y & 0xff, src.stride);
+  }
+  const double megapixels = src_w * static_cast<double>(src_h) / 1e6;
+
+  std::printf("\nResample scaling %dx%d -> %dx%d, Lanczos3\n", src_w, src_h,
+              dst_w, dst_h);
+  std::printf("%8s %10s %9s %11s\n", "threads", "MP/s", "speedup",
+              "efficiency");
+  double baseline = 0;
+  for (unsigned threads : {1u, 2u, 4u, 8u, 16u}) {
+    WorkerPool pool(threads);
+    double rate = megapixels_per_second(megapixels, 3, [&] {
+      Resample(src, dst_w, dst_h, ResampleFilter::kLanczos3,
+               ResampleIsa::kAuto, &pool);
+    });
+    if (baseline == 0) baseline = rate;
+    std::printf("%8u %10.1f %8.2fx %10.0f%%\n", threads, rate,
+                rate / baseline, 100.0 * rate / baseline / threads);
+  }
+}
+
+// Width/height of one large JPEG: header probe vs gdk-pixbuf's file-info
+// sniffing vs the full decode that reading dimensions used to cost.
+void bench_probe(const std::string& path) {
+  auto microseconds = [](int runs, auto fn) {
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < runs; i++) fn();
+    return seconds_since(start) * 1e6 / runs;
+  };
+  int width = 0, height = 0;
+  gdk_pixbuf_get_file_info(path.c_str(), &width, &height);
+
+  std::printf("\nDimensions of a %dx%d JPEG (%.1f MP)\n", width, height,
+              width * static_cast<double>(height) / 1e6);
+  std::printf("%-28s %12s\n", "path", "us / file");
+  std::printf("%-28s %12.1f\n", "ProbeImage",
+              microseconds(1000, [&] {
+                ImageProbe probe;
+                image_picker_master::ProbeImage(path, &probe);
+              }));
+  std::printf("%-28s %12.1f\n", "gdk_pixbuf_get_file_info",
+              microseconds(100, [&] {
+                gdk_pixbuf_get_file_info(path.c_str(), &width, &height);
+              }));
+  std::printf("%-28s %12.1f\n", "gdk_pixbuf_new_from_file",
+              microseconds(1, [&] {
+                g_object_unref(gdk_pixbuf_new_from_file(path.c_str(), nullptr));
+              }));
+}
+
+// Decode and encode of one large JPEG through each codec backend and the
+// options only libjpeg(-turbo) honours.
+void bench_jpeg_codecs(const std::string& path) {
+  gchar* contents = nullptr;
+  gsize length = 0;
+  if (!g_file_get_contents(path.c_str(), &contents, &length, nullptr)) return;
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(contents);
+
+  const JpegCodec& gdk = image_picker_master::GdkPixbufCodec();
+  const JpegCodec* libjpeg = image_picker_master::LibjpegCodec();
+  ImageBuffer pixels;
+  gdk.Decode(data, length, JpegDecodeOptions(), &pixels);
+  const double megapixels =
+      pixels.width * static_cast<double>(pixels.height) / 1e6;
+  const int runs = 3;
+
+  std::printf("\nJPEG codecs, %dx%d (MP/s, best of %d)\n", pixels.width,
+              pixels.height, runs);
+  std::printf("%-36s %10s\n", "path", "MP/s");
+  // Labelled with the codec's name, so a plain libjpeg build says so.
+  auto decode = [&](const JpegCodec& codec, const char* what,
+                    JpegDecodeOptions options) {
+    const std::string label = std::string("decode ") + codec.name() + what;
+    std::printf("%-36s %10.1f\n", label.c_str(),
+                megapixels_per_second(megapixels, runs, [&] {
+                  ImageBuffer out;
+                  codec.Decode(data, length, options, &out);
+                }));
+  };
+  auto encode = [&](const JpegCodec& codec, const char* what,
+                    JpegEncodeOptions options) {
+    const std::string label = std::string("encode ") + codec.name() + what;
+    std::printf("%-36s %10.1f\n", label.c_str(),
+                megapixels_per_second(megapixels, runs, [&] {
+                  std::vector<uint8_t> out;
+                  codec.Encode(pixels, options, &out);
+                }));
+  };
+
+  JpegDecodeOptions full;
+  JpegDecodeOptions fast;
+  fast.fast_dct      = true;
+  fast.fast_upsample = true;
+  JpegDecodeOptions quarter;
+  quarter.scale_denom = 4;
+  JpegEncodeOptions q85;
+  JpegEncodeOptions q85_fast;
+  q85_fast.fast_dct = true;
+  JpegEncodeOptions q85_444;
+  q85_444.subsampling = ChromaSubsampling::k444;
+
+  decode(gdk, "", full);
+  decode(gdk, " 1/4", quarter);
+  encode(gdk, " q85", q85);
+  if (libjpeg) {
+    const std::string name = libjpeg->name();
+    decode(*libjpeg, "", full);
+    decode(*libjpeg, " fast DCT", fast);
+    decode(*libjpeg, " 1/4", quarter);
+    std::printf("%-36s %10.1f\n", ("decode " + name + " YUV planes").c_str(),
+                megapixels_per_second(megapixels, runs, [&] {
+                  YuvImage yuv;
+                  libjpeg->DecodeYuv(data, length, &yuv);
+                }));
+    encode(*libjpeg, " q85 4:2:0", q85);
+    encode(*libjpeg, " q85 fast DCT", q85_fast);
+    encode(*libjpeg, " q85 4:4:4", q85_444);
+    YuvImage yuv;
+    libjpeg->DecodeYuv(data, length, &yuv);
+    std::printf("%-36s %10.1f\n",
+                ("encode " + name + " YUV planes q85").c_str(),
+                megapixels_per_second(megapixels, runs, [&] {
+                  std::vector<uint8_t> out;
+                  libjpeg->EncodeYuv(yuv, q85, &out);
+                }));
+  } else {
+    std::printf("(built without libjpeg: gdk-pixbuf only)\n");
+  }
+  g_free(contents);
+}
+
+// Size and time of one large JPEG re-encoded at q85 with each entropy and
+// subsampling setting, and of a lossless full-frame turn with each.
+void bench_jpeg_encode_options(const std::string& path) {
+  const JpegCodec* libjpeg = image_picker_master::LibjpegCodec();
+  if (!libjpeg) return;
+  gchar* contents = nullptr;
+  gsize length = 0;
+  if (!g_file_get_contents(path.c_str(), &contents, &length, nullptr)) return;
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(contents);
+  ImageBuffer pixels;
+  libjpeg->Decode(data, length, JpegDecodeOptions(), &pixels);
+  // A quarter turn clockwise leads with the bottom edge, which has to sit on
+  // the 16 px MCU grid.
+  const PixelRect frame{0, 0, pixels.width, pixels.height / 16 * 16};
+
+  struct Setting {
+    const char* label;
+    bool progressive;
+    bool optimize;
+    ChromaSubsampling subsampling;
+  };
+  const Setting settings[] = {
+      {"baseline 4:2:0", false, false, ChromaSubsampling::k420},
+      {"optimized Huffman 4:2:0", false, true, ChromaSubsampling::k420},
+      {"progressive 4:2:0", true, false, ChromaSubsampling::k420},
+      {"baseline 4:4:4", false, false, ChromaSubsampling::k444},
+      {"progressive 4:4:4", true, false, ChromaSubsampling::k444}};
+
+  std::printf("\nJPEG encode options, %dx%d q85 (best of 3)\n", pixels.width,
+              pixels.height);
+  std::printf("%-28s %10s %12s %14s %12s\n", "setting", "encode ms",
+              "bytes", "lossless ms", "bytes");
+  for (const Setting& setting : settings) {
+    JpegEncodeOptions options;
+    options.progressive     = setting.progressive;
+    options.optimize_coding = setting.optimize;
+    options.subsampling     = setting.subsampling;
+    std::vector<uint8_t> encoded, turned;
+    double encode_ms = 0, lossless_ms = 0;
+    for (int run = 0; run < 3; run++) {
+      Clock::time_point start = Clock::now();
+      libjpeg->Encode(pixels, options, &encoded);
+      double ms = seconds_since(start) * 1e3;
+      if (run == 0 || ms < encode_ms) encode_ms = ms;
+    }
+    // The lossless turn keeps the source's quality and subsampling.
+    const bool lossless = setting.subsampling == ChromaSubsampling::k420;
+    for (int run = 0; lossless && run < 3; run++) {
+      Clock::time_point start = Clock::now();
+      image_picker_master::TransformJpegLossless(data, length, frame, 270,
+                                                 false, options, &turned);
+      double ms = seconds_since(start) * 1e3;
+      if (run == 0 || ms < lossless_ms) lossless_ms = ms;
+    }
+    if (lossless) {
+      std::printf("%-28s %10.0f %12zu %14.0f %12zu\n", setting.label,
+                  encode_ms, encoded.size(), lossless_ms, turned.size());
+    } else {
+      std::printf("%-28s %10.0f %12zu %14s %12s\n", setting.label, encode_ms,
+                  encoded.size(), "-", "-");
+    }
+  }
+  g_free(contents);
+}
+
+// Centre crop of one large JPEG turned a quarter: DCT-domain transform vs
+// decode, crop + rotate and re-encode.
+void bench_lossless_crop(const std::string& path) {
+  const JpegCodec* libjpeg = image_picker_master::LibjpegCodec();
+  if (!libjpeg || !image_picker_master::LosslessJpegAvailable()) return;
+  gchar* contents = nullptr;
+  gsize length = 0;
+  if (!g_file_get_contents(path.c_str(), &contents, &length, nullptr)) return;
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(contents);
+  ImageProbe probe;
+  image_picker_master::ProbeImage(path, &probe);
+  const PixelRect crop{probe.width / 4, probe.height / 4, probe.width / 2,
+                       probe.height / 2};
+  auto milliseconds = [](int runs, auto fn) {
+    double best = 0;
+    for (int i = 0; i < runs; i++) {
+      Clock::time_point start = Clock::now();
+      fn();
+      double elapsed = seconds_since(start);
+      if (best == 0 || elapsed < best) best = elapsed;
+    }
+    return best * 1e3;
+  };
+
+  std::printf("\nCentre crop of a %dx%d JPEG, turned 90 (best of 3)\n",
+              probe.width, probe.height);
+  std::printf("%-36s %10s\n", "path", "ms");
+  std::printf("%-36s %10.1f\n", "TransformJpegLossless",
+              milliseconds(3, [&] {
+                std::vector<uint8_t> out;
+                image_picker_master::TransformJpegLossless(
+                    data, length, crop, 90, false, JpegEncodeOptions(), &out);
+              }));
+  std::printf("%-36s %10.1f\n", "decode + CropRotateScale + q85",
+              milliseconds(3, [&] {
+                ImageBuffer pixels;
+                libjpeg->Decode(data, length, JpegDecodeOptions(), &pixels);
+                CropRotateScaleSpec spec;
+                spec.origin_x   = crop.x;
+                spec.origin_y   = crop.y;
+                spec.rotation   = 90;
+                spec.out_width  = crop.height;
+                spec.out_height = crop.width;
+                ImageBuffer turned = image_picker_master::CropRotateScale(
+                    pixels, spec, &WorkerPool::Shared());
+                std::vector<uint8_t> out;
+                libjpeg->Encode(turned, JpegEncodeOptions(), &out);
+              }));
+  g_free(contents);
+}
+
+// maxBytes search on one large photo: a 1 MB budget reached with one
+// trial encode at a time and with a round of trials across the pool.
+void bench_size_budget(const std::string& path) {
+  gchar* contents = nullptr;
+  gsize length = 0;
+  if (!g_file_get_contents(path.c_str(), &contents, &length, nullptr)) return;
+  const JpegCodec& codec = image_picker_master::DefaultJpegCodec();
+  ImageBuffer pixels;
+  codec.Decode(reinterpret_cast<const uint8_t*>(contents), length,
+               JpegDecodeOptions(), &pixels);
+  g_free(contents);
+  if (pixels.empty()) return;
+
+  image_picker_master::SizeBudget budget;
+  budget.max_bytes = 1 << 20;
+  budget.max_quality = 85;
+  image_picker_master::BudgetEncoder encode =
+      [&codec](const ImageBuffer& trial, int quality,
+               std::vector<uint8_t>* out) {
+        JpegEncodeOptions options;
+        options.quality = quality;
+        return codec.Encode(trial, options, out);
+      };
+
+  std::printf("\n1 MB budget for a %dx%d JPEG (%zu bytes)\n", pixels.width,
+              pixels.height, static_cast<size_t>(length));
+  std::printf("%-12s %8s %8s %12s %8s %10s\n", "trials", "ms", "quality",
+              "size", "encodes", "bytes");
+  for (WorkerPool* pool : {static_cast<WorkerPool*>(nullptr),
+                           &WorkerPool::Shared()}) {
+    std::vector<uint8_t> out;
+    image_picker_master::BudgetResult result;
+    Clock::time_point start = Clock::now();
+    image_picker_master::EncodeWithinBudget(pixels, budget, encode, pool, &out,
+                                            &result);
+    double ms = seconds_since(start) * 1e3;
+    char size[32];
+    std::snprintf(size, sizeof(size), "%dx%d", result.width, result.height);
+    std::printf("%-12s %8.0f %8d %12s %8d %10zu\n",
+                pool ? "parallel" : "serial", ms, result.quality, size,
+                result.trials, out.size());
+  }
+}
+
+// pickFiles(allowCompression: true) on one large photo at full size and
+// with maxWidth: the scaled decode and smaller encode should shrink both
+// the time and the output.
+void bench_max_dimensions(ImagePickerMasterPlugin* plugin,
+                          const std::string& path) {
+  std::printf("\nCompressing one large JPEG at q80\n");
+  std::printf("%-12s %8s %12s %10s\n", "maxWidth", "ms", "size", "bytes");
+  for (int max_width : {0, 4096, 2048, 1024}) {
+    FileMapOptions options;
+    options.allow_compression   = true;
+    options.compression_quality = 80;
+    options.max_width           = max_width;
+    Clock::time_point start = Clock::now();
+    FlValue* list = build_file_list({path}, options, WorkerPool::Shared(),
+                                    plugin);
+    double ms = seconds_since(start) * 1e3;
+    FlValue* file = fl_value_get_list_value(list, 0);
+    ImageProbe probe;
+    image_picker_master::ProbeImage(
+        fl_value_get_string(fl_value_lookup_string(file, "path")), &probe);
+    char size[32];
+    std::snprintf(size, sizeof(size), "%dx%d", probe.width, probe.height);
+    std::printf("%-12s %8.0f %12s %10" G_GINT64_FORMAT "\n",
+                max_width ? std::to_string(max_width).c_str() : "none", ms,
+                size, fl_value_get_int(fl_value_lookup_string(file, "size")));
+    fl_value_unref(list);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int file_count = argc > 1 ? std::atoi(argv[1]) : 64;
+  int edge       = argc > 2 ? std::atoi(argv[2]) : 2048;
+
+  std::string dir = std::string(g_get_tmp_dir()) + "/image_picker_master_bench";
+  std::vector<std::string> paths = make_jpeg_corpus(dir, file_count, edge);
+
+  ImagePickerMasterPlugin* plugin = static_cast<ImagePickerMasterPlugin*>(
+      g_object_new(image_picker_master_plugin_get_type(), nullptr));
+
+  bench_pick_files_scaling(plugin, paths);
+  bench_resample(8000, 6000, 1024, 768);
+  bench_resample_scaling(12000, 9000, 1024, 768);
+  std::string large = make_jpeg_corpus(dir + "/probe", 1, 7000).front();
+  bench_probe(large);
+  bench_jpeg_codecs(large);
+  bench_lossless_crop(large);
+  bench_jpeg_encode_options(large);
+  bench_size_budget(large);
+  bench_max_dimensions(plugin, large);
+
+  g_object_unref(plugin);  // dispose removes the compressed copies
+  std::error_code ec;
+  std::filesystem::remove_all(dir, ec);
+  return 0;
+}
@@ -2,8 +2,44 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib/gstdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "include/image_picker_master/image_picker_master_plugin.h"
+#include "chunked_file_reader.h"
+#include "decoded_image_cache.h"
+#include "exif_parser.h"
+#include "heif_decoder.h"
+#include "image_codec.h"
 #include "image_picker_master_plugin_private.h"
+#include "image_probe.h"
+#include "image_resampler.h"
+#include "image_transform.h"
+#include "jpeg_decoder.h"
+#include "jpeg_lossless.h"
+#include "mapped_file.h"
+#include "preview_cache.h"
+#include "size_budget.h"
+#include "webp_encoder.h"
+#include "worker_pool.h"
+
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBHEIF
+#include <libheif/heif.h>
+#endif
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBWEBP
+#include <webp/decode.h>
+#endif
 
 // This demonstrates a simple unit test of the C portion of this plugin's
 // implementation.
@@ -27,5 +63,1711 @@ TEST(ImagePickerMasterPlugin, GetPlatformVersion) {
   EXPECT_THAT(fl_value_get_string(result), testing::StartsWith("Linux "));
 }
 
+TEST(WorkerPool, RunsEveryQueuedJobBeforeDestruction) {
+  std::atomic<int> ran{0};
+  {
+    WorkerPool pool(3);
+    EXPECT_EQ(pool.size(), 3u);
+    for (int i = 0; i < 100; i++) {
+      pool.Submit([&ran]() { ran++; });
+    }
+  }
+  EXPECT_EQ(ran.load(), 100);
+}
+
+TEST(WorkerPool, ParallelForVisitsEveryIndexOnce) {
+  WorkerPool pool(4);
+  std::vector<std::atomic<int>> hits(1000);
+  pool.ParallelFor(hits.size(), [&hits](size_t i) { hits[i]++; });
+  for (const auto& h : hits) EXPECT_EQ(h.load(), 1);
+}
+
+TEST(ImagePickerMasterPlugin, FileDetailsComputeOnlyRequestedFields) {
+  std::string path = std::string(g_get_tmp_dir()) + "/ipm_details_test.png";
+  GdkPixbuf* image = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, 40, 30);
+  gdk_pixbuf_fill(image, 0x336699ff);
+  ASSERT_TRUE(gdk_pixbuf_save(image, path.c_str(), "png", nullptr, nullptr));
+  g_object_unref(image);
+
+  WorkerPool pool(2);
+  FileDetailFields fields;
+  fields.size = true;
+  fields.dimensions = true;
+  std::vector<std::string> paths = {path, path + ".missing"};
+  g_autoptr(FlValue) list = build_file_details(paths, fields, pool);
+  ASSERT_EQ(fl_value_get_length(list), 2u);
+
+  FlValue* found = fl_value_get_list_value(list, 0);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(found, "name")),
+               "ipm_details_test.png");
+  EXPECT_GT(fl_value_get_int(fl_value_lookup_string(found, "size")), 0);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(found, "width")), 40);
+  EXPECT_EQ(fl_value_get_int(fl_value_lookup_string(found, "height")), 30);
+  EXPECT_EQ(fl_value_lookup_string(found, "mimeType"), nullptr);  // not asked
+  EXPECT_EQ(fl_value_lookup_string(found, "bytes"), nullptr);
+
+  FlValue* missing = fl_value_get_list_value(list, 1);
+  EXPECT_EQ(fl_value_get_type(fl_value_lookup_string(missing, "size")),
+            FL_VALUE_TYPE_NULL);
+  EXPECT_EQ(fl_value_get_type(fl_value_lookup_string(missing, "width")),
+            FL_VALUE_TYPE_NULL);
+
+  g_remove(path.c_str());
+}
+
+TEST(JpegDecoder, RegionMatchesFullDecode) {
+  if (!JpegRegionDecodeAvailable()) GTEST_SKIP() << "built without libjpeg";
+
+  const int w = 640, h = 480;
+  GdkPixbuf* gradient = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, w, h);
+  guchar* px = gdk_pixbuf_get_pixels(gradient);
+  int stride = gdk_pixbuf_get_rowstride(gradient);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      guchar* p = px + y * stride + x * 3;
+      p[0] = static_cast<guchar>(x);
+      p[1] = static_cast<guchar>(y);
+      p[2] = static_cast<guchar>(x + y);
+    }
+  }
+  std::string path = std::string(g_get_tmp_dir()) + "/ipm_region_test.jpg";
+  ASSERT_TRUE(gdk_pixbuf_save(gradient, path.c_str(), "jpeg", nullptr,
+                              "quality", "95", nullptr));
+  g_object_unref(gradient);
+
+  JpegRegion full;
+  JpegRegion part;
+  ASSERT_TRUE(DecodeJpegRegion(path, PixelRect{0, 0, w, h}, 1, &full));
+  ASSERT_TRUE(DecodeJpegRegion(path, PixelRect{333, 222, 100, 50}, 1, &part));
+
+  // The decoded block covers the request and lines up with the full decode.
+  const PixelRect& r = part.source_rect;
+  EXPECT_LE(r.x, 333);
+  EXPECT_LE(r.y, 222);
+  EXPECT_GE(r.x + r.width, 433);
+  EXPECT_GE(r.y + r.height, 272);
+  EXPECT_LT(part.pixels.width, w);
+  for (int y = 0; y < part.pixels.height; y++) {
+    const uint8_t* a = part.pixels.row(y);
+    const uint8_t* b = full.pixels.row(r.y + y) + r.x * 3;
+    for (int x = 0; x < part.pixels.width * 3; x++) {
+      ASSERT_LE(std::abs(a[x] - b[x]), 2) << "at " << x / 3 << "," << y;
+    }
+  }
+
+  JpegRegion eighth;
+  ASSERT_TRUE(DecodeJpegRegion(path, PixelRect{0, 0, w, h}, 8, &eighth));
+  EXPECT_EQ(eighth.pixels.width, w / 8);
+  EXPECT_EQ(eighth.pixels.height, h / 8);
+  std::remove(path.c_str());
+}
+
+// Smooth enough for JPEG to reproduce within a few levels.
+ImageBuffer make_gradient(int w, int h, int channels) {
+  ImageBuffer buffer = ImageBuffer::Allocate(w, h, channels);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      uint8_t* p = buffer.row(y) + x * channels;
+      p[0] = static_cast<uint8_t>(x * 255 / w);
+      p[1] = static_cast<uint8_t>(y * 255 / h);
+      p[2] = static_cast<uint8_t>((x + y) * 127 / (w + h) + 64);
+      if (channels == 4) p[3] = 255;
+    }
+  }
+  return buffer;
+}
+
+ImageBuffer make_noise(int w, int h, int channels) {
+  ImageBuffer buffer = ImageBuffer::Allocate(w, h, channels);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w * channels; x++) {
+      buffer.row(y)[x] = static_cast<uint8_t>(g_random_int());
+    }
+  }
+  return buffer;
+}
+
+double mean_abs_error(const ImageBuffer& a, const ImageBuffer& b) {
+  double total = 0;
+  for (int y = 0; y < a.height; y++) {
+    for (int x = 0; x < a.width; x++) {
+      for (int c = 0; c < 3; c++) {
+        total += std::abs(a.row(y)[x * a.channels + c] -
+                          b.row(y)[x * b.channels + c]);
+      }
+    }
+  }
+  return total / (a.width * a.height * 3.0);
+}
+
+// Luma sampling byte (h << 4 | v) of the first SOF0 segment.
+int luma_sampling(const std::vector<uint8_t>& jpeg) {
+  for (size_t i = 2; i + 12 < jpeg.size(); i++) {
+    if (jpeg[i] == 0xFF && jpeg[i + 1] == 0xC0) return jpeg[i + 11];
+  }
+  return -1;
+}
+
+TEST(ImageCodec, LibjpegRoundTripsEachSubsampling) {
+  const JpegCodec* codec = LibjpegCodec();
+  if (!codec) GTEST_SKIP() << "built without libjpeg";
+
+  const std::pair<ChromaSubsampling, int> cases[] = {
+      {ChromaSubsampling::k444, 0x11},
+      {ChromaSubsampling::k422, 0x21},
+      {ChromaSubsampling::k420, 0x22}};
+  for (int channels : {3, 4}) {
+    ImageBuffer src = make_gradient(61, 45, channels);
+    for (const auto& [subsampling, sampling_byte] : cases) {
+      JpegEncodeOptions encode;
+      encode.quality     = 95;
+      encode.subsampling = subsampling;
+      std::vector<uint8_t> jpeg;
+      ASSERT_TRUE(codec->Encode(src, encode, &jpeg));
+      EXPECT_EQ(luma_sampling(jpeg), sampling_byte);
+
+      ImageBuffer decoded;
+      ASSERT_TRUE(codec->Decode(jpeg.data(), jpeg.size(), JpegDecodeOptions(),
+                                &decoded));
+      ASSERT_EQ(decoded.width, 61);
+      ASSERT_EQ(decoded.height, 45);
+      EXPECT_LT(mean_abs_error(src, decoded), 2.0);
+
+      JpegDecodeOptions fast;
+      fast.fast_dct      = true;
+      fast.fast_upsample = true;
+      ImageBuffer quick;
+      ASSERT_TRUE(codec->Decode(jpeg.data(), jpeg.size(), fast, &quick));
+      EXPECT_LT(mean_abs_error(decoded, quick), 2.0);
+
+      JpegDecodeOptions quarter;
+      quarter.scale_denom = 4;
+      ImageBuffer small;
+      ASSERT_TRUE(codec->Decode(jpeg.data(), jpeg.size(), quarter, &small));
+      EXPECT_EQ(small.width, 16);  // ceil(61 / 4)
+      EXPECT_EQ(small.height, 12);
+    }
+  }
+
+  std::vector<uint8_t> garbage(100, 0x42);
+  ImageBuffer none;
+  EXPECT_FALSE(codec->Decode(garbage.data(), garbage.size(),
+                             JpegDecodeOptions(), &none));
+  EXPECT_TRUE(none.empty());
+}
+
+TEST(ImageCodec, ProgressiveAndOptimizedOnlyChangeTheCoding) {
+  const JpegCodec* codec = LibjpegCodec();
+  if (!codec) GTEST_SKIP() << "built without libjpeg";
+
+  ImageBuffer src = make_noise(96, 64, 3);
+  auto encode = [&](bool progressive, bool optimize) {
+    JpegEncodeOptions options;
+    options.quality         = 80;
+    options.progressive     = progressive;
+    options.optimize_coding = optimize;
+    std::vector<uint8_t> jpeg;
+    EXPECT_TRUE(codec->Encode(src, options, &jpeg));
+    return jpeg;
+  };
+  auto has_marker = [](const std::vector<uint8_t>& jpeg, uint8_t marker) {
+    for (size_t i = 2; i + 1 < jpeg.size(); i++) {
+      if (jpeg[i] == 0xFF && jpeg[i + 1] == marker) return true;
+    }
+    return false;
+  };
+  std::vector<uint8_t> baseline    = encode(false, false);
+  std::vector<uint8_t> optimized   = encode(false, true);
+  std::vector<uint8_t> progressive = encode(true, false);
+  EXPECT_LT(optimized.size(), baseline.size());
+  EXPECT_TRUE(has_marker(baseline, 0xC0));
+  EXPECT_TRUE(has_marker(progressive, 0xC2));  // SOF2
+
+  // Same quantized coefficients, so the same pixels.
+  ImageBuffer expected;
+  ASSERT_TRUE(codec->Decode(baseline.data(), baseline.size(),
+                            JpegDecodeOptions(), &expected));
+  for (const std::vector<uint8_t>* jpeg : {&optimized, &progressive}) {
+    ImageBuffer decoded;
+    ASSERT_TRUE(codec->Decode(jpeg->data(), jpeg->size(), JpegDecodeOptions(),
+                              &decoded));
+    EXPECT_EQ(mean_abs_error(decoded, expected), 0.0);
+  }
+}
+
+TEST(ImageCodec, YuvTranscodeKeepsPlanesAndSubsampling) {
+  const JpegCodec* codec = LibjpegCodec();
+  if (!codec) GTEST_SKIP() << "built without libjpeg";
+
+  struct Case {
+    ChromaSubsampling subsampling;
+    int sampling_byte, chroma_w, chroma_h, mcu_w, mcu_h;
+  };
+  const Case cases[] = {{ChromaSubsampling::k444, 0x11, 61, 45, 8, 8},
+                        {ChromaSubsampling::k422, 0x21, 31, 45, 16, 8},
+                        {ChromaSubsampling::k420, 0x22, 31, 23, 16, 16}};
+  ImageBuffer src = make_gradient(61, 45, 3);
+  for (const Case& c : cases) {
+    JpegEncodeOptions encode;
+    encode.quality     = 95;
+    encode.subsampling = c.subsampling;
+    std::vector<uint8_t> jpeg;
+    ASSERT_TRUE(codec->Encode(src, encode, &jpeg));
+
+    YuvImage yuv;
+    ASSERT_TRUE(codec->DecodeYuv(jpeg.data(), jpeg.size(), &yuv));
+    EXPECT_EQ(yuv.subsampling, c.subsampling);
+    EXPECT_EQ(yuv.plane_width(0), 61);
+    EXPECT_EQ(yuv.plane_height(0), 45);
+    EXPECT_EQ(yuv.plane_width(1), c.chroma_w);
+    EXPECT_EQ(yuv.plane_height(2), c.chroma_h);
+    EXPECT_EQ(yuv.strides[0] % c.mcu_w, 0);  // padded to whole MCUs
+    EXPECT_EQ(yuv.rows[0] % c.mcu_h, 0);
+
+    // Re-encoding the planes keeps the file's subsampling whatever the
+    // options ask for.
+    encode.subsampling = c.subsampling == ChromaSubsampling::k444
+                             ? ChromaSubsampling::k420
+                             : ChromaSubsampling::k444;
+    std::vector<uint8_t> again;
+    ASSERT_TRUE(codec->EncodeYuv(yuv, encode, &again));
+    EXPECT_EQ(luma_sampling(again), c.sampling_byte);
+
+    ImageBuffer first, second;
+    ASSERT_TRUE(codec->Decode(jpeg.data(), jpeg.size(), JpegDecodeOptions(),
+                              &first));
+    ASSERT_TRUE(codec->Decode(again.data(), again.size(), JpegDecodeOptions(),
+                              &second));
+    EXPECT_LT(mean_abs_error(first, second), 1.5);
+  }
+}
+
+TEST(ImageCodec, GdkPixbufBackendAgreesWithLibjpeg) {
+  const JpegCodec& gdk = GdkPixbufCodec();
+  ImageBuffer src = make_gradient(61, 45, 3);
+  JpegEncodeOptions encode;
+  encode.quality = 95;
+  std::vector<uint8_t> jpeg;
+  ASSERT_TRUE(gdk.Encode(src, encode, &jpeg));
+  EXPECT_EQ(luma_sampling(jpeg), 0x22);
+
+  ImageBuffer decoded;
+  ASSERT_TRUE(gdk.Decode(jpeg.data(), jpeg.size(), JpegDecodeOptions(),
+                         &decoded));
+  ASSERT_EQ(decoded.width, 61);
+  EXPECT_LT(mean_abs_error(src, decoded), 2.0);
+
+  JpegDecodeOptions half;
+  half.scale_denom = 2;
+  ImageBuffer small;
+  ASSERT_TRUE(gdk.Decode(jpeg.data(), jpeg.size(), half, &small));
+  EXPECT_EQ(small.width, 31);
+  EXPECT_EQ(small.height, 23);
+
+  YuvImage yuv;
+  EXPECT_FALSE(gdk.DecodeYuv(jpeg.data(), jpeg.size(), &yuv));
+
+  if (const JpegCodec* libjpeg = LibjpegCodec()) {
+    ImageBuffer ours;
+    ASSERT_TRUE(libjpeg->Decode(jpeg.data(), jpeg.size(), JpegDecodeOptions(),
+                                &ours));
+    EXPECT_LT(mean_abs_error(decoded, ours), 1.0);
+  }
+}
+
+TEST(JpegLossless, TurnsMatchPixelTransformAndUndoExactly) {
+  const JpegCodec* codec = LibjpegCodec();
+  if (!codec || !LosslessJpegAvailable()) GTEST_SKIP() << "built without libjpeg";
+
+  ImageBuffer src = make_gradient(100, 76, 3);
+  const PixelRect crop{16, 16, 48, 32};  // on the MCU grid for every sampling
+  const JpegEncodeOptions baseline;
+  for (ChromaSubsampling subsampling :
+       {ChromaSubsampling::k444, ChromaSubsampling::k422,
+        ChromaSubsampling::k420}) {
+    JpegEncodeOptions encode;
+    encode.quality     = 90;
+    encode.subsampling = subsampling;
+    std::vector<uint8_t> jpeg;
+    ASSERT_TRUE(codec->Encode(src, encode, &jpeg));
+    ImageBuffer decoded;
+    ASSERT_TRUE(codec->Decode(jpeg.data(), jpeg.size(), JpegDecodeOptions(),
+                              &decoded));
+
+    std::vector<uint8_t> upright;
+    ASSERT_TRUE(TransformJpegLossless(jpeg.data(), jpeg.size(), crop, 0,
+                                      false, baseline, &upright));
+    // Progressive scans and fitted Huffman tables carry the same
+    // coefficients, so they decode to the same pixels.
+    JpegEncodeOptions progressive;
+    progressive.progressive = true;
+    std::vector<uint8_t> rescanned;
+    ASSERT_TRUE(TransformJpegLossless(jpeg.data(), jpeg.size(), crop, 0,
+                                      false, progressive, &rescanned));
+    ImageBuffer upright_pixels, rescanned_pixels;
+    ASSERT_TRUE(codec->Decode(upright.data(), upright.size(),
+                              JpegDecodeOptions(), &upright_pixels));
+    ASSERT_TRUE(codec->Decode(rescanned.data(), rescanned.size(),
+                              JpegDecodeOptions(), &rescanned_pixels));
+    EXPECT_EQ(mean_abs_error(rescanned_pixels, upright_pixels), 0.0);
+    for (int rotation : {0, 90, 180, 270}) {
+      for (bool mirror : {false, true}) {
+        std::vector<uint8_t> turned;
+        PixelRect applied;
+        ASSERT_TRUE(TransformJpegLossless(jpeg.data(), jpeg.size(), crop,
+                                          rotation, mirror, baseline, &turned,
+                                          &applied));
+        EXPECT_EQ(applied.x, crop.x);
+        EXPECT_EQ(applied.width, crop.width);
+
+        // Same pixels as turning the decoded source, up to chroma
+        // upsampling at the new edges.
+        bool quarter = rotation == 90 || rotation == 270;
+        CropRotateScaleSpec spec;
+        spec.origin_x   = crop.x;
+        spec.origin_y   = crop.y;
+        spec.rotation   = rotation;
+        spec.mirror     = mirror;
+        spec.out_width  = quarter ? crop.height : crop.width;
+        spec.out_height = quarter ? crop.width : crop.height;
+        ImageBuffer expected = CropRotateScale(decoded, spec);
+        ImageBuffer ours;
+        ASSERT_TRUE(codec->Decode(turned.data(), turned.size(),
+                                  JpegDecodeOptions(), &ours));
+        ASSERT_EQ(ours.width, expected.width);
+        ASSERT_EQ(ours.height, expected.height);
+        EXPECT_LT(mean_abs_error(ours, expected), 1.0)
+            << "rotation " << rotation << ", mirror " << mirror;
+
+        // Coefficients are moved, never requantized: turning back gives
+        // the upright crop byte for byte.
+        int back = mirror ? rotation : (360 - rotation) % 360;
+        std::vector<uint8_t> undone;
+        ASSERT_TRUE(TransformJpegLossless(
+            turned.data(), turned.size(), PixelRect{0, 0, 1000, 1000}, back,
+            mirror, baseline, &undone));
+        EXPECT_EQ(undone, upright)
+            << "rotation " << rotation << ", mirror " << mirror;
+      }
+    }
+
+    // Leading edges snap outward to the MCU grid; trailing edges stay.
+    std::vector<uint8_t> out;
+    PixelRect applied;
+    ASSERT_TRUE(TransformJpegLossless(jpeg.data(), jpeg.size(),
+                                      PixelRect{20, 18, 50, 40}, 0, false,
+                                      baseline, &out, &applied));
+    const int mcu_w = subsampling == ChromaSubsampling::k444 ? 8 : 16;
+    const int mcu_h = subsampling == ChromaSubsampling::k420 ? 16 : 8;
+    EXPECT_EQ(applied.x, 20 / mcu_w * mcu_w);
+    EXPECT_EQ(applied.y, 18 / mcu_h * mcu_h);
+    EXPECT_EQ(applied.x + applied.width, 70);
+    EXPECT_EQ(applied.y + applied.height, 58);
+
+    // 100 is not on the grid, so the right edge cannot lead after a flip.
+    EXPECT_FALSE(TransformJpegLossless(jpeg.data(), jpeg.size(),
+                                       PixelRect{60, 0, 40, 32}, 180, false,
+                                       baseline, &out));
+    EXPECT_TRUE(out.empty());
+  }
+
+  std::vector<uint8_t> garbage(100, 0x42);
+  std::vector<uint8_t> out;
+  EXPECT_FALSE(TransformJpegLossless(garbage.data(), garbage.size(),
+                                     PixelRect{0, 0, 8, 8}, 90, false,
+                                     baseline, &out));
+}
+
+TEST(WebpEncoder, LosslessIsExactAndAlphaSurvives) {
+  if (!WebpEncoderAvailable()) GTEST_SKIP() << "built without libwebp";
+
+  // Alpha never reaches 0, where libwebp may rewrite the hidden colour.
+  ImageBuffer src = make_gradient(61, 45, 4);
+  for (int y = 0; y < src.height; y++) {
+    for (int x = 0; x < src.width; x++) {
+      src.row(y)[x * 4 + 3] = static_cast<uint8_t>(1 + x * 254 / src.width);
+    }
+  }
+
+  WebpEncodeOptions lossless;
+  lossless.lossless = true;
+  std::vector<uint8_t> exact;
+  ASSERT_TRUE(EncodeWebp(src, lossless, &exact));
+  ImageProbe probe;
+  ASSERT_TRUE(ProbeImageData(exact.data(), exact.size(), &probe));
+  EXPECT_EQ(probe.format, "webp");
+  EXPECT_EQ(probe.width, 61);
+  EXPECT_EQ(probe.height, 45);
+  EXPECT_TRUE(probe.has_alpha);
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBWEBP
+  int w = 0, h = 0;
+  uint8_t* decoded = WebPDecodeRGBA(exact.data(), exact.size(), &w, &h);
+  ASSERT_NE(decoded, nullptr);
+  ASSERT_EQ(w, 61);
+  ASSERT_EQ(h, 45);
+  for (int y = 0; y < h; y++) {
+    EXPECT_EQ(memcmp(decoded + y * w * 4, src.row(y), w * 4), 0) << "row " << y;
+  }
+  WebPFree(decoded);
+#endif
+
+  for (int method : {0, 6}) {
+    WebpEncodeOptions lossy;
+    lossy.quality = 75;
+    lossy.method  = method;
+    std::vector<uint8_t> small;
+    ASSERT_TRUE(EncodeWebp(src, lossy, &small));
+    ASSERT_TRUE(ProbeImageData(small.data(), small.size(), &probe));
+    EXPECT_TRUE(probe.has_alpha);
+  }
+
+  std::vector<uint8_t> opaque;
+  ASSERT_TRUE(EncodeWebp(make_gradient(61, 45, 3), WebpEncodeOptions(),
+                         &opaque));
+  ASSERT_TRUE(ProbeImageData(opaque.data(), opaque.size(), &probe));
+  EXPECT_FALSE(probe.has_alpha);
+}
+
+TEST(ImagePickerMasterPlugin, CompressesToTheRequestedFormat) {
+  std::string path = std::string(g_get_tmp_dir()) + "/ipm_compress_test.png";
+  GdkPixbuf* image = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, 40, 30);
+  gdk_pixbuf_fill(image, 0x33669980);
+  // Stored without deflate, so every copy below is smaller and kept.
+  ASSERT_TRUE(gdk_pixbuf_save(image, path.c_str(), "png", nullptr,
+                              "compression", "0", nullptr));
+  g_object_unref(image);
+
+  ImagePickerMasterPlugin* plugin = static_cast<ImagePickerMasterPlugin*>(
+      g_object_new(image_picker_master_plugin_get_type(), nullptr));
+  WorkerPool pool(2);
+  const bool webp = WebpEncoderAvailable();
+  const std::pair<OutputFormat, const char*> cases[] = {
+      {OutputFormat::kJpeg, "image/jpeg"},
+      {OutputFormat::kWebpLossy, webp ? "image/webp" : "image/jpeg"},
+      {OutputFormat::kWebpLossless, webp ? "image/webp" : "image/jpeg"}};
+  for (const auto& [format, mime_type] : cases) {
+    FileMapOptions options;
+    options.allow_compression  = true;
+    options.compression_format = webp ? format : OutputFormat::kJpeg;
+    g_autoptr(FlValue) list = build_file_list({path}, options, pool, plugin);
+    ASSERT_EQ(fl_value_get_length(list), 1u);
+    FlValue* file = fl_value_get_list_value(list, 0);
+    EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(file, "mimeType")),
+                 mime_type);
+    // WebP keeps the PNG's alpha; JPEG cannot.
+    EXPECT_EQ(fl_value_get_bool(fl_value_lookup_string(file, "hasAlpha")),
+              strcmp(mime_type, "image/webp") == 0);
+  }
+
+  g_object_unref(plugin);  // dispose removes the compressed copies
+  g_remove(path.c_str());
+}
+
+TEST(ImagePickerMasterPlugin, AllowCompressionSkipsWhatCannotShrink) {
+  const std::string dir = g_get_tmp_dir();
+  const JpegCodec& codec = DefaultJpegCodec();
+  auto write_jpeg = [&](const std::string& path, int quality) {
+    JpegEncodeOptions encode;
+    encode.quality = quality;
+    std::vector<uint8_t> jpeg;
+    return codec.Encode(make_noise(200, 150, 3), encode, &jpeg) &&
+           g_file_set_contents(path.c_str(),
+                               reinterpret_cast<const gchar*>(jpeg.data()),
+                               static_cast<gssize>(jpeg.size()), nullptr);
+  };
+  const std::string low  = dir + "/ipm_skip_q60.jpg";
+  const std::string high = dir + "/ipm_skip_q95.jpg";
+  ASSERT_TRUE(write_jpeg(low, 60));
+  ASSERT_TRUE(write_jpeg(high, 95));
+  // A flat PNG deflates far below any JPEG of it.
+  const std::string flat = dir + "/ipm_skip_flat.png";
+  GdkPixbuf* image = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, 320, 240);
+  gdk_pixbuf_fill(image, 0x336699ff);
+  ASSERT_TRUE(gdk_pixbuf_save(image, flat.c_str(), "png", nullptr, nullptr));
+  g_object_unref(image);
+
+  ImagePickerMasterPlugin* plugin = static_cast<ImagePickerMasterPlugin*>(
+      g_object_new(image_picker_master_plugin_get_type(), nullptr));
+  WorkerPool pool(2);
+  FileMapOptions options;
+  options.allow_compression   = true;
+  options.compression_quality = 80;
+  g_autoptr(FlValue) list =
+      build_file_list({low, high, flat}, options, pool, plugin);
+  ASSERT_EQ(fl_value_get_length(list), 3u);
+  auto path_of = [&](size_t i) {
+    return std::string(fl_value_get_string(fl_value_lookup_string(
+        fl_value_get_list_value(list, i), "path")));
+  };
+  EXPECT_EQ(path_of(0), low);    // already below quality 80
+  EXPECT_NE(path_of(1), high);   // re-encoded smaller
+  EXPECT_EQ(path_of(2), flat);   // the JPEG would be larger
+
+  // A dimension cap still applies to the low-quality JPEG.
+  options.max_width = 100;
+  g_autoptr(FlValue) capped = build_file_list({low}, options, pool, plugin);
+  EXPECT_NE(std::string(fl_value_get_string(fl_value_lookup_string(
+                fl_value_get_list_value(capped, 0), "path"))),
+            low);
+
+  g_object_unref(plugin);
+  for (const std::string& path : {low, high, flat}) g_remove(path.c_str());
+}
+
+TEST(ImagePickerMasterPlugin, CompressedCopiesFollowJpegOptions) {
+  const JpegCodec* codec = LibjpegCodec();
+  if (!codec) GTEST_SKIP() << "built without libjpeg";
+
+  // A 4:2:0 JPEG above the requested quality, so it is re-encoded.
+  std::string path = std::string(g_get_tmp_dir()) + "/ipm_jpeg_options.jpg";
+  JpegEncodeOptions source;
+  source.quality = 95;
+  std::vector<uint8_t> jpeg;
+  ASSERT_TRUE(codec->Encode(make_noise(160, 120, 3), source, &jpeg));
+  ASSERT_TRUE(g_file_set_contents(path.c_str(),
+                                  reinterpret_cast<const gchar*>(jpeg.data()),
+                                  static_cast<gssize>(jpeg.size()), nullptr));
+
+  ImagePickerMasterPlugin* plugin = static_cast<ImagePickerMasterPlugin*>(
+      g_object_new(image_picker_master_plugin_get_type(), nullptr));
+  WorkerPool pool(2);
+  auto compress = [&](const FileMapOptions& options) {
+    g_autoptr(FlValue) list = build_file_list({path}, options, pool, plugin);
+    const gchar* copy = fl_value_get_string(fl_value_lookup_string(
+        fl_value_get_list_value(list, 0), "path"));
+    gchar* contents = nullptr;
+    gsize length = 0;
+    EXPECT_TRUE(g_file_get_contents(copy, &contents, &length, nullptr));
+    std::vector<uint8_t> bytes(contents, contents + length);
+    g_free(contents);
+    return bytes;
+  };
+
+  FileMapOptions options;
+  options.allow_compression   = true;
+  options.compression_quality = 80;
+  options.jpeg.progressive    = true;
+  std::vector<uint8_t> progressive = compress(options);
+  bool sof2 = false;
+  for (size_t i = 2; i + 1 < progressive.size(); i++) {
+    sof2 = sof2 || (progressive[i] == 0xFF && progressive[i + 1] == 0xC2);
+  }
+  EXPECT_TRUE(sof2);
+
+  // An explicit subsampling bypasses the YCbCr transcode, which would keep
+  // the source's 4:2:0.
+  options = FileMapOptions();
+  options.allow_compression    = true;
+  options.compression_quality  = 80;
+  options.jpeg.subsampling     = ChromaSubsampling::k444;
+  options.jpeg_subsampling_set = true;
+  EXPECT_EQ(luma_sampling(compress(options)), 0x11);
+
+  g_object_unref(plugin);
+  g_remove(path.c_str());
+}
+
+TEST(ImagePickerMasterPlugin, LowQualityJpegGetsCodingLosslessly) {
+  const JpegCodec* codec = LibjpegCodec();
+  if (!codec || !LosslessJpegAvailable()) GTEST_SKIP() << "built without libjpeg";
+
+  // Already below the requested quality: re-encoding would only lose
+  // detail, but a progressive copy was asked for.
+  std::string path = std::string(g_get_tmp_dir()) + "/ipm_jpeg_q60.jpg";
+  JpegEncodeOptions source;
+  source.quality = 60;
+  std::vector<uint8_t> jpeg;
+  ASSERT_TRUE(codec->Encode(make_noise(160, 120, 3), source, &jpeg));
+  ASSERT_TRUE(g_file_set_contents(path.c_str(),
+                                  reinterpret_cast<const gchar*>(jpeg.data()),
+                                  static_cast<gssize>(jpeg.size()), nullptr));
+
+  ImagePickerMasterPlugin* plugin = static_cast<ImagePickerMasterPlugin*>(
+      g_object_new(image_picker_master_plugin_get_type(), nullptr));
+  WorkerPool pool(2);
+  FileMapOptions options;
+  options.allow_compression   = true;
+  options.compression_quality = 80;
+  options.jpeg.progressive    = true;
+  g_autoptr(FlValue) list = build_file_list({path}, options, pool, plugin);
+  const gchar* copy = fl_value_get_string(fl_value_lookup_string(
+      fl_value_get_list_value(list, 0), "path"));
+  EXPECT_NE(path, copy);
+
+  gchar* contents = nullptr;
+  gsize length = 0;
+  ASSERT_TRUE(g_file_get_contents(copy, &contents, &length, nullptr));
+  std::vector<uint8_t> progressive(contents, contents + length);
+  g_free(contents);
+  bool sof2 = false;
+  for (size_t i = 2; i + 1 < progressive.size(); i++) {
+    sof2 = sof2 || (progressive[i] == 0xFF && progressive[i + 1] == 0xC2);
+  }
+  EXPECT_TRUE(sof2);
+
+  // Same DCT blocks, so the same pixels.
+  ImageBuffer expected, decoded;
+  ASSERT_TRUE(codec->Decode(jpeg.data(), jpeg.size(), JpegDecodeOptions(),
+                            &expected));
+  ASSERT_TRUE(codec->Decode(progressive.data(), progressive.size(),
+                            JpegDecodeOptions(), &decoded));
+  EXPECT_EQ(mean_abs_error(decoded, expected), 0.0);
+
+  g_object_unref(plugin);
+  g_remove(path.c_str());
+}
+
+TEST(ImagePickerMasterPlugin, NativeCropKeepsTheRequestedSize) {
+  const JpegCodec* codec = LibjpegCodec();
+  if (!codec) GTEST_SKIP() << "built without libjpeg";
+
+  // 4:2:0, so the lossless path would snap the leading edges out to 16 px.
+  std::string path = std::string(g_get_tmp_dir()) + "/ipm_native_crop.jpg";
+  std::vector<uint8_t> jpeg;
+  ASSERT_TRUE(codec->Encode(make_noise(333, 250, 3), JpegEncodeOptions(),
+                            &jpeg));
+  ASSERT_TRUE(g_file_set_contents(path.c_str(),
+                                  reinterpret_cast<const gchar*>(jpeg.data()),
+                                  static_cast<gssize>(jpeg.size()), nullptr));
+
+  ImagePickerMasterPlugin* plugin = static_cast<ImagePickerMasterPlugin*>(
+      g_object_new(image_picker_master_plugin_get_type(), nullptr));
+  for (int rotation : {0, 90, 180, 270}) {
+    // The crop is given on the image as shown, here at 1:1.
+    const bool quarter_turn = rotation == 90 || rotation == 270;
+    g_autoptr(FlValue) args = fl_value_new_map();
+    fl_value_set_string_take(args, "path", fl_value_new_string(path.c_str()));
+    fl_value_set_string_take(args, "cropX", fl_value_new_float(37));
+    fl_value_set_string_take(args, "cropY", fl_value_new_float(21));
+    fl_value_set_string_take(args, "cropW", fl_value_new_float(101));
+    fl_value_set_string_take(args, "cropH", fl_value_new_float(77));
+    fl_value_set_string_take(args, "containerW",
+                             fl_value_new_float(quarter_turn ? 250 : 333));
+    fl_value_set_string_take(args, "containerH",
+                             fl_value_new_float(quarter_turn ? 333 : 250));
+    fl_value_set_string_take(args, "rotation", fl_value_new_int(rotation));
+    fl_value_set_string_take(args, "maxSize", fl_value_new_int(4096));
+    g_autoptr(FlMethodResponse) response =
+        handle_crop_image_native(args, plugin);
+    ASSERT_TRUE(FL_IS_METHOD_SUCCESS_RESPONSE(response)) << rotation;
+    FlValue* result = fl_method_success_response_get_result(
+        FL_METHOD_SUCCESS_RESPONSE(response));
+    ImageProbe probe;
+    ASSERT_TRUE(ProbeImage(fl_value_get_string(result), &probe)) << rotation;
+    EXPECT_EQ(probe.width, 101) << rotation;
+    EXPECT_EQ(probe.height, 77) << rotation;
+  }
+
+  g_object_unref(plugin);
+  g_remove(path.c_str());
+}
+
+TEST(ImagePickerMasterPlugin, MaxBytesCompressesOnlyWhatIsOver) {
+  std::string path = std::string(g_get_tmp_dir()) + "/ipm_budget_test.png";
+  ImageBuffer noise = make_noise(400, 300, 3);
+  GdkPixbuf* image = gdk_pixbuf_new_from_data(
+      noise.pixels, GDK_COLORSPACE_RGB, FALSE, 8, noise.width, noise.height,
+      noise.stride, nullptr, nullptr);
+  ASSERT_TRUE(gdk_pixbuf_save(image, path.c_str(), "png", nullptr, nullptr));
+  g_object_unref(image);
+
+  ImagePickerMasterPlugin* plugin = static_cast<ImagePickerMasterPlugin*>(
+      g_object_new(image_picker_master_plugin_get_type(), nullptr));
+  WorkerPool pool(2);
+  FileMapOptions options;  // allow_compression stays off
+  options.max_bytes = 30000;
+  g_autoptr(FlValue) list = build_file_list({path}, options, pool, plugin);
+  ASSERT_EQ(fl_value_get_length(list), 1u);
+  FlValue* file = fl_value_get_list_value(list, 0);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(file, "mimeType")),
+               "image/jpeg");
+  EXPECT_LE(fl_value_get_int(fl_value_lookup_string(file, "size")), 30000);
+
+  // A budget the original already meets leaves it alone.
+  options.max_bytes = 64 << 20;
+  g_autoptr(FlValue) untouched = build_file_list({path}, options, pool, plugin);
+  FlValue* original = fl_value_get_list_value(untouched, 0);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(original, "path")),
+               path.c_str());
+
+  // One nothing can meet is a failure, not an over-budget copy.
+  options.max_bytes = 64;
+  g_autoptr(FlValue) unmet = build_file_list({path}, options, pool, plugin);
+  FlValue* picked = fl_value_get_list_value(unmet, 0);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(picked, "path")),
+               path.c_str());
+  g_autoptr(FlValue) args = fl_value_new_map();
+  fl_value_set_string_take(args, "path", fl_value_new_string(path.c_str()));
+  fl_value_set_string_take(args, "cropW", fl_value_new_float(400));
+  fl_value_set_string_take(args, "cropH", fl_value_new_float(300));
+  fl_value_set_string_take(args, "containerW", fl_value_new_float(400));
+  fl_value_set_string_take(args, "containerH", fl_value_new_float(300));
+  fl_value_set_string_take(args, "maxBytes", fl_value_new_int(64));
+  g_autoptr(FlMethodResponse) response =
+      handle_crop_image_native(args, plugin);
+  EXPECT_FALSE(FL_IS_METHOD_SUCCESS_RESPONSE(response));
+
+  g_object_unref(plugin);
+  g_remove(path.c_str());
+}
+
+TEST(ImagePickerMasterPlugin, MaxDimensionsScaleDownKeepingAspect) {
+  std::string path = std::string(g_get_tmp_dir()) + "/ipm_fit_test.png";
+  ImageBuffer gradient = make_gradient(400, 300, 3);
+  GdkPixbuf* image = gdk_pixbuf_new_from_data(
+      gradient.pixels, GDK_COLORSPACE_RGB, FALSE, 8, gradient.width,
+      gradient.height, gradient.stride, nullptr, nullptr);
+  ASSERT_TRUE(gdk_pixbuf_save(image, path.c_str(), "png", nullptr, nullptr));
+  g_object_unref(image);
+
+  ImagePickerMasterPlugin* plugin = static_cast<ImagePickerMasterPlugin*>(
+      g_object_new(image_picker_master_plugin_get_type(), nullptr));
+  WorkerPool pool(2);
+  auto picked_size = [&](const FileMapOptions& options, int* width,
+                         int* height) {
+    g_autoptr(FlValue) list = build_file_list({path}, options, pool, plugin);
+    FlValue* file = fl_value_get_list_value(list, 0);
+    ImageProbe probe;
+    ASSERT_TRUE(ProbeImage(
+        fl_value_get_string(fl_value_lookup_string(file, "path")), &probe));
+    *width  = probe.width;
+    *height = probe.height;
+  };
+
+  int width = 0, height = 0;
+  FileMapOptions options;  // allow_compression stays off
+  options.max_width = 100;
+  picked_size(options, &width, &height);
+  EXPECT_EQ(width, 100);
+  EXPECT_EQ(height, 75);
+
+  options = FileMapOptions();
+  options.max_height = 150;
+  options.max_pixels = 3000;  // the tighter of the two wins
+  picked_size(options, &width, &height);
+  EXPECT_EQ(width, 63);
+  EXPECT_EQ(height, 47);
+
+  // Limits the original already meets leave it alone.
+  options = FileMapOptions();
+  options.max_width  = 400;
+  options.max_height = 300;
+  g_autoptr(FlValue) untouched = build_file_list({path}, options, pool, plugin);
+  FlValue* original = fl_value_get_list_value(untouched, 0);
+  EXPECT_STREQ(fl_value_get_string(fl_value_lookup_string(original, "path")),
+               path.c_str());
+
+  g_object_unref(plugin);
+  g_remove(path.c_str());
+}
+
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBHEIF
+// Writes |pixels| (RGB) to |path| as HEIC, or AVIF when libheif has no HEVC
+// encoder, with one thumbnail |thumbnail_size| px on its long edge. False
+// when libheif can encode neither.
+bool write_heif(const std::string& path, const ImageBuffer& pixels,
+                int thumbnail_size) {
+  heif_context* context = heif_context_alloc();
+  heif_encoder* encoder = nullptr;
+  if (heif_context_get_encoder_for_format(context, heif_compression_HEVC,
+                                          &encoder).code != heif_error_Ok &&
+      heif_context_get_encoder_for_format(context, heif_compression_AV1,
+                                          &encoder).code != heif_error_Ok) {
+    heif_context_free(context);
+    return false;
+  }
+  heif_encoder_set_lossy_quality(encoder, 90);
+
+  heif_image* image = nullptr;
+  heif_image_create(pixels.width, pixels.height, heif_colorspace_RGB,
+                    heif_chroma_interleaved_RGB, &image);
+  heif_image_add_plane(image, heif_channel_interleaved, pixels.width,
+                       pixels.height, 8);
+  int stride = 0;
+  uint8_t* plane = heif_image_get_plane(image, heif_channel_interleaved,
+                                        &stride);
+  for (int y = 0; y < pixels.height; y++) {
+    memcpy(plane + y * stride, pixels.row(y), pixels.width * 3);
+  }
+
+  heif_image_handle* handle = nullptr;
+  bool ok = heif_context_encode_image(context, image, encoder, nullptr,
+                                      &handle).code == heif_error_Ok &&
+            heif_context_encode_thumbnail(context, image, handle, encoder,
+                                          nullptr, thumbnail_size,
+                                          nullptr).code == heif_error_Ok &&
+            heif_context_write_to_file(context, path.c_str()).code ==
+                heif_error_Ok;
+  if (handle) heif_image_handle_release(handle);
+  heif_image_release(image);
+  heif_encoder_release(encoder);
+  heif_context_free(context);
+  return ok;
+}
+#endif
+
+TEST(HeifDecoder, ProbesAndDecodesTheSmallestCoveringImage) {
+  if (!HeifDecodeAvailable()) GTEST_SKIP() << "built without libheif";
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBHEIF
+  std::string path = std::string(g_get_tmp_dir()) + "/ipm_heif_test.heic";
+  ImageBuffer src = make_gradient(480, 320, 3);
+  if (!write_heif(path, src, 160)) {
+    GTEST_SKIP() << "libheif has no HEVC or AV1 encoder";
+  }
+
+  ImageProbe probe;
+  ASSERT_TRUE(ProbeHeif(path, &probe));
+  EXPECT_TRUE(IsHeifFormat(probe.format));
+  EXPECT_EQ(probe.width, 480);
+  EXPECT_EQ(probe.height, 320);
+  EXPECT_FALSE(probe.has_alpha);
+
+  // Larger than the thumbnail: the primary image.
+  ImageBuffer full;
+  ASSERT_TRUE(DecodeHeif(path, 200, 100, &full));
+  ASSERT_EQ(full.width, 480);
+  ASSERT_EQ(full.height, 320);
+  EXPECT_LT(mean_abs_error(src, full), 4.0);
+
+  // Covered by the thumbnail: only the thumbnail is decoded.
+  ImageBuffer small;
+  ASSERT_TRUE(DecodeHeif(path, 120, 80, &small));
+  EXPECT_EQ(small.width, 160);
+  ImageBuffer thumbnail;
+  ASSERT_TRUE(DecodeHeifThumbnail(path, &thumbnail));
+  EXPECT_EQ(thumbnail.width, 160);
+  EXPECT_EQ(thumbnail.height, small.height);
+  g_remove(path.c_str());
+#endif
+
+  // Anything that is not ISO BMFF never reaches libheif.
+  std::string png = std::string(g_get_tmp_dir()) + "/ipm_heif_test.png";
+  GdkPixbuf* image = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, 8, 8);
+  gdk_pixbuf_fill(image, 0);
+  ASSERT_TRUE(gdk_pixbuf_save(image, png.c_str(), "png", nullptr, nullptr));
+  g_object_unref(image);
+  ImageProbe not_heif;
+  ImageBuffer none;
+  EXPECT_FALSE(ProbeHeif(png, &not_heif));
+  EXPECT_FALSE(DecodeHeif(png, 0, 0, &none));
+  g_remove(png.c_str());
+}
+
+// Every pixel distinct enough that a misplaced sample shows up.
+ImageBuffer make_pattern(int w, int h) {
+  ImageBuffer buffer = ImageBuffer::Allocate(w, h, 3);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      uint8_t* p = buffer.row(y) + x * 3;
+      p[0] = static_cast<uint8_t>(x * 5);
+      p[1] = static_cast<uint8_t>(y * 7);
+      p[2] = static_cast<uint8_t>(x * 3 + y * 11);
+    }
+  }
+  return buffer;
+}
+
+TEST(ImageTransform, QuarterTurnsMatchGdkRotateSimple) {
+  const int w = 37, h = 23;
+  ImageBuffer src = make_pattern(w, h);
+  GdkPixbuf* pixbuf = gdk_pixbuf_new_from_data(
+      src.pixels, GDK_COLORSPACE_RGB, FALSE, 8, w, h, src.stride,
+      nullptr, nullptr);
+  const PixelRect crop{5, 3, 20, 14};
+  GdkPixbuf* sub = gdk_pixbuf_new_subpixbuf(pixbuf, crop.x, crop.y,
+                                            crop.width, crop.height);
+
+  const std::pair<int, GdkPixbufRotation> turns[] = {
+      {0, GDK_PIXBUF_ROTATE_NONE},
+      {90, GDK_PIXBUF_ROTATE_COUNTERCLOCKWISE},
+      {180, GDK_PIXBUF_ROTATE_UPSIDEDOWN},
+      {270, GDK_PIXBUF_ROTATE_CLOCKWISE}};
+  for (const auto& [degrees, rotation] : turns) {
+    bool quarter = degrees == 90 || degrees == 270;
+    CropRotateScaleSpec spec;
+    spec.origin_x   = crop.x;
+    spec.origin_y   = crop.y;
+    spec.rotation   = degrees;
+    spec.out_width  = quarter ? crop.height : crop.width;
+    spec.out_height = quarter ? crop.width : crop.height;
+    ImageBuffer ours = CropRotateScale(src, spec);
+
+    GdkPixbuf* expected = gdk_pixbuf_rotate_simple(sub, rotation);
+    ASSERT_EQ(ours.width, gdk_pixbuf_get_width(expected));
+    ASSERT_EQ(ours.height, gdk_pixbuf_get_height(expected));
+    const guchar* e = gdk_pixbuf_get_pixels(expected);
+    int e_stride = gdk_pixbuf_get_rowstride(expected);
+    for (int y = 0; y < ours.height; y++) {
+      ASSERT_EQ(0, memcmp(ours.row(y), e + y * e_stride, ours.width * 3))
+          << "rotation " << degrees << ", row " << y;
+    }
+    g_object_unref(expected);
+  }
+  g_object_unref(sub);
+  g_object_unref(pixbuf);
+}
+
+TEST(ImageTransform, HalvingAveragesEachBlock) {
+  ImageBuffer src = make_pattern(16, 12);
+  CropRotateScaleSpec spec;
+  spec.origin_x   = 2;
+  spec.origin_y   = 4;
+  spec.step_x     = 2;
+  spec.step_y     = 2;
+  spec.rotation   = 180;
+  spec.out_width  = 6;
+  spec.out_height = 4;
+  ImageBuffer out = CropRotateScale(src, spec);
+  ASSERT_EQ(out.width, 6);
+  ASSERT_EQ(out.height, 4);
+
+  for (int v = 0; v < 4; v++) {
+    for (int u = 0; u < 6; u++) {
+      const uint8_t* got = out.row(3 - v) + (5 - u) * 3;
+      for (int c = 0; c < 3; c++) {
+        int sum = 0;
+        for (int dy = 0; dy < 2; dy++) {
+          for (int dx = 0; dx < 2; dx++) {
+            sum += src.row(4 + v * 2 + dy)[(2 + u * 2 + dx) * 3 + c];
+          }
+        }
+        // 2× goes through the separable resampler, whose 8-bit
+        // intermediate row can add one more step of rounding.
+        EXPECT_NEAR(got[c], sum / 4.0, 1.0) << u << "," << v << " ch " << c;
+      }
+    }
+  }
+}
+
+bool same_pixels(const ImageBuffer& a, const ImageBuffer& b) {
+  if (a.width != b.width || a.height != b.height) return false;
+  for (int y = 0; y < a.height; y++) {
+    if (memcmp(a.row(y), b.row(y), a.width * a.channels) != 0) return false;
+  }
+  return true;
+}
+
+TEST(ImageResampler, EveryIsaMatchesScalar) {
+  const ResampleFilter filters[] = {ResampleFilter::kArea,
+                                    ResampleFilter::kLanczos3};
+  const std::pair<int, int> sizes[] = {{100, 77}, {33, 390}, {1030, 700}};
+  for (int channels : {3, 4}) {
+    ImageBuffer src = make_noise(517, 389, channels);
+    for (ResampleFilter filter : filters) {
+      for (const auto& [w, h] : sizes) {
+        ImageBuffer scalar = Resample(src, w, h, filter, ResampleIsa::kScalar);
+        EXPECT_TRUE(same_pixels(scalar, Resample(src, w, h, filter,
+                                                 ResampleIsa::kSse2)));
+        EXPECT_TRUE(same_pixels(scalar, Resample(src, w, h, filter,
+                                                 ResampleIsa::kAvx2)));
+      }
+    }
+  }
+}
+
+TEST(ImageResampler, FlatImageStaysFlat) {
+  ImageBuffer src = ImageBuffer::Allocate(300, 200, 3);
+  memset(src.pixels, 137, 300 * 200 * 3);
+  for (ResampleFilter filter :
+       {ResampleFilter::kArea, ResampleFilter::kLanczos3}) {
+    ImageBuffer out = Resample(src, 37, 23, filter);
+    ASSERT_EQ(out.width, 37);
+    ASSERT_EQ(out.height, 23);
+    for (int y = 0; y < out.height; y++) {
+      for (int x = 0; x < out.width * 3; x++) ASSERT_EQ(out.row(y)[x], 137);
+    }
+  }
+}
+
+TEST(ImageResampler, RegionRotationMatchesUnrotated) {
+  ImageBuffer src = make_noise(200, 150, 3);
+  CropRotateScaleSpec spec;
+  spec.origin_x   = 13.5;
+  spec.origin_y   = 7;
+  spec.step_x     = 2.5;
+  spec.step_y     = 2.5;
+  spec.out_width  = 50;
+  spec.out_height = 40;
+  ImageBuffer upright = ResampleRegion(src, spec, ResampleFilter::kLanczos3);
+
+  spec.rotation   = 90;
+  spec.out_width  = 40;
+  spec.out_height = 50;
+  ImageBuffer turned = ResampleRegion(src, spec, ResampleFilter::kLanczos3);
+  for (int v = 0; v < 40; v++) {
+    for (int u = 0; u < 50; u++) {
+      // gdk COUNTERCLOCKWISE: (u, v) lands on (v, width - 1 - u).
+      ASSERT_EQ(0, memcmp(turned.row(49 - u) + v * 3, upright.row(v) + u * 3, 3))
+          << u << "," << v;
+    }
+  }
+}
+
+TEST(ImageResampler, StripesMatchSingleThread) {
+  WorkerPool pool(4);
+  ImageBuffer src = make_noise(900, 700, 3);
+  CropRotateScaleSpec spec;
+  spec.origin_x = 10;
+  spec.origin_y = 20;
+  spec.step_x   = 3.3;
+  spec.step_y   = 2.7;
+  for (int rotation : {0, 90, 270}) {
+    bool quarter    = rotation != 0 && rotation != 180;
+    spec.rotation   = rotation;
+    spec.out_width  = quarter ? 200 : 250;
+    spec.out_height = quarter ? 250 : 200;
+    for (ResampleFilter filter :
+         {ResampleFilter::kArea, ResampleFilter::kLanczos3}) {
+      EXPECT_TRUE(same_pixels(
+          ResampleRegion(src, spec, filter),
+          ResampleRegion(src, spec, filter, ResampleIsa::kAuto, &pool)))
+          << "rotation " << rotation;
+    }
+  }
+}
+
+// The stored pixels of an upright |display| image tagged with EXIF
+// |orientation|, built from the tag's definition (where stored row 0 and
+// column 0 end up), independently of ExifOrientationTransform.
+ImageBuffer store_with_orientation(const ImageBuffer& display, int orientation) {
+  const int w = display.width, h = display.height;
+  const bool swapped = orientation >= 5;
+  ImageBuffer stored =
+      ImageBuffer::Allocate(swapped ? h : w, swapped ? w : h, display.channels);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      int sx, sy;
+      switch (orientation) {
+        case 2:  sx = w - 1 - x; sy = y;         break;
+        case 3:  sx = w - 1 - x; sy = h - 1 - y; break;
+        case 4:  sx = x;         sy = h - 1 - y; break;
+        case 5:  sx = y;         sy = x;         break;
+        case 6:  sx = y;         sy = w - 1 - x; break;
+        case 7:  sx = h - 1 - y; sy = w - 1 - x; break;
+        case 8:  sx = h - 1 - y; sy = x;         break;
+        default: sx = x;         sy = y;         break;
+      }
+      memcpy(stored.row(sy) + sx * 3, display.row(y) + x * 3, 3);
+    }
+  }
+  return stored;
+}
+
+TEST(ImageTransform, ExifOrientationsTurnUpright) {
+  ImageBuffer upright = make_pattern(29, 17);
+  for (int orientation = 1; orientation <= 8; orientation++) {
+    ImageBuffer stored = store_with_orientation(upright, orientation);
+    CropRotateScaleSpec spec;
+    ExifOrientationTransform(orientation, &spec.rotation, &spec.mirror);
+    spec.out_width  = upright.width;
+    spec.out_height = upright.height;
+    EXPECT_TRUE(same_pixels(CropRotateScale(stored, spec), upright))
+        << "orientation " << orientation;
+  }
+}
+
+TEST(ImageResampler, RegionMirrorMatchesUnmirrored) {
+  ImageBuffer src = make_noise(200, 150, 3);
+  CropRotateScaleSpec spec;
+  spec.origin_x   = 13.5;
+  spec.origin_y   = 7;
+  spec.step_x     = 2.5;
+  spec.step_y     = 2.5;
+  spec.out_width  = 50;
+  spec.out_height = 40;
+  ImageBuffer plain = ResampleRegion(src, spec, ResampleFilter::kLanczos3);
+
+  spec.mirror = true;
+  for (int rotation : {0, 90, 180, 270}) {
+    bool quarter    = rotation == 90 || rotation == 270;
+    spec.rotation   = rotation;
+    spec.out_width  = quarter ? 40 : 50;
+    spec.out_height = quarter ? 50 : 40;
+    ImageBuffer turned = ResampleRegion(src, spec, ResampleFilter::kLanczos3);
+    for (int v = 0; v < 40; v++) {
+      for (int u = 0; u < 50; u++) {
+        int m = 49 - u, i, j;  // mirrored column, then the turn
+        switch (rotation) {
+          case 90:  i = v;      j = 49 - m; break;
+          case 180: i = 49 - m; j = 39 - v; break;
+          case 270: i = 39 - v; j = m;      break;
+          default:  i = m;      j = v;      break;
+        }
+        ASSERT_EQ(0, memcmp(turned.row(j) + i * 3, plain.row(v) + u * 3, 3))
+            << "rotation " << rotation << " at " << u << "," << v;
+      }
+    }
+  }
+}
+
+// Writes |bytes| bytes to the file the cache expects for |key|.
+void write_preview(const PreviewCache& cache, const PreviewKey& key,
+                   size_t bytes) {
+  std::string data(bytes, 'x');
+  ASSERT_TRUE(g_file_set_contents(cache.PathFor(key).c_str(), data.data(),
+                                  static_cast<gssize>(data.size()), nullptr));
+}
+
+TEST(SizeBudget, FindsTheLargestEncodeThatFits) {
+  // A gradient with some grain, so size falls steadily with quality.
+  ImageBuffer src = make_gradient(320, 240, 3);
+  std::mt19937 rng(7);
+  for (int y = 0; y < src.height; y++) {
+    for (int x = 0; x < src.width * 3; x++) {
+      src.row(y)[x] = static_cast<uint8_t>(
+          std::min(255, src.row(y)[x] + static_cast<int>(rng() % 24)));
+    }
+  }
+  const JpegCodec& codec = DefaultJpegCodec();
+  BudgetEncoder encode = [&](const ImageBuffer& pixels, int quality,
+                             std::vector<uint8_t>* out) {
+    JpegEncodeOptions options;
+    options.quality = quality;
+    return codec.Encode(pixels, options, out);
+  };
+  auto size_at = [&](const ImageBuffer& pixels, int quality) {
+    std::vector<uint8_t> out;
+    EXPECT_TRUE(encode(pixels, quality, &out));
+    return out.size();
+  };
+
+  SizeBudget budget;
+  budget.max_quality = 85;
+  budget.min_quality = 40;
+  const size_t at_max = size_at(src, 85);
+  const size_t at_min = size_at(src, 40);
+
+  // Already fits: one encode at the requested quality.
+  budget.max_bytes = at_max;
+  std::vector<uint8_t> out;
+  BudgetResult result;
+  ASSERT_TRUE(EncodeWithinBudget(src, budget, encode, nullptr, &out, &result));
+  EXPECT_EQ(result.quality, 85);
+  EXPECT_EQ(result.trials, 1);
+  EXPECT_EQ(out.size(), at_max);
+
+  // In between: the highest quality that fits, the same with parallel
+  // trials.
+  budget.max_bytes = (at_max + at_min) / 2;
+  ASSERT_TRUE(EncodeWithinBudget(src, budget, encode, nullptr, &out, &result));
+  EXPECT_LE(out.size(), budget.max_bytes);
+  EXPECT_EQ(result.width, 320);
+  EXPECT_GT(size_at(src, result.quality + 1), budget.max_bytes);
+  WorkerPool pool(4);
+  BudgetResult parallel;
+  std::vector<uint8_t> parallel_out;
+  ASSERT_TRUE(EncodeWithinBudget(src, budget, encode, &pool, &parallel_out,
+                                 &parallel));
+  EXPECT_EQ(parallel.quality, result.quality);
+  EXPECT_EQ(parallel_out, out);
+
+  // Below min_quality at full size: shrinks, keeping the aspect ratio.
+  budget.max_bytes = at_min / 3;
+  ASSERT_TRUE(EncodeWithinBudget(src, budget, encode, &pool, &out, &result));
+  EXPECT_LE(out.size(), budget.max_bytes);
+  EXPECT_LT(result.width, 320);
+  EXPECT_NEAR(result.height, result.width * 3 / 4, 1);
+
+  // Impossible: the smallest attempt, at min_edge, is still handed back.
+  budget.max_bytes = 64;
+  EXPECT_FALSE(EncodeWithinBudget(src, budget, encode, &pool, &out, &result));
+  EXPECT_FALSE(out.empty());
+}
+
+TEST(PreviewCache, KeyChangesWithSourceAndSize) {
+  PreviewCache cache("/tmp", 1 << 20);
+  PreviewKey key{"/photos/a.jpg", 1000, 5000, 1024};
+  EXPECT_EQ(cache.PathFor(key), cache.PathFor(key));
+
+  PreviewKey edited = key;
+  edited.mtime_ns++;
+  PreviewKey smaller = key;
+  smaller.max_size = 512;
+  PreviewKey quick = key;
+  quick.thumbnail = true;
+  EXPECT_NE(cache.PathFor(key), cache.PathFor(edited));
+  EXPECT_NE(cache.PathFor(key), cache.PathFor(smaller));
+  EXPECT_NE(cache.PathFor(key), cache.PathFor(quick));
+}
+
+TEST(PreviewCache, EvictsLeastRecentlyUsedOverBudget) {
+  g_autofree gchar* dir = g_dir_make_tmp("ipm_preview_XXXXXX", nullptr);
+  ASSERT_NE(dir, nullptr);
+  PreviewCache cache(dir, 250);
+  PreviewKey a{"/a.jpg", 1, 1, 1024};
+  PreviewKey b{"/b.jpg", 1, 1, 1024};
+  PreviewKey c{"/c.jpg", 1, 1, 1024};
+
+  write_preview(cache, a, 100);
+  cache.Insert(a, 100);
+  write_preview(cache, b, 100);
+  cache.Insert(b, 100);
+
+  std::string path;
+  ASSERT_TRUE(cache.Lookup(a, &path));  // a is now the most recent
+  EXPECT_EQ(path, cache.PathFor(a));
+
+  write_preview(cache, c, 100);
+  cache.Insert(c, 100);  // 300 > 250: b goes
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_EQ(cache.total_bytes(), 200u);
+  EXPECT_FALSE(cache.Lookup(b, &path));
+  EXPECT_FALSE(g_file_test(cache.PathFor(b).c_str(), G_FILE_TEST_EXISTS));
+  EXPECT_TRUE(cache.Lookup(a, &path));
+  EXPECT_TRUE(cache.Lookup(c, &path));
+
+  // A preview deleted behind the cache's back is a miss, not a stale hit.
+  g_remove(cache.PathFor(c).c_str());
+  EXPECT_FALSE(cache.Lookup(c, &path));
+
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_FALSE(g_file_test(cache.PathFor(a).c_str(), G_FILE_TEST_EXISTS));
+  g_rmdir(dir);
+}
+
+TEST(DecodedImageCache, MatchesStampAndMinimumSize) {
+  DecodedImageCache cache(1 << 20);
+  SourceStamp stamp{1000, 5000};
+  cache.Insert("/a.jpg", stamp,
+               DecodedImage{ImageBuffer::Allocate(200, 100, 3), 1600, 800});
+
+  DecodedImage hit;
+  EXPECT_TRUE(cache.Lookup("/a.jpg", stamp, 200, 100, &hit));
+  EXPECT_EQ(hit.pixels.width, 200);
+  EXPECT_EQ(hit.source_width, 1600);
+  EXPECT_FALSE(cache.Lookup("/a.jpg", stamp, 400, 200, &hit));  // too small
+  EXPECT_FALSE(cache.Lookup("/b.jpg", stamp, 1, 1, &hit));
+
+  // A changed file drops its stale entry.
+  EXPECT_FALSE(cache.Lookup("/a.jpg", SourceStamp{1001, 5000}, 1, 1, &hit));
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(DecodedImageCache, EvictsByBytesAndReleases) {
+  const uint64_t entry = 100 * 100 * 3;
+  DecodedImageCache cache(entry * 2);
+  SourceStamp stamp{1, 1};
+  DecodedImage image{ImageBuffer::Allocate(100, 100, 3), 100, 100};
+  cache.Insert("/a", stamp, image);
+  cache.Insert("/b", stamp, image);
+
+  DecodedImage hit;
+  ASSERT_TRUE(cache.Lookup("/a", stamp, 1, 1, &hit));  // /b is now oldest
+  cache.Insert("/c", stamp, image);
+  EXPECT_EQ(cache.total_bytes(), entry * 2);
+  EXPECT_FALSE(cache.Lookup("/b", stamp, 1, 1, &hit));
+  EXPECT_TRUE(cache.Lookup("/a", stamp, 1, 1, &hit));
+
+  EXPECT_TRUE(cache.Release("/a"));
+  EXPECT_FALSE(cache.Release("/a"));
+  EXPECT_FALSE(cache.Lookup("/a", stamp, 1, 1, &hit));
+  EXPECT_EQ(cache.size(), 1u);
+
+  // Evicted buffers stay valid for whoever still holds them.
+  EXPECT_EQ(hit.pixels.width, 100);
+}
+
+TEST(MappedFile, MapsWholeFileAndEmptyFiles) {
+  g_autofree gchar* dir = g_dir_make_tmp("ipm_mapped_XXXXXX", nullptr);
+  ASSERT_NE(dir, nullptr);
+  std::string path = std::string(dir) + "/data.bin";
+  std::string empty_path = std::string(dir) + "/empty.bin";
+
+  std::vector<uint8_t> data(20000);  // spans several pages
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>(i * 31 + (i >> 8));
+  }
+  ASSERT_TRUE(g_file_set_contents(path.c_str(),
+                                  reinterpret_cast<const gchar*>(data.data()),
+                                  static_cast<gssize>(data.size()), nullptr));
+  ASSERT_TRUE(g_file_set_contents(empty_path.c_str(), "", 0, nullptr));
+
+  std::unique_ptr<MappedFile> file = MappedFile::Open(path);
+  ASSERT_NE(file, nullptr);
+  ASSERT_EQ(file->size(), data.size());
+  EXPECT_EQ(memcmp(file->data(), data.data(), data.size()), 0);
+
+  // Only the kernel's readahead differs.
+  std::unique_ptr<MappedFile> headers =
+      MappedFile::Open(path, MappedFile::Access::kHeaders);
+  ASSERT_NE(headers, nullptr);
+  ASSERT_EQ(headers->size(), data.size());
+  EXPECT_EQ(memcmp(headers->data(), data.data(), data.size()), 0);
+
+  std::unique_ptr<MappedFile> empty = MappedFile::Open(empty_path);
+  ASSERT_NE(empty, nullptr);
+  EXPECT_EQ(empty->size(), 0u);
+
+  EXPECT_EQ(MappedFile::Open(std::string(dir) + "/missing.bin"), nullptr);
+  EXPECT_EQ(MappedFile::Open(dir), nullptr);  // not a regular file
+
+  g_remove(path.c_str());
+  g_remove(empty_path.c_str());
+  g_rmdir(dir);
+}
+
+TEST(ChunkedFileReader, ReadsEveryChunkInAnyOrder) {
+  g_autofree gchar* dir = g_dir_make_tmp("ipm_chunks_XXXXXX", nullptr);
+  ASSERT_NE(dir, nullptr);
+  std::string path = std::string(dir) + "/data.bin";
+  std::vector<uint8_t> data(10000);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>(i * 7 + (i >> 9));
+  }
+  ASSERT_TRUE(g_file_set_contents(path.c_str(),
+                                  reinterpret_cast<const gchar*>(data.data()),
+                                  static_cast<gssize>(data.size()), nullptr));
+
+  std::unique_ptr<ChunkedFileReader> reader =
+      ChunkedFileReader::Open(path, 4096);
+  ASSERT_NE(reader, nullptr);
+  EXPECT_EQ(reader->size(), 10000);
+  ASSERT_EQ(reader->chunk_count(), 3u);  // 4096 + 4096 + 1808
+
+  // Workers may finish out of order; each chunk stands on its own.
+  std::vector<uint8_t> joined(data.size());
+  for (size_t index : {2u, 0u, 1u}) {
+    std::vector<uint8_t> chunk;
+    ASSERT_TRUE(reader->ReadChunk(index, &chunk));
+    EXPECT_EQ(chunk.size(), index == 2 ? 1808u : 4096u);
+    memcpy(joined.data() + index * 4096, chunk.data(), chunk.size());
+  }
+  EXPECT_EQ(joined, data);
+
+  std::vector<uint8_t> chunk;
+  EXPECT_FALSE(reader->ReadChunk(3, &chunk));
+  EXPECT_EQ(ChunkedFileReader::Open(path, 0), nullptr);
+  EXPECT_EQ(ChunkedFileReader::Open(dir, 4096), nullptr);
+
+  reader.reset();
+  g_remove(path.c_str());
+  g_rmdir(dir);
+}
+
+void put16be(std::vector<uint8_t>& v, uint16_t x) {
+  v.push_back(static_cast<uint8_t>(x >> 8));
+  v.push_back(static_cast<uint8_t>(x));
+}
+
+void put32be(std::vector<uint8_t>& v, uint32_t x) {
+  put16be(v, static_cast<uint16_t>(x >> 16));
+  put16be(v, static_cast<uint16_t>(x));
+}
+
+void put16le(std::vector<uint8_t>& v, uint16_t x) {
+  v.push_back(static_cast<uint8_t>(x));
+  v.push_back(static_cast<uint8_t>(x >> 8));
+}
+
+void put32le(std::vector<uint8_t>& v, uint32_t x) {
+  put16le(v, static_cast<uint16_t>(x));
+  put16le(v, static_cast<uint16_t>(x >> 16));
+}
+
+void put(std::vector<uint8_t>& v, const char* bytes, size_t n) {
+  v.insert(v.end(), bytes, bytes + n);
+}
+
+// Just enough of each format for a header probe; no pixel data.
+std::vector<uint8_t> jpeg_header(int w, int h, size_t exif_bytes) {
+  std::vector<uint8_t> v = {0xFF, 0xD8, 0xFF, 0xE1};
+  put16be(v, static_cast<uint16_t>(exif_bytes + 2));
+  v.resize(v.size() + exif_bytes, 0);
+  put(v, "\xFF\xFF\xC2", 3);  // fill byte, then progressive SOF2
+  put16be(v, 17);
+  v.push_back(8);
+  put16be(v, static_cast<uint16_t>(h));
+  put16be(v, static_cast<uint16_t>(w));
+  v.resize(v.size() + 10, 0);
+  return v;
+}
+
+std::vector<uint8_t> png_header(int w, int h, int color_type, bool trns) {
+  std::vector<uint8_t> v;
+  put(v, "\x89PNG\r\n\x1a\n", 8);
+  put32be(v, 13);
+  put(v, "IHDR", 4);
+  put32be(v, w);
+  put32be(v, h);
+  v.push_back(8);
+  v.push_back(static_cast<uint8_t>(color_type));
+  v.resize(v.size() + 3 + 4, 0);  // rest of IHDR, CRC
+  if (trns) {
+    put32be(v, 6);
+    put(v, "tRNS", 4);
+    v.resize(v.size() + 6 + 4, 0);
+  }
+  put32be(v, 0);
+  put(v, "IDAT", 4);
+  return v;
+}
+
+TEST(ImageProbe, ReadsEachFormatHeader) {
+  ImageProbe probe;
+  std::vector<uint8_t> jpeg = jpeg_header(4000, 3000, 20000);
+  ASSERT_TRUE(ProbeImageData(jpeg.data(), jpeg.size(), &probe));
+  EXPECT_EQ(probe.format, "jpeg");
+  EXPECT_EQ(probe.width, 4000);
+  EXPECT_EQ(probe.height, 3000);
+  EXPECT_FALSE(probe.has_alpha);
+
+  std::vector<uint8_t> png = png_header(640, 480, 2, true);
+  ASSERT_TRUE(ProbeImageData(png.data(), png.size(), &probe));
+  EXPECT_EQ(probe.format, "png");
+  EXPECT_EQ(probe.width, 640);
+  EXPECT_EQ(probe.height, 480);
+  EXPECT_TRUE(probe.has_alpha);  // RGB with a tRNS key colour
+  png = png_header(64, 32, 2, false);
+  ASSERT_TRUE(ProbeImageData(png.data(), png.size(), &probe));
+  EXPECT_FALSE(probe.has_alpha);
+
+  std::vector<uint8_t> gif;
+  put(gif, "GIF89a", 6);
+  put16le(gif, 10);
+  put16le(gif, 20);
+  put(gif, "\x80\x00\x00", 3);  // 2-entry global colour table
+  gif.resize(gif.size() + 6, 0);
+  put(gif, "\x21\xF9\x04\x01\x00\x00\x00\x00\x2C", 9);
+  ASSERT_TRUE(ProbeImageData(gif.data(), gif.size(), &probe));
+  EXPECT_EQ(probe.format, "gif");
+  EXPECT_EQ(probe.width, 10);
+  EXPECT_EQ(probe.height, 20);
+  EXPECT_TRUE(probe.has_alpha);
+
+  std::vector<uint8_t> bmp;
+  put(bmp, "BM", 2);
+  bmp.resize(14, 0);
+  put32le(bmp, 124);          // BITMAPV5HEADER
+  put32le(bmp, 300);
+  put32le(bmp, static_cast<uint32_t>(-200));  // top-down
+  put16le(bmp, 1);
+  put16le(bmp, 32);
+  put32le(bmp, 3);            // BI_BITFIELDS
+  bmp.resize(14 + 40, 0);
+  put32le(bmp, 0x00FF0000);
+  put32le(bmp, 0x0000FF00);
+  put32le(bmp, 0x000000FF);
+  put32le(bmp, 0xFF000000);   // alpha mask
+  bmp.resize(14 + 124, 0);
+  ASSERT_TRUE(ProbeImageData(bmp.data(), bmp.size(), &probe));
+  EXPECT_EQ(probe.format, "bmp");
+  EXPECT_EQ(probe.width, 300);
+  EXPECT_EQ(probe.height, 200);
+  EXPECT_TRUE(probe.has_alpha);
+
+  std::vector<uint8_t> webp;
+  put(webp, "RIFF\0\0\0\0WEBPVP8X\x0A\0\0\0\x10\0\0\0", 24);
+  put(webp, "\x7F\x07\x00\x37\x04\x00", 6);  // 1920 x 1080
+  ASSERT_TRUE(ProbeImageData(webp.data(), webp.size(), &probe));
+  EXPECT_EQ(probe.format, "webp");
+  EXPECT_EQ(probe.width, 1920);
+  EXPECT_EQ(probe.height, 1080);
+  EXPECT_TRUE(probe.has_alpha);
+
+  webp.resize(12);
+  put(webp, "VP8 \0\0\0\0\0\0\0\x9D\x01\x2A", 14);
+  put16le(webp, 800);
+  put16le(webp, 600);
+  ASSERT_TRUE(ProbeImageData(webp.data(), webp.size(), &probe));
+  EXPECT_EQ(probe.width, 800);
+  EXPECT_EQ(probe.height, 600);
+  EXPECT_FALSE(probe.has_alpha);
+
+  webp.resize(12);
+  put(webp, "VP8L\0\0\0\0\x2F", 9);
+  put32le(webp, (99u) | (49u << 14) | (1u << 28));  // 100 x 50, alpha
+  webp.resize(webp.size() + 8, 0);  // start of the bitstream
+  ASSERT_TRUE(ProbeImageData(webp.data(), webp.size(), &probe));
+  EXPECT_EQ(probe.width, 100);
+  EXPECT_EQ(probe.height, 50);
+  EXPECT_TRUE(probe.has_alpha);
+
+  std::vector<uint8_t> tiff;
+  put(tiff, "MM\0*", 4);
+  put32be(tiff, 8);
+  put16be(tiff, 3);
+  put(tiff, "\x01\x00\x00\x03\x00\x00\x00\x01\x01\x2C\x00\x00", 12);  // 300
+  put(tiff, "\x01\x01\x00\x04\x00\x00\x00\x01\x00\x00\x00\xC8", 12);  // 200
+  put(tiff, "\x01\x52\x00\x03\x00\x00\x00\x01\x00\x02\x00\x00", 12);  // alpha
+  ASSERT_TRUE(ProbeImageData(tiff.data(), tiff.size(), &probe));
+  EXPECT_EQ(probe.format, "tiff");
+  EXPECT_EQ(probe.width, 300);
+  EXPECT_EQ(probe.height, 200);
+  EXPECT_TRUE(probe.has_alpha);
+}
+
+TEST(ImageProbe, EstimatesJpegQualityFromTables) {
+  const JpegCodec& codec = DefaultJpegCodec();
+  ImageBuffer src = make_gradient(64, 48, 3);
+  for (int quality : {5, 30, 60, 75, 90, 98, 100}) {
+    JpegEncodeOptions encode;
+    encode.quality = quality;
+    std::vector<uint8_t> jpeg;
+    ASSERT_TRUE(codec.Encode(src, encode, &jpeg));
+    ImageProbe probe;
+    ASSERT_TRUE(ProbeImageData(jpeg.data(), jpeg.size(), &probe));
+    EXPECT_NEAR(probe.quality, quality, 1) << "quality " << quality;
+  }
+
+  // No DQT before the frame header: unknown.
+  std::vector<uint8_t> bare = jpeg_header(640, 480, 0);
+  ImageProbe probe;
+  ASSERT_TRUE(ProbeImageData(bare.data(), bare.size(), &probe));
+  EXPECT_EQ(probe.quality, 0);
+}
+
+TEST(ImageProbe, RejectsTruncatedAndUnknownData) {
+  ImageProbe probe;
+  std::vector<uint8_t> jpeg = jpeg_header(4000, 3000, 20000);
+  jpeg.resize(10000);  // SOF lies past the end
+  EXPECT_FALSE(ProbeImageData(jpeg.data(), jpeg.size(), &probe));
+  std::vector<uint8_t> png = png_header(640, 480, 6, false);
+  EXPECT_FALSE(ProbeImageData(png.data(), 20, &probe));
+  const uint8_t text[] = "just some text, not an image";
+  EXPECT_FALSE(ProbeImageData(text, sizeof(text), &probe));
+}
+
+// A TIFF structure laid out the way cameras write it: IFD0 (Make,
+// Orientation, ExifIFD pointer), the Exif IFD (ExposureTime,
+// DateTimeOriginal) and IFD1 pointing at a JPEG thumbnail, each IFD
+// followed by its out-of-line values.
+constexpr uint32_t kThumbnailAt = 144;
+constexpr uint32_t kThumbnailLength = 16;
+
+std::vector<uint8_t> camera_tiff(bool little_endian, int orientation) {
+  std::vector<uint8_t> v;
+  auto p16 = [&](uint32_t x) {
+    little_endian ? put16le(v, static_cast<uint16_t>(x))
+                  : put16be(v, static_cast<uint16_t>(x));
+  };
+  auto p32 = [&](uint32_t x) { little_endian ? put32le(v, x) : put32be(v, x); };
+  auto entry = [&](uint16_t tag, uint16_t type, uint32_t count,
+                   uint32_t value) {
+    p16(tag);
+    p16(type);
+    p32(count);
+    if (type == 3) {  // a SHORT sits in the first half of the value field
+      p16(value);
+      p16(0);
+    } else {
+      p32(value);
+    }
+  };
+
+  put(v, little_endian ? "II*\0" : "MM\0*", 4);
+  p32(8);
+  p16(3);                                   // IFD0 at 8
+  entry(0x010F, 2, 6, 50);                  // Make
+  entry(0x0112, 3, 1, orientation);
+  entry(0x8769, 4, 1, 56);                  // Exif IFD
+  p32(114);                                 // IFD1
+  put(v, "Canon\0", 6);                     // 50
+  p16(2);                                   // Exif IFD at 56
+  entry(0x829A, 5, 1, 86);                  // ExposureTime
+  entry(0x9003, 2, 20, 94);                 // DateTimeOriginal
+  p32(0);
+  p32(1);                                   // 86: 1/250 s
+  p32(250);
+  put(v, "2024:05:17 09:41:03\0", 20);      // 94
+  p16(2);                                   // IFD1 at 114
+  entry(0x0201, 4, 1, kThumbnailAt);
+  entry(0x0202, 4, 1, kThumbnailLength);
+  p32(0);
+  put(v, "\xFF\xD8", 2);                    // 144: the thumbnail
+  v.resize(v.size() + kThumbnailLength - 4, 0);
+  put(v, "\xFF\xD9", 2);
+  return v;
+}
+
+// |tiff| in a JPEG's APP1 segment, behind a JFIF APP0 as phones write it.
+// Sets |tiff_at| to the TIFF header's file offset.
+std::vector<uint8_t> jpeg_with_exif(const std::vector<uint8_t>& tiff,
+                                    size_t* tiff_at) {
+  std::vector<uint8_t> v = {0xFF, 0xD8, 0xFF, 0xE0};
+  put16be(v, 16);
+  put(v, "JFIF\0", 5);
+  v.resize(v.size() + 9, 0);
+  put(v, "\xFF\xE1", 2);
+  put16be(v, static_cast<uint16_t>(2 + 6 + tiff.size()));
+  put(v, "Exif\0\0", 6);
+  *tiff_at = v.size();
+  v.insert(v.end(), tiff.begin(), tiff.end());
+  put(v, "\xFF\xDA", 2);
+  put16be(v, 8);
+  v.resize(v.size() + 6, 0);
+  return v;
+}
+
+TEST(ExifParser, ReadsCameraLayoutInBothByteOrders) {
+  for (bool little_endian : {true, false}) {
+    std::vector<uint8_t> tiff = camera_tiff(little_endian, 6);
+    size_t tiff_at = 0;
+    std::vector<uint8_t> jpeg = jpeg_with_exif(tiff, &tiff_at);
+
+    ExifInfo exif;
+    ASSERT_TRUE(ParseExif(jpeg.data(), jpeg.size(), &exif));
+    EXPECT_EQ(exif.orientation, 6);
+    EXPECT_STREQ(exif.date_time_original, "2024:05:17 09:41:03");
+    EXPECT_EQ(exif.thumbnail_offset, tiff_at + kThumbnailAt);
+    EXPECT_EQ(exif.thumbnail_length, kThumbnailLength);
+    EXPECT_EQ(jpeg[exif.thumbnail_offset], 0xFF);
+    EXPECT_EQ(jpeg[exif.thumbnail_offset + 1], 0xD8);
+
+    // A TIFF file is its own EXIF block.
+    ExifInfo from_tiff;
+    ASSERT_TRUE(ParseExif(tiff.data(), tiff.size(), &from_tiff));
+    EXPECT_EQ(from_tiff.orientation, 6);
+    EXPECT_EQ(from_tiff.thumbnail_offset, kThumbnailAt);
+  }
+
+  // Out-of-range orientations are ignored; JPEGs without APP1 have no EXIF.
+  std::vector<uint8_t> tiff = camera_tiff(true, 9);
+  ExifInfo exif;
+  ASSERT_TRUE(ParseExif(tiff.data(), tiff.size(), &exif));
+  EXPECT_EQ(exif.orientation, 1);
+  std::vector<uint8_t> plain = jpeg_header(640, 480, 0);
+  EXPECT_FALSE(ParseExif(plain.data(), plain.size(), &exif));
+}
+
+TEST(ExifParser, SurvivesTruncationAndCorruption) {
+  size_t tiff_at = 0;
+  const std::vector<uint8_t> jpeg =
+      jpeg_with_exif(camera_tiff(false, 8), &tiff_at);
+  auto check = [](const std::vector<uint8_t>& data) {
+    // An exactly sized heap copy, so any overread is caught by ASan.
+    std::unique_ptr<uint8_t[]> copy(new uint8_t[data.size() + 1]);
+    if (!data.empty()) memcpy(copy.get(), data.data(), data.size());
+    ExifInfo exif;
+    if (!ParseExif(copy.get(), data.size(), &exif)) return;
+    ASSERT_GE(exif.orientation, 1);
+    ASSERT_LE(exif.orientation, 8);
+    size_t date = strlen(exif.date_time_original);
+    ASSERT_TRUE(date == 0 || date == 19);
+    ASSERT_LE(exif.thumbnail_offset + exif.thumbnail_length, data.size());
+  };
+
+  for (size_t n = 0; n <= jpeg.size(); n++) {
+    check(std::vector<uint8_t>(jpeg.begin(), jpeg.begin() + n));
+  }
+
+  // Random byte and bit damage, concentrated on the TIFF structure where
+  // offsets and counts live.
+  std::mt19937 rng(20240517);
+  for (int round = 0; round < 20000; round++) {
+    std::vector<uint8_t> damaged = jpeg;
+    int edits = 1 + static_cast<int>(rng() % 4);
+    for (int e = 0; e < edits; e++) {
+      size_t at = tiff_at + rng() % (damaged.size() - tiff_at);
+      if (rng() % 2) {
+        damaged[at] = static_cast<uint8_t>(rng());
+      } else {
+        damaged[at] ^= static_cast<uint8_t>(1u << (rng() % 8));
+      }
+    }
+    check(damaged);
+  }
+}
+
 }  // namespace test
 }  // namespace image_picker_master
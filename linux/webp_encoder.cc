@@ -0,0 +1,81 @@
+#include "webp_encoder.h"
+
+#include <algorithm>
+
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBWEBP
+#include <webp/encode.h>
+#endif
+
+namespace image_picker_master {
+
+#ifdef IMAGE_PICKER_MASTER_HAVE_LIBWEBP
+
+namespace {
+
+// WebPWriterFunction appending straight to the std::vector in custom_ptr,
+// so the encoded bytes are not copied out of a WebPMemoryWriter afterwards.
+int append_to_vector(const uint8_t* data, size_t size,
+                     const WebPPicture* picture) {
+  auto* out = static_cast<std::vector<uint8_t>*>(picture->custom_ptr);
+  out->insert(out->end(), data, data + size);
+  return 1;
+}
+
+}  // namespace
+
+bool WebpEncoderAvailable() { return true; }
+
+bool EncodeWebp(const ImageBuffer& pixels,
+                const WebpEncodeOptions& options,
+                std::vector<uint8_t>* out) {
+  out->clear();
+  if (pixels.empty() || (pixels.channels != 3 && pixels.channels != 4)) {
+    return false;
+  }
+
+  WebPConfig config;
+  if (!WebPConfigInit(&config)) return false;
+  config.lossless      = options.lossless ? 1 : 0;
+  config.quality       = static_cast<float>(std::clamp(options.quality, 0, 100));
+  config.method        = std::clamp(options.method, 0, 6);
+  config.thread_level  = options.multithreaded ? 1 : 0;
+  config.alpha_quality = 100;
+  if (!WebPValidateConfig(&config)) return false;
+
+  WebPPicture picture;
+  if (!WebPPictureInit(&picture)) return false;
+  picture.width    = pixels.width;
+  picture.height   = pixels.height;
+  // Lossless encodes from ARGB; importing straight into it skips a YUV
+  // round trip.
+  picture.use_argb = options.lossless ? 1 : 0;
+  int imported = pixels.channels == 4
+      ? WebPPictureImportRGBA(&picture, pixels.pixels, pixels.stride)
+      : WebPPictureImportRGB(&picture, pixels.pixels, pixels.stride);
+  if (!imported) {
+    WebPPictureFree(&picture);
+    return false;
+  }
+
+  picture.writer     = append_to_vector;
+  picture.custom_ptr = out;
+  bool ok = WebPEncode(&config, &picture) != 0;
+  WebPPictureFree(&picture);
+  if (!ok) out->clear();
+  return ok;
+}
+
+#else  // !IMAGE_PICKER_MASTER_HAVE_LIBWEBP
+
+bool WebpEncoderAvailable() { return false; }
+
+bool EncodeWebp(const ImageBuffer& /*pixels*/,
+                const WebpEncodeOptions& /*options*/,
+                std::vector<uint8_t>* out) {
+  out->clear();
+  return false;
+}
+
+#endif  // IMAGE_PICKER_MASTER_HAVE_LIBWEBP
+
+}  // namespace image_picker_master
@@ -0,0 +1,34 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_WEBP_ENCODER_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_WEBP_ENCODER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "image_buffer.h"
+
+namespace image_picker_master {
+
+struct WebpEncodeOptions {
+  bool lossless = false;
+  // 0-100. Lossy: visual quality. Lossless: how hard to squeeze (output is
+  // always exact).
+  int quality = 85;
+  // Encoder effort 0 (fastest) - 6 (smallest file).
+  int method = 4;
+  // Let libwebp split the analysis and entropy passes across two threads.
+  bool multithreaded = true;
+};
+
+// True when the plugin was built against libwebp.
+bool WebpEncoderAvailable();
+
+// Encodes RGB or RGBA |pixels| as WebP into |out|. An alpha channel is
+// kept (losslessly in lossless mode, at full alpha quality otherwise).
+// Returns false without libwebp or on any encoder error.
+bool EncodeWebp(const ImageBuffer& pixels,
+                const WebpEncodeOptions& options,
+                std::vector<uint8_t>* out);
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_WEBP_ENCODER_H_
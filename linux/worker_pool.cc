@@ -0,0 +1,91 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace image_picker_master {
+
+WorkerPool::WorkerPool(size_t thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::thread::hardware_concurrency();
+    if (thread_count == 0) thread_count = 2;  // unknown — assume a small box
+  }
+  threads_.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; i++) {
+    threads_.emplace_back([this]() { Run(); });
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto& t : threads_) t.join();
+}
+
+WorkerPool& WorkerPool::Shared() {
+  static WorkerPool* pool = new WorkerPool();
+  return *pool;
+}
+
+void WorkerPool::Submit(std::function<void()> job) {
+  {
+    std::lock_guard<std::mutex> lk(mutex_);
+    jobs_.push_back(std::move(job));
+  }
+  cv_.notify_one();
+}
+
+void WorkerPool::ParallelFor(size_t count,
+                             const std::function<void(size_t)>& fn) {
+  if (count == 0) return;
+
+  struct LoopState {
+    std::atomic<size_t>     next{0};
+    size_t                  finished = 0;
+    std::mutex              mutex;
+    std::condition_variable cv;
+  };
+  auto state = std::make_shared<LoopState>();
+
+  // Helpers that start after every index has been claimed return without
+  // touching |fn|, so it is fine for them to outlive this call.
+  auto drain = [state, count, &fn]() {
+    size_t done_here = 0;
+    for (size_t i = state->next++; i < count; i = state->next++) {
+      fn(i);
+      done_here++;
+    }
+    if (done_here == 0) return;
+    std::lock_guard<std::mutex> lk(state->mutex);
+    state->finished += done_here;
+    if (state->finished == count) state->cv.notify_all();
+  };
+
+  size_t helpers = std::min(threads_.size(), count) - 1;
+  for (size_t i = 0; i < helpers; i++) Submit(drain);
+  drain();
+
+  std::unique_lock<std::mutex> lk(state->mutex);
+  state->cv.wait(lk, [&]() { return state->finished == count; });
+}
+
+void WorkerPool::Run() {
+  for (;;) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lk(mutex_);
+      cv_.wait(lk, [this]() { return stopping_ || !jobs_.empty(); });
+      if (jobs_.empty()) return;  // stopping and fully drained
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    job();
+  }
+}
+
+}  // namespace image_picker_master
@@ -0,0 +1,56 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_WORKER_POOL_H_
+#define FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_WORKER_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace image_picker_master {
+
+// Fixed-size pool of native worker threads. Decode / resize / encode jobs
+// are queued here so they never block the GTK main loop; jobs run in FIFO
+// order and must marshal any Flutter calls back to the main context
+// themselves.
+class WorkerPool {
+ public:
+  // |thread_count| of 0 uses std::thread::hardware_concurrency().
+  explicit WorkerPool(size_t thread_count = 0);
+
+  // Finishes every queued job, then joins the worker threads.
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // Process-wide pool shared by all plugin instances. Intentionally never
+  // destroyed so that exit-time static destruction cannot join a thread
+  // that is still in the middle of a decode.
+  static WorkerPool& Shared();
+
+  // Queues |job| to run on one of the worker threads.
+  void Submit(std::function<void()> job);
+
+  // Calls |fn(i)| for every i in [0, count) across the pool and returns
+  // once all calls have finished. The calling thread takes part in the
+  // loop, so this is safe to call from a job already running on the pool.
+  void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+  size_t size() const { return threads_.size(); }
+
+ private:
+  void Run();
+
+  std::mutex                        mutex_;
+  std::condition_variable           cv_;
+  std::deque<std::function<void()>> jobs_;
+  bool                              stopping_ = false;
+  std::vector<std::thread>          threads_;
+};
+
+}  // namespace image_picker_master
+
+#endif  // FLUTTER_PLUGIN_IMAGE_PICKER_MASTER_WORKER_POOL_H_
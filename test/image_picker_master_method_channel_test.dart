@@ -1,3 +1,4 @@
+import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 import 'package:flutter_test/flutter_test.dart';
 import 'package:image_picker_master/image_picker_master_method_channel.dart';
@@ -23,4 +24,44 @@ void main() {
   test('getPlatformVersion', () async {
     expect(await platform.getPlatformVersion(), '42');
   });
+
+  group('resizeImageForCropperTiered', () {
+    final calls = <Map<Object?, Object?>>[];
+
+    void answer(String thumbnail, String preview) {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+          .setMockMethodCallHandler(channel, (MethodCall methodCall) async {
+            final arguments = methodCall.arguments as Map<Object?, Object?>;
+            calls.add(arguments);
+            return arguments['tier'] == 'thumbnail' ? thumbnail : preview;
+          });
+    }
+
+    setUp(() {
+      calls.clear();
+      debugDefaultTargetPlatformOverride = TargetPlatform.linux;
+    });
+
+    tearDown(() {
+      debugDefaultTargetPlatformOverride = null;
+    });
+
+    test('asks for the thumbnail first and yields it first', () async {
+      answer('/tmp/thumb.jpg', '/tmp/preview.jpg');
+      final tiers = await platform
+          .resizeImageForCropperTiered(path: '/tmp/photo.jpg')
+          .toList();
+      expect(tiers, ['/tmp/thumb.jpg', '/tmp/preview.jpg']);
+      expect(calls.map((call) => call['tier']).toList(), ['thumbnail', null]);
+    });
+
+    test('yields a preview that is the thumbnail only once', () async {
+      answer('/tmp/preview.jpg', '/tmp/preview.jpg');
+      final tiers = await platform
+          .resizeImageForCropperTiered(path: '/tmp/photo.jpg')
+          .toList();
+      expect(tiers, ['/tmp/preview.jpg']);
+      expect(calls, hasLength(2));
+    });
+  });
 }
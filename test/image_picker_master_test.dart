@@ -1,3 +1,5 @@
+import 'dart:typed_data';
+
 import 'package:flutter_test/flutter_test.dart';
 import 'package:image_picker_master/image_picker_master.dart';
 import 'package:image_picker_master/image_picker_master_method_channel.dart';
@@ -15,6 +17,11 @@ class MockImagePickerMasterPlatform
     required bool allowCompression,
     required int compressionQuality,
     required bool withData,
+    int? maxBytes,
+    int? maxWidth,
+    int? maxHeight,
+    int? maxPixels,
+    JpegEncodeOptions? jpegOptions,
   }) {
     throw UnimplementedError();
   }
@@ -29,6 +36,11 @@ class MockImagePickerMasterPlatform
     throw UnimplementedError();
   }
 
+  @override
+  Stream<PickedFile> pickFilesStream(FilePickerOptions options) {
+    throw UnimplementedError();
+  }
+
   @override
   Future<String?> resizeImageForCropper({
     required String path,
@@ -37,6 +49,37 @@ class MockImagePickerMasterPlatform
     throw UnimplementedError();
   }
 
+  @override
+  Stream<String> resizeImageForCropperTiered({
+    required String path,
+    int maxSize = 1024,
+  }) {
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<bool> releaseImageSession(String path) {
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<List<PickedFile>> getFileDetails(
+    List<String> paths, {
+    Set<FileDetail> fields = const {FileDetail.size, FileDetail.mimeType},
+  }) {
+    throw UnimplementedError();
+  }
+
+  @override
+  Future<List<ProbedImage?>> probeImages(List<String> paths) {
+    throw UnimplementedError();
+  }
+
+  @override
+  Stream<Uint8List> readFileStream(String path, {int chunkSize = 4 << 20}) {
+    throw UnimplementedError();
+  }
+
   @override
   Future<String?> cropImageNative({
     required String path,
@@ -50,6 +93,9 @@ class MockImagePickerMasterPlatform
     int quality = 85,
     String format = 'jpeg',
     int maxSize = 1200,
+    int effort = 4,
+    int? maxBytes,
+    JpegEncodeOptions? jpegOptions,
   }) {
     throw UnimplementedError();
   }